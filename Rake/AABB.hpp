@@ -8,8 +8,12 @@ class AABB {
 	AABB();
 	AABB(const Point3& min, const Point3& max);
 
-	bool Hit(const Ray& ray, double tMin, double tMax) const;
+	bool Hit(const Ray& ray, Real tMin, Real tMax) const;
 	AABB Contain(const AABB& other) const;
+	AABB Contain(const Point3& point) const;
+	Point3 Centroid() const;
+	// Always computed in double precision, as the bounds of unbounded primitives would overflow a float.
+	double SurfaceArea() const;
 
 	Point3 Min;
 	Point3 Max;
@@ -0,0 +1,36 @@
+#include "AliasTable.hpp"
+
+AliasTable::AliasTable(const std::vector<double>& weights) {
+	double total = 0.0;
+	for (const double weight : weights) { total += weight; }
+	if (!(total > 0.0)) { return; }
+
+	// Scale the weights so they average one, then pair each slot left short of one with a slot that has weight to
+	// spare, until every slot is exactly full.
+	const size_t count = weights.size();
+	std::vector<double> scaled(count);
+	std::vector<uint32_t> small;
+	std::vector<uint32_t> large;
+	_slots.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		scaled[i]     = weights[i] * double(count) / total;
+		_slots[i].Pdf = float(weights[i] / total);
+		(scaled[i] < 1.0 ? small : large).push_back(uint32_t(i));
+	}
+
+	while (!small.empty() && !large.empty()) {
+		const uint32_t lacking = small.back();
+		const uint32_t giving  = large.back();
+		small.pop_back();
+		large.pop_back();
+
+		_slots[lacking].Probability = float(scaled[lacking]);
+		_slots[lacking].Alias       = giving;
+		scaled[giving]              = (scaled[giving] + scaled[lacking]) - 1.0;
+		(scaled[giving] < 1.0 ? small : large).push_back(giving);
+	}
+
+	// Whatever is left is full up to rounding error.
+	for (const uint32_t i : large) { _slots[i] = {1.0f, i, _slots[i].Pdf}; }
+	for (const uint32_t i : small) { _slots[i] = {1.0f, i, _slots[i].Pdf}; }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Picks one of a fixed set of outcomes, each with odds proportional to its weight, in constant time no matter how many
+// outcomes there are (Vose's alias method). Every slot of the table holds an outcome of its own and the alias it hands
+// over to for the rest of the slot, so a pick is one random slot and one comparison.
+class AliasTable {
+ public:
+	AliasTable() = default;
+	// Outcomes with a weight of zero are never picked. A table without any positive weight stays empty.
+	explicit AliasTable(const std::vector<double>& weights);
+
+	bool Empty() const {
+		return _slots.empty();
+	}
+	size_t Size() const {
+		return _slots.size();
+	}
+
+	// Picks an outcome from a uniform random number in [0, 1). The slot comes from the integer part of the scaled
+	// number and the choice between it and its alias from what is left over.
+	uint32_t Sample(double u) const {
+		const double scaled = u * double(_slots.size());
+		const uint32_t slot = std::min(uint32_t(scaled), uint32_t(_slots.size() - 1));
+		const Slot& entry   = _slots[slot];
+
+		return scaled - slot < entry.Probability ? slot : entry.Alias;
+	}
+	// The odds of Sample picking an outcome.
+	float GetPdf(uint32_t outcome) const {
+		return _slots[outcome].Pdf;
+	}
+
+ private:
+	struct Slot {
+		float Probability;  // Of keeping this slot's own outcome rather than handing over to the alias.
+		uint32_t Alias;
+		float Pdf;
+	};
+
+	std::vector<Slot> _slots;
+};
@@ -71,7 +71,7 @@ bool BVHNode::Bounds(AABB& outBounds) const {
 	return true;
 }
 
-bool BVHNode::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const {
+bool BVHNode::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
 	if (!_bounds.Hit(ray, tMin, tMax)) { return false; }
 
 	const bool hitLeft  = _left->Hit(ray, tMin, tMax, outRecord);
@@ -79,3 +79,8 @@ bool BVHNode::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord
 
 	return hitLeft || hitRight;
 }
+
+void BVHNode::Hash(Luna::Utility::Hasher& hasher) const {
+	_left->Hash(hasher);
+	if (_right != _left) { _right->Hash(hasher); }
+}
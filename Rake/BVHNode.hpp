@@ -15,7 +15,8 @@ class BVHNode : public IHittable {
 	BVHNode(const std::vector<std::shared_ptr<IHittable>>& srcObjects, size_t start, size_t end);
 
 	virtual bool Bounds(AABB& outBounds) const override;
-	virtual bool Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
 
  private:
 	std::shared_ptr<IHittable> _left;
@@ -3,10 +3,10 @@
 #include "Random.hpp"
 
 Camera::Camera(
-	const Point3& position, const Point3& target, double vFov, double aspectRatio, double aperture, double focusDist) {
+	const Point3& position, const Point3& target, Real vFov, Real aspectRatio, Real aperture, Real focusDist) {
 	const auto theta          = glm::radians(vFov);
-	const auto h              = glm::tan(theta / 2.0);
-	const auto viewportHeight = 2.0 * h;
+	const auto h              = glm::tan(theta / Real(2));
+	const auto viewportHeight = Real(2) * h;
 	const auto viewportWidth  = aspectRatio * viewportHeight;
 
 	_forward         = glm::normalize(position - target);
@@ -15,11 +15,11 @@ Camera::Camera(
 	_origin          = position;
 	_horizontal      = focusDist * viewportWidth * _right;
 	_vertical        = focusDist * viewportHeight * _up;
-	_lowerLeftCorner = _origin - _horizontal / 2.0 - _vertical / 2.0 - focusDist * _forward;
-	_lensRadius      = aperture / 2.0;
+	_lowerLeftCorner = _origin - _horizontal / Real(2) - _vertical / Real(2) - focusDist * _forward;
+	_lensRadius      = aperture / Real(2);
 }
 
-Ray Camera::GetRay(double s, double t) const {
+Ray Camera::GetRay(Real s, Real t) const {
 	const Vector3 rd     = _lensRadius * RandomInUnitDisk();
 	const Vector3 offset = rd.x * _right + rd.y * _up;
 	return Ray(_origin + offset, glm::normalize(_lowerLeftCorner + s * _horizontal + t * _vertical - _origin - offset));
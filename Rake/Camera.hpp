@@ -7,9 +7,9 @@ class Camera {
  public:
 	Camera() = default;
 	Camera(
-		const Point3& position, const Point3& target, double vFov, double aspectRatio, double aperture, double focusDist);
+		const Point3& position, const Point3& target, Real vFov, Real aspectRatio, Real aperture, Real focusDist);
 
-	Ray GetRay(double s, double t) const;
+	Ray GetRay(Real s, Real t) const;
 
  private:
 	Point3 _origin;
@@ -19,5 +19,5 @@ class Camera {
 	Vector3 _forward;
 	Vector3 _right;
 	Vector3 _up;
-	double _lensRadius;
+	Real _lensRadius;
 };
@@ -1,5 +1,7 @@
 #include "CheckerTexture.hpp"
 
+#include <string_view>
+
 #include "SolidTexture.hpp"
 
 CheckerTexture::CheckerTexture(const std::shared_ptr<ITexture>& odd,
@@ -14,3 +16,10 @@ Color CheckerTexture::Sample(const Point2& uv, const Point3& p) const {
 	const auto sines = glm::sin(Scale.x * uv.x) * glm::sin(Scale.y * uv.y);
 	return sines < 0.0 ? Odd->Sample(uv, p) : Even->Sample(uv, p);
 }
+
+void CheckerTexture::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(std::string_view("Checker"));
+	HashTexture(hasher, Odd.get());
+	HashTexture(hasher, Even.get());
+	hasher.Data(sizeof(Scale), &Scale);
+}
@@ -13,6 +13,7 @@ class CheckerTexture : public ITexture {
 	CheckerTexture(const Color& odd, const Color& even, const glm::vec2& scale = glm::vec2(10.0f));
 
 	virtual Color Sample(const Point2& uv, const Point3& p) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
 
 	std::shared_ptr<ITexture> Odd;
 	std::shared_ptr<ITexture> Even;
@@ -0,0 +1,96 @@
+#include "Checkpoint.hpp"
+
+#include <cstring>
+#include <fstream>
+
+#include "Framebuffer.hpp"
+
+namespace {
+constexpr char Magic[8]       = {'R', 'A', 'K', 'E', 'C', 'K', 'P', 'T'};
+constexpr uint32_t Version    = 2;
+constexpr size_t SectionAlign = 64;
+
+size_t AlignSection(size_t offset) {
+	return (offset + SectionAlign - 1) & ~(SectionAlign - 1);
+}
+}  // namespace
+
+struct Checkpoint::Header {
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Scheduler;
+	uint32_t Integrator;
+	uint32_t MaxDepth;
+	uint64_t SceneHash;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t TileSize;
+	uint32_t TileCount;
+	uint32_t SamplesPerPixel;
+	float ErrorThreshold;
+	alignas(8) int64_t SampleBudget;
+};
+
+bool Checkpoint::Open(const std::string& filename, const Key& key, bool& outResumed) {
+	Close();
+
+	_pixelCount       = Framebuffer::GetPixelCount(key.ImageSize);
+	_tilesOffset      = AlignSection(sizeof(Header));
+	_pixelsOffset     = AlignSection(_tilesOffset + sizeof(Tile) * key.TileCount);
+	const size_t size = _pixelsOffset + 2 * _pixelCount * sizeof(glm::vec4);
+	if (!_file.Open(filename, size)) { return false; }
+
+	const Header& existing = *static_cast<const Header*>(_file.GetData());
+	outResumed             = _file.Existed() && std::memcmp(existing.Magic, Magic, sizeof(Magic)) == 0 &&
+	                         existing.Version == Version && existing.Scheduler == key.Scheduler &&
+	                         existing.Integrator == key.Integrator && existing.MaxDepth == key.MaxDepth &&
+	                         existing.SceneHash == key.SceneHash && existing.Width == key.ImageSize.x &&
+	                         existing.Height == key.ImageSize.y && existing.TileSize == key.TileSize &&
+	                         existing.TileCount == key.TileCount && existing.ErrorThreshold == key.ErrorThreshold &&
+	                         (key.ErrorThreshold <= 0.0f || existing.SamplesPerPixel == key.SamplesPerPixel);
+
+	// A file of the right size may still hold some other trace, and that has to be cleared out first.
+	if (!outResumed && _file.Existed() && !_file.Open(filename, size, true)) { return false; }
+
+	Header& header         = *static_cast<Header*>(_file.GetData());
+	header.SamplesPerPixel = key.SamplesPerPixel;
+	if (outResumed) { return true; }
+
+	header.Version        = Version;
+	header.Scheduler      = key.Scheduler;
+	header.Integrator     = key.Integrator;
+	header.MaxDepth       = key.MaxDepth;
+	header.SceneHash      = key.SceneHash;
+	header.Width          = key.ImageSize.x;
+	header.Height         = key.ImageSize.y;
+	header.TileSize       = key.TileSize;
+	header.TileCount      = key.TileCount;
+	header.ErrorThreshold = key.ErrorThreshold;
+	header.SampleBudget   = 0;
+	// The magic goes in last, so a file that was cut short while being set up never looks like a checkpoint.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::memcpy(header.Magic, Magic, sizeof(Magic));
+
+	return true;
+}
+
+void Checkpoint::Close() {
+	_file.Close();
+}
+
+void Checkpoint::Flush() {
+	if (_file.IsOpen()) { _file.Flush(); }
+}
+
+int64_t& Checkpoint::GetSampleBudget() const {
+	return static_cast<Header*>(_file.GetData())->SampleBudget;
+}
+
+uint32_t Checkpoint::ReadTileSize(const std::string& filename) {
+	std::ifstream file(filename, std::ios::binary);
+	Header header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) { return 0; }
+	if (std::memcmp(header.Magic, Magic, sizeof(Magic)) != 0 || header.Version != Version) { return 0; }
+
+	return header.TileSize;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+
+#include "MappedFile.hpp"
+
+// The accumulation state of a trace, kept in a memory-mapped file so a long render can carry on where it left off after
+// the process dies. The file holds a header, the state of every tile and both of the tracer's framebuffers, which the
+// tracer accumulates into directly. Nothing is ever copied in or out of it, so resuming a trace only means mapping the
+// file again.
+//
+// The sampler is counter-based, so the only random number state a trace has is the number of samples each tile took.
+class Checkpoint {
+ public:
+	// Everything a checkpoint has to match to be resumed. Anything else starts it over.
+	struct Key {
+		uint64_t SceneHash       = 0;
+		glm::uvec2 ImageSize     = glm::uvec2(0);
+		uint32_t Scheduler       = 0;
+		uint32_t Integrator      = 0;
+		uint32_t MaxDepth        = 0;
+		uint32_t TileSize        = 0;
+		uint32_t TileCount       = 0;
+		uint32_t SamplesPerPixel = 0;  // Only has to match for adaptive traces, others can take more later.
+		float ErrorThreshold     = 0.0f;
+	};
+
+	struct Tile {
+		uint32_t Samples;
+		uint32_t Flags;
+	};
+	static constexpr uint32_t TileWriting  = 0x1;  // A sample is being added to the tile's pixels.
+	static constexpr uint32_t TileFinished = 0x2;  // The tile took every sample it is going to.
+
+	// Maps the checkpoint file, creating it if need be. Returns false if it could not be mapped, and otherwise sets
+	// outResumed to whether it holds a trace matching key, or was started over.
+	bool Open(const std::string& filename, const Key& key, bool& outResumed);
+	void Close();
+	// Starts writing everything out to disk.
+	void Flush();
+
+	// The tile size of the trace in a checkpoint file, or 0 if there is no valid checkpoint. Traces that pick their
+	// tile size automatically use this to cut the image up the same way as before, however many threads they have now.
+	static uint32_t ReadTileSize(const std::string& filename);
+
+	bool IsOpen() const {
+		return _file.IsOpen();
+	}
+	Tile* GetTiles() const {
+		return reinterpret_cast<Tile*>(static_cast<uint8_t*>(_file.GetData()) + _tilesOffset);
+	}
+	// Alpha of the sum holds each pixel's Welford M2, not opacity.
+	glm::vec4* GetSum() const {
+		return reinterpret_cast<glm::vec4*>(static_cast<uint8_t*>(_file.GetData()) + _pixelsOffset);
+	}
+	glm::vec4* GetAverage() const {
+		return GetSum() + _pixelCount;
+	}
+	// The tracer's adaptive sampling budget, which has to be accessed atomically.
+	int64_t& GetSampleBudget() const;
+
+	// Brackets adding a sample to a tile. The mark is stored before any pixel is touched and cleared after the last one
+	// is, so a tile still marked when the file is opened again was caught halfway through and has to start over.
+	void BeginTileWrite(uint32_t tile) {
+		std::atomic_ref<uint32_t>(GetTiles()[tile].Flags).store(TileWriting, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+	void EndTileWrite(uint32_t tile, uint32_t samples) {
+		std::atomic_ref<uint32_t>(GetTiles()[tile].Samples).store(samples, std::memory_order_relaxed);
+		std::atomic_ref<uint32_t>(GetTiles()[tile].Flags).store(0, std::memory_order_release);
+	}
+	void FinishTile(uint32_t tile) {
+		std::atomic_ref<uint32_t>(GetTiles()[tile].Flags).store(TileFinished, std::memory_order_release);
+	}
+
+ private:
+	struct Header;
+
+	MappedFile _file;
+	size_t _tilesOffset  = 0;
+	size_t _pixelsOffset = 0;
+	size_t _pixelCount   = 0;
+};
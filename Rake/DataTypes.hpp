@@ -1,14 +1,30 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <limits>
 
-using Point2  = glm::dvec2;
-using Vector2 = glm::dvec2;
-using Point3  = glm::dvec3;
-using Vector3 = glm::dvec3;
-using Color3  = glm::dvec3;
+// Scalar type of all geometry. Building with RAKE_SINGLE_PRECISION switches it to float, which halves the size of rays,
+// bounds and hit records in exchange for less precision far away from the origin.
+#ifdef RAKE_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
+
+using Point2  = glm::vec<2, Real>;
+using Vector2 = glm::vec<2, Real>;
+using Point3  = glm::vec<3, Real>;
+using Vector3 = glm::vec<3, Real>;
+using Color3  = glm::vec<3, Real>;
+using Matrix3 = glm::mat<3, 3, Real>;
+using Matrix4 = glm::mat<4, 4, Real>;
 
 using Color = glm::vec3;
 
-constexpr double Infinity = std::numeric_limits<double>::infinity();
-constexpr double Pi       = 3.1415926535897932385;
+constexpr Real Infinity = std::numeric_limits<Real>::infinity();
+constexpr Real Pi       = Real(3.1415926535897932385);
+
+// Rec. 709 relative luminance of a linear color.
+inline float Luminance(const Color& color) {
+	return glm::dot(color, Color(0.2126f, 0.7152f, 0.0722f));
+}
@@ -0,0 +1,68 @@
+#include "DisplayBuffer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "ImageWriter.hpp"
+
+void DisplayBuffer::Reset(const glm::uvec2& imageSize, const std::vector<Tile>& tiles) {
+	_imageSize = imageSize;
+	_tiles.resize(tiles.size());
+	_readySlots = std::vector<std::atomic_uint8_t>(tiles.size());
+
+	size_t offset = 0;
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		const glm::uvec2 size = tiles[i].Max - tiles[i].Min;
+		_tiles[i]             = {tiles[i], offset, 0, 2};
+		_readySlots[i]        = 1;
+		offset               += 3 * size_t(size.x) * size_t(size.y);
+	}
+	_slots.resize(offset);
+	if (tiles.empty()) { _slots.shrink_to_fit(); }
+}
+
+Color* DisplayBuffer::BeginPublish(uint32_t tile) {
+	const auto& slots     = _tiles[tile];
+	const glm::uvec2 size = slots.Bounds.Max - slots.Bounds.Min;
+	const size_t slotSize = size_t(size.x) * size_t(size.y);
+
+	return &_slots[slots.Offset + slots.WriteSlot * slotSize];
+}
+
+void DisplayBuffer::EndPublish(uint32_t tile) {
+	// Swap our freshly written slot with the ready one. Whatever the consumer did not get to yet is simply replaced.
+	auto& slots     = _tiles[tile];
+	const auto old  = _readySlots[tile].exchange(slots.WriteSlot | FreshFlag, std::memory_order_acq_rel);
+	slots.WriteSlot = old & SlotMask;
+}
+
+bool DisplayBuffer::Consume(Color* image, Color* linearImage, uint32_t& outFirstRow, uint32_t& outLastRow) {
+	uint32_t firstRow = std::numeric_limits<uint32_t>::max();
+	uint32_t lastRow  = 0;
+
+	for (size_t i = 0; i < _tiles.size(); ++i) {
+		if (!(_readySlots[i].load(std::memory_order_relaxed) & FreshFlag)) { continue; }
+
+		auto& slots    = _tiles[i];
+		const auto old = _readySlots[i].exchange(slots.ReadSlot, std::memory_order_acq_rel);
+		slots.ReadSlot = old & SlotMask;
+
+		const Tile& bounds      = slots.Bounds;
+		const uint32_t width    = bounds.Max.x - bounds.Min.x;
+		const size_t tilePixels = size_t(width) * (bounds.Max.y - bounds.Min.y);
+		const Color* source     = &_slots[slots.Offset + slots.ReadSlot * tilePixels];
+		for (uint32_t y = bounds.Min.y; y < bounds.Max.y; ++y, source += width) {
+			const size_t row = (size_t(y) * _imageSize.x) + bounds.Min.x;
+			std::transform(source, source + width, image + row, GammaCorrect);
+			if (linearImage) { std::copy(source, source + width, linearImage + row); }
+		}
+		firstRow = std::min(firstRow, bounds.Min.y);
+		lastRow  = std::max(lastRow, bounds.Max.y);
+	}
+
+	if (firstRow >= lastRow) { return false; }
+	outFirstRow = firstRow;
+	outLastRow  = lastRow;
+
+	return true;
+}
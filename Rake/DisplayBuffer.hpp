@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "DataTypes.hpp"
+
+// Copy of an image that is being rendered tile by tile, handed from the render threads to the UI without any locks.
+// Every tile is triple buffered on its own: the thread rendering a tile fills one slot, the UI reads another, and the
+// third holds the newest finished version until the UI takes it. A tile is only ever rendered by one thread at a time, so each tile is a plain single-producer,
+// single-consumer triple buffer.
+class DisplayBuffer {
+ public:
+	struct Tile {
+		glm::uvec2 Min;
+		glm::uvec2 Max;
+	};
+
+	// Must not be called while tiles are being published. Without any tiles, the slots are freed.
+	void Reset(const glm::uvec2& imageSize, const std::vector<Tile>& tiles);
+
+	// Producer side, for the thread currently rendering the tile. The slot holds the tile's linear pixels row by row, and
+	// becomes visible to the consumer once the publish is ended.
+	Color* BeginPublish(uint32_t tile);
+	void EndPublish(uint32_t tile);
+
+	// Consumer side. Copies every tile published since the last call into the full image, gamma corrected, and into the
+	// full linear image as it is if one is given. Returns the range of rows [outFirstRow, outLastRow) that changed, or
+	// false if none did.
+	bool Consume(Color* image, Color* linearImage, uint32_t& outFirstRow, uint32_t& outLastRow);
+
+ private:
+	// The slot most recently published by the producer, and whether the consumer has seen it yet.
+	static constexpr uint8_t SlotMask  = 0x3;
+	static constexpr uint8_t FreshFlag = 0x4;
+
+	struct TileSlots {
+		Tile Bounds;
+		size_t Offset;      // Index of the tile's first slot in _slots.
+		uint8_t WriteSlot;  // Only touched by the producer.
+		uint8_t ReadSlot;   // Only touched by the consumer.
+	};
+
+	glm::uvec2 _imageSize = glm::uvec2(0);
+	std::vector<TileSlots> _tiles;
+	std::vector<std::atomic_uint8_t> _readySlots;
+	std::vector<Color> _slots;
+};
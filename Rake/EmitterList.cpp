@@ -0,0 +1,241 @@
+#include "EmitterList.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "IHittable.hpp"
+#include "IMaterial.hpp"
+#include "ISkyMaterial.hpp"
+#include "Rectangle.hpp"
+#include "Sphere.hpp"
+#include "SphereSet.hpp"
+#include "World.hpp"
+
+namespace {
+// Fraction of 1 - cos of the widest angle between the direction to the center of a sphere and a direction that still
+// hits it, the solid angle the sphere covers over 2 pi. Written so it stays precise for the far away and tiny spheres
+// that make the cone narrow. Returns 0 if the point is inside the sphere.
+Real GetConeSize(const Point3& point, const Point3& center, Real radius) {
+	const Vector3 toCenter = center - point;
+	const Real distance2   = glm::dot(toCenter, toCenter);
+	if (distance2 <= radius * radius) { return 0.0; }
+
+	const Real sin2Max = radius * radius / distance2;
+	const Real cosMax  = glm::sqrt(glm::max(Real(0), 1 - sin2Max));
+
+	return sin2Max / (1 + cosMax);
+}
+
+Real GetArea(const RectanglePool& rectangles, uint32_t index) {
+	const Point2 extent = rectangles.Max[index] - rectangles.Min[index];
+
+	return extent.x * extent.y;
+}
+}  // namespace
+
+void EmitterList::Build(const World& world) {
+	Clear();
+	_world = &world;
+
+	// Pick half of the time by power and half of the time uniformly. Going by power alone would leave the small lights
+	// of a scene with a sun in it with hardly any samples at all.
+	std::vector<float> powers;
+	const auto AddEmitter = [&](const Emitter& emitter, const IMaterial* light, const Point3& center, Real area) {
+		if (light->GetType() != MaterialType::DiffuseLight || !(area > 0.0) || !std::isfinite(area)) { return; }
+		_emitters.push_back(emitter);
+		powers.push_back(Luminance(light->Emit(Point2(0.5), center)) * float(area));
+	};
+
+	// Pooled primitives come before objects and are added in order, so the list comes out sorted.
+	const SpherePool& spheres = world.Spheres;
+	for (uint32_t i = 0; i < spheres.Size(); ++i) {
+		const Real radius = spheres.Radius[i];
+		AddEmitter({PrimitiveID(PrimitiveType::Sphere, i)},
+		           world.Materials.Get(spheres.Material[i]),
+		           spheres.GetCenter(i),
+		           4 * Pi * radius * radius);
+	}
+	const RectanglePool& rectangles = world.Rectangles;
+	for (uint32_t i = 0; i < rectangles.Size(); ++i) {
+		const AABB bounds = rectangles.GetBounds(i);
+		AddEmitter({PrimitiveID(PrimitiveType::Rectangle, i)},
+		           world.Materials.Get(rectangles.Material[i]),
+		           (bounds.Min + bounds.Max) * Real(0.5),
+		           GetArea(rectangles, i));
+	}
+	// Scene files keep their spheres in sphere sets, which is where most of their lights are.
+	const auto& objects = world.Objects.Objects;
+	for (uint32_t i = 0; i < objects.size(); ++i) {
+		const auto* set = dynamic_cast<const SphereSet*>(objects[i].get());
+		if (!set) { continue; }
+		for (uint32_t j = 0; j < set->GetSphereCount(); ++j) {
+			const PackedSphere& sphere = set->GetSphere(j);
+			AddEmitter({PrimitiveID(PrimitiveType::Object, i), j},
+			           set->GetMaterial(j),
+			           Point3(sphere.Center[0], sphere.Center[1], sphere.Center[2]),
+			           4 * Pi * Real(sphere.Radius) * Real(sphere.Radius));
+		}
+	}
+	if (_emitters.empty()) { return; }
+
+	double totalPower = 0.0;
+	for (const float power : powers) { totalPower += power; }
+	const double uniform = totalPower > 0.0 ? 0.5 / _emitters.size() : 1.0 / _emitters.size();
+	const double byPower = totalPower > 0.0 ? 0.5 / totalPower : 0.0;
+	double sum           = 0.0;
+	_cdf.resize(_emitters.size());
+	for (size_t i = 0; i < _emitters.size(); ++i) {
+		sum += uniform + byPower * powers[i];
+		_cdf[i] = float(sum);
+	}
+	_cdf.back() = 1.0f;
+}
+
+void EmitterList::Clear() {
+	_world = nullptr;
+	_emitters.clear();
+	_cdf.clear();
+}
+
+bool EmitterList::Sample(const Point3& point, const double u[4], LightSample& outSample) const {
+	// The first number picks between the sky and the other emitters, and is then stretched back out to pick among them.
+	const Real skyProbability = GetSkyProbability();
+	if (u[0] < skyProbability) {
+		const ISkyMaterial& sky = *_world->Sky;
+		if (!sky.SampleDirection(&u[1], outSample.Direction, outSample.Pdf)) { return false; }
+		outSample.Distance = Infinity;
+		outSample.Radiance = sky.Sample(Ray(point, outSample.Direction));
+		outSample.Pdf *= skyProbability;
+
+		return true;
+	}
+	if (_emitters.empty()) { return false; }
+
+	const double pick    = (u[0] - skyProbability) / (1 - skyProbability);
+	const size_t emitter =
+		std::min(size_t(std::upper_bound(_cdf.begin(), _cdf.end(), float(pick)) - _cdf.begin()), _cdf.size() - 1);
+	HitRecord lightHit;
+	const IMaterial* material;
+	Point3 center;
+	Real radius;
+	if (GetSphere(_emitters[emitter], center, radius, material)) {
+		const Real coneSize = GetConeSize(point, center, glm::abs(radius));
+		if (coneSize <= 0.0) { return false; }
+
+		// Pick a direction uniformly within the cone, around a frame pointing at the center.
+		const Vector3 w      = glm::normalize(center - point);
+		const Vector3 helper = glm::abs(w.x) > 0.9 ? Vector3(0, 1, 0) : Vector3(1, 0, 0);
+		const Vector3 v      = glm::normalize(glm::cross(w, helper));
+		const Vector3 t      = glm::cross(w, v);
+		const Real cosTheta  = 1 - Real(u[1]) * coneSize;
+		const Real sinTheta  = glm::sqrt(glm::max(Real(0), 1 - cosTheta * cosTheta));
+		const Real phi       = 2 * Pi * Real(u[2]);
+		outSample.Direction =
+			glm::normalize(t * (std::cos(phi) * sinTheta) + v * (std::sin(phi) * sinTheta) + w * cosTheta);
+		outSample.Pdf = 1 / (2 * Pi * coneSize);
+
+		// Directions at the very edge of the cone can just miss in finite precision. The closest approach is as good
+		// as a hit for those.
+		const Ray toLight(point, outSample.Direction);
+		Real distance;
+		if (!IntersectSphere(toLight, center, radius, 0, Infinity, distance)) {
+			distance = glm::dot(center - point, outSample.Direction);
+		}
+		SetSphereHit(toLight, center, radius, distance, lightHit);
+		outSample.Distance = distance;
+	} else {
+		const RectanglePool& rectangles = _world->Rectangles;
+		const uint32_t index            = _emitters[emitter].Primitive.GetIndex();
+		int normalAxis, uAxis, vAxis;
+		GetRectangleAxes(rectangles.Plane[index], normalAxis, uAxis, vAxis);
+		const Point2& min = rectangles.Min[index];
+		const Point2& max = rectangles.Max[index];
+		Point3 spot;
+		spot[normalAxis] = rectangles.Offset[index];
+		spot[uAxis]      = min.x + Real(u[1]) * (max.x - min.x);
+		spot[vAxis]      = min.y + Real(u[2]) * (max.y - min.y);
+
+		const Vector3 toSpot = spot - point;
+		const Real distance2 = glm::dot(toSpot, toSpot);
+		const Real distance  = glm::sqrt(distance2);
+		if (!(distance > 0.0)) { return false; }
+		outSample.Direction = toSpot / distance;
+		const Real cosLight = glm::abs(outSample.Direction[normalAxis]);
+		if (cosLight <= 0.0) { return false; }
+		outSample.Pdf = distance2 / (cosLight * GetArea(rectangles, index));
+
+		SetRectangleHit(Ray(point, outSample.Direction), rectangles.Plane[index], distance, lightHit);
+		outSample.Distance = distance;
+		material           = _world->Materials.Get(rectangles.Material[index]);
+	}
+
+	outSample.Radiance = material->Emit(lightHit.UV, lightHit.Point);
+	outSample.Pdf *= GetSelectionPdf(emitter) * (1 - skyProbability);
+
+	return true;
+}
+
+Real EmitterList::Pdf(const Point3& point, const HitRecord& lightHit) const {
+	const PrimitiveID primitive(lightHit.Primitive);
+	const Emitter hit{primitive, primitive.GetType() == PrimitiveType::Object ? lightHit.Part : ~0u};
+	const auto it = std::lower_bound(_emitters.begin(), _emitters.end(), hit);
+	if (it == _emitters.end() || it->Primitive.Value != hit.Primitive.Value || it->Part != hit.Part) { return 0.0; }
+
+	const Real selectionPdf = GetSelectionPdf(size_t(it - _emitters.begin())) * (1 - GetSkyProbability());
+	const IMaterial* material;
+	Point3 center;
+	Real radius;
+	if (GetSphere(*it, center, radius, material)) {
+		const Real coneSize = GetConeSize(point, center, glm::abs(radius));
+
+		return coneSize > 0.0 ? selectionPdf / (2 * Pi * coneSize) : 0.0;
+	}
+
+	const RectanglePool& rectangles = _world->Rectangles;
+	const uint32_t index            = primitive.GetIndex();
+	int normalAxis, uAxis, vAxis;
+	GetRectangleAxes(rectangles.Plane[index], normalAxis, uAxis, vAxis);
+	const Vector3 toSpot = lightHit.Point - point;
+	const Real distance2 = glm::dot(toSpot, toSpot);
+	const Real cosLight  = glm::abs(toSpot[normalAxis]) / glm::sqrt(distance2);
+	if (!(cosLight > 0.0)) { return 0.0; }
+
+	return selectionPdf * distance2 / (cosLight * GetArea(rectangles, index));
+}
+
+Real EmitterList::GetSkyPdf(const Vector3& direction) const {
+	const Real skyProbability = GetSkyProbability();
+
+	return skyProbability > 0.0 ? skyProbability * _world->Sky->Pdf(direction) : 0.0;
+}
+
+bool EmitterList::GetSphere(const Emitter& emitter,
+                            Point3& outCenter,
+                            Real& outRadius,
+                            const IMaterial*& outMaterial) const {
+	const uint32_t index = emitter.Primitive.GetIndex();
+	switch (emitter.Primitive.GetType()) {
+		case PrimitiveType::Sphere: {
+			const SpherePool& spheres = _world->Spheres;
+			outCenter                 = spheres.GetCenter(index);
+			outRadius                 = spheres.Radius[index];
+			outMaterial               = _world->Materials.Get(spheres.Material[index]);
+			return true;
+		}
+		case PrimitiveType::Object: {
+			// Only sphere sets put objects in the list.
+			const auto& set            = static_cast<const SphereSet&>(*_world->Objects.Objects[index]);
+			const PackedSphere& sphere = set.GetSphere(emitter.Part);
+			outCenter                  = Point3(sphere.Center[0], sphere.Center[1], sphere.Center[2]);
+			outRadius                  = sphere.Radius;
+			outMaterial                = set.GetMaterial(emitter.Part);
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+bool EmitterList::HasSky() const {
+	return _world && _world->Sky && _world->Sky->IsImportanceSampled();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include "DataTypes.hpp"
+#include "PrimitivePool.hpp"
+
+struct HitRecord;
+class IMaterial;
+class World;
+
+// Light arriving at a point from a spot picked on one of the emitters, or from the sky.
+struct LightSample {
+	Vector3 Direction;  // Unit vector from the point towards the light.
+	Real Distance;      // Along Direction, to the spot on the light. Infinity for the sky.
+	Color Radiance;     // Emitted by the light towards the point.
+	Real Pdf;           // Solid-angle density of Direction, including the odds of picking this emitter.
+};
+
+// The pooled primitives and the spheres of sphere sets in a world with a light material, for integrators to sample
+// light from directly instead of waiting for paths to stumble onto them. Spheres are sampled within the cone they cover
+// as seen from the point, and rectangles by area. Other emissive objects, such as meshes, are not in the list and are
+// only ever found by scattering.
+// A sky that can be importance sampled gets half of the samples, or all of them if there are no other emitters.
+class EmitterList {
+ public:
+	void Build(const World& world);
+	void Clear();
+
+	bool Empty() const {
+		return _emitters.empty() && !HasSky();
+	}
+	size_t Size() const {
+		return _emitters.size();
+	}
+
+	// Picks an emitter and a spot on it as seen from point, or a direction towards the sky, using the four uniform
+	// random numbers in u. Returns false if nothing could be sampled, such as when the point lies inside the light it
+	// picked.
+	bool Sample(const Point3& point, const double u[4], LightSample& outSample) const;
+	// The density with which Sample picks the direction from point to a hit on a light, or 0 for anything that is not
+	// in the list.
+	Real Pdf(const Point3& point, const HitRecord& lightHit) const;
+	// The density with which Sample picks a direction towards the sky.
+	Real GetSkyPdf(const Vector3& direction) const;
+
+ private:
+	// A pooled primitive, or a sphere of the sphere set that is the object Primitive refers to.
+	struct Emitter {
+		PrimitiveID Primitive;
+		uint32_t Part = ~0u;  // Index of the sphere in the set, unset for pooled primitives.
+
+		bool operator<(const Emitter& other) const {
+			if (Primitive.Value != other.Primitive.Value) { return Primitive.Value < other.Primitive.Value; }
+			return Part < other.Part;
+		}
+	};
+
+	// The center, radius and material of an emitter that is a sphere. Returns false for rectangles.
+	bool GetSphere(const Emitter& emitter, Point3& outCenter, Real& outRadius, const IMaterial*& outMaterial) const;
+
+	// The sky is looked up through the world every time, so it can be swapped without building the list again.
+	bool HasSky() const;
+	Real GetSkyProbability() const {
+		return HasSky() ? (_emitters.empty() ? 1.0 : 0.5) : 0.0;
+	}
+	Real GetSelectionPdf(size_t emitter) const {
+		return _cdf[emitter] - (emitter > 0 ? _cdf[emitter - 1] : 0.0f);
+	}
+
+	const World* _world = nullptr;
+	std::vector<Emitter> _emitters;  // Sorted, so the emitter a ray hit can be looked up.
+	std::vector<float> _cdf;         // Running total of the odds of picking each emitter.
+};
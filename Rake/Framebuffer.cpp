@@ -0,0 +1,47 @@
+#include "Framebuffer.hpp"
+
+#include <Luna/Utility/Memory.hpp>
+#include <algorithm>
+#include <memory>
+
+// Every tile is a whole number of cache lines, so they all start on one as long as the allocation does.
+constexpr size_t CacheLineSize = 64;
+static_assert(sizeof(glm::vec4) == 16, "Framebuffer pixels must be 16 bytes!");
+static_assert(Framebuffer::TilePixels * sizeof(glm::vec4) % CacheLineSize == 0, "Tiles must fill whole cache lines!");
+
+Framebuffer::Framebuffer(const glm::uvec2& size) {
+	Reset(size);
+}
+
+void Framebuffer::Reset(const glm::uvec2& size, const glm::vec4& value) {
+	_size   = size;
+	_tilesX = (size.x + TileSize - 1) / TileSize;
+	const size_t pixelCount = GetPixelCount(size);
+	if (pixelCount != _pixelCount) {
+		_pixels.reset(static_cast<glm::vec4*>(Luna::Utility::AlignedAlloc(pixelCount * sizeof(glm::vec4), CacheLineSize)));
+		if (pixelCount > 0 && !_pixels) { throw std::bad_alloc(); }
+		_pixelCount = pixelCount;
+	}
+	std::uninitialized_fill_n(_pixels.get(), pixelCount, value);
+	_data = _pixels.get();
+}
+
+void Framebuffer::Attach(const glm::uvec2& size, glm::vec4* pixels) {
+	_size   = size;
+	_tilesX = (size.x + TileSize - 1) / TileSize;
+	_pixels.reset();
+	_pixelCount = 0;
+	_data       = pixels;
+}
+
+void Framebuffer::AlignedDeleter::operator()(glm::vec4* pixels) const {
+	Luna::Utility::AlignedFree(pixels);
+}
+
+void Framebuffer::CopyTo(std::vector<Color>& outPixels) const {
+	outPixels.resize(size_t(_size.x) * _size.y);
+	for (uint32_t y = 0; y < _size.y; ++y) {
+		Color* row = &outPixels[size_t(y) * _size.x];
+		for (uint32_t x = 0; x < _size.x; ++x) { row[x] = Color(_data[GetIndex(x, y)]); }
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+#include "DataTypes.hpp"
+
+// An RGBA float image stored as 16x16 pixel tiles, with the pixels of each tile in Morton order. Every aligned square
+// of 2^n pixels within a tile is then contiguous in memory as well, so threads working on neighbouring aligned 4x4, 8x8
+// or 16x16 regions (or multiples of 16x16) of the image write to separate cache lines, as long as the pixels start on a
+// cache line, which both the framebuffer's own allocation and checkpoints see to. Regions that are not such squares,
+// like tiles of any other size or the shared queue's 10-line bands, still share the cache lines along their edges.
+// Pixels are 16 bytes each, and so never straddle a cache line. Only exporting and uploading need the image in
+// row-major order, which CopyTo converts to.
+//
+// The pixels are normally owned by the framebuffer, but it can also be pointed at memory owned by someone else, such as
+// a memory-mapped checkpoint file, so a trace can accumulate straight into it.
+class Framebuffer {
+ public:
+	static constexpr uint32_t TileSize   = 16;
+	static constexpr uint32_t TilePixels = TileSize * TileSize;
+
+	Framebuffer() = default;
+	explicit Framebuffer(const glm::uvec2& size);
+	Framebuffer(const Framebuffer&) = delete;
+
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	// Resizes the image and clears every pixel to value.
+	void Reset(const glm::uvec2& size, const glm::vec4& value = glm::vec4(0.0f));
+	// Uses GetPixelCount(size) pixels of memory at pixels as the image, as they are. The memory must be 16-byte aligned
+	// and outlive the framebuffer, or at least the next Reset or Attach.
+	void Attach(const glm::uvec2& size, glm::vec4* pixels);
+
+	// Number of pixels an image of the given size takes up, including the padding of partial tiles.
+	static size_t GetPixelCount(const glm::uvec2& size) {
+		return size_t((size.x + TileSize - 1) / TileSize) * ((size.y + TileSize - 1) / TileSize) * TilePixels;
+	}
+
+	const glm::uvec2& GetSize() const {
+		return _size;
+	}
+
+	glm::vec4& operator()(uint32_t x, uint32_t y) {
+		return _data[GetIndex(x, y)];
+	}
+	const glm::vec4& operator()(uint32_t x, uint32_t y) const {
+		return _data[GetIndex(x, y)];
+	}
+
+	// Writes the RGB channels out as a row-major image. Alpha is dropped, as the tracer keeps Welford's M2 there rather
+	// than opacity.
+	void CopyTo(std::vector<Color>& outPixels) const;
+
+ private:
+	size_t GetIndex(uint32_t x, uint32_t y) const {
+		const size_t tile = size_t(y / TileSize) * _tilesX + (x / TileSize);
+		return tile * TilePixels + MortonIndex(x % TileSize, y % TileSize);
+	}
+
+	// Interleave the bits of x and y, with x in the even bits.
+	static uint32_t MortonIndex(uint32_t x, uint32_t y) {
+		const auto Spread = [](uint32_t v) {
+			v = (v | (v << 2)) & 0x33;
+			v = (v | (v << 1)) & 0x55;
+			return v;
+		};
+		return Spread(x) | (Spread(y) << 1);
+	}
+
+	struct AlignedDeleter {
+		void operator()(glm::vec4* pixels) const;
+	};
+
+	glm::uvec2 _size = glm::uvec2(0);
+	uint32_t _tilesX = 0;
+	glm::vec4* _data = nullptr;  // Either _pixels.get() or memory we were attached to.
+	std::unique_ptr<glm::vec4[], AlignedDeleter> _pixels;
+	size_t _pixelCount = 0;  // Size of _pixels, which is kept when the image is reset to the same number of tiles.
+};
@@ -0,0 +1,90 @@
+#include "FramebufferBenchmark.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Framebuffer.hpp"
+
+using Luna::Log;
+
+namespace {
+const glm::uvec2 ImageSize(1920, 1080);
+constexpr uint32_t Passes = 64;
+
+// Small tiles dealt out round-robin, so every tile's neighbours belong to other threads. This is the worst case for
+// false sharing, where tile edges land in the middle of cache lines shared with other threads.
+constexpr uint32_t BenchmarkTileSize = 8;
+
+template <typename AccumulateFunc>
+double Measure(uint32_t threadCount, AccumulateFunc&& accumulate) {
+	const uint32_t tilesX = (ImageSize.x + BenchmarkTileSize - 1) / BenchmarkTileSize;
+	const uint32_t tilesY = (ImageSize.y + BenchmarkTileSize - 1) / BenchmarkTileSize;
+	std::atomic_uint32_t ready = 0;
+
+	const auto Worker = [&](uint32_t threadIndex) {
+		++ready;
+		while (ready < threadCount) { std::this_thread::yield(); }
+
+		for (uint32_t pass = 0; pass < Passes; ++pass) {
+			const Color sample(float(pass & 1), 0.5f, 0.25f);
+			for (uint32_t tile = threadIndex; tile < tilesX * tilesY; tile += threadCount) {
+				const glm::uvec2 min = glm::uvec2(tile % tilesX, tile / tilesX) * BenchmarkTileSize;
+				const glm::uvec2 max = glm::min(min + BenchmarkTileSize, ImageSize);
+				for (uint32_t y = min.y; y < max.y; ++y) {
+					for (uint32_t x = min.x; x < max.x; ++x) { accumulate(x, y, sample); }
+				}
+			}
+		}
+	};
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < threadCount; ++i) { threads.emplace_back(Worker, i); }
+	for (auto& thread : threads) { thread.join(); }
+	const auto end = std::chrono::steady_clock::now();
+
+	const double pixelWrites = double(ImageSize.x) * ImageSize.y * Passes;
+	return pixelWrites / std::chrono::duration<double>(end - start).count();
+}
+
+void Report(const char* name, double pixelsPerSecond, size_t bytesPerPixel) {
+	Log::Info("Benchmark",
+	          "{:<10} {:>8.1f} Mpixels/s, {:>6.2f} GB/s",
+	          name,
+	          pixelsPerSecond / 1e6,
+	          pixelsPerSecond * bytesPerPixel / 1e9);
+}
+}  // namespace
+
+int RunFramebufferBenchmark(uint32_t threadCount) {
+	if (threadCount == 0) { threadCount = std::max(std::thread::hardware_concurrency(), 1u); }
+	Log::Info("Benchmark",
+	          "Accumulating {} passes over {}x{} pixels on {} threads, in {}x{} tiles dealt out round-robin.",
+	          Passes,
+	          ImageSize.x,
+	          ImageSize.y,
+	          threadCount,
+	          BenchmarkTileSize,
+	          BenchmarkTileSize);
+
+	std::vector<Color> rowMajor(size_t(ImageSize.x) * ImageSize.y, Color(0.0f));
+	const double rowMajorRate = Measure(threadCount, [&](uint32_t x, uint32_t y, const Color& sample) {
+		rowMajor[size_t(y) * ImageSize.x + x] += sample;
+	});
+
+	Framebuffer tiled(ImageSize);
+	const double tiledRate = Measure(threadCount, [&](uint32_t x, uint32_t y, const Color& sample) {
+		tiled(x, y) += glm::vec4(sample, 0.0f);
+	});
+
+	// Both are read and written once per sample.
+	Report("Row-major", rowMajorRate, 2 * sizeof(Color));
+	Report("Tiled", tiledRate, 2 * sizeof(glm::vec4));
+	Log::Info("Benchmark", "Tiled layout writes {:.2f}x as many pixels per second.", tiledRate / rowMajorRate);
+
+	return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// Times render threads accumulating into their own tiles of a shared image, once with the tiled Framebuffer and once
+// with a plain row-major array of colors, and logs the write bandwidth of both. Returns the process exit code.
+int RunFramebufferBenchmark(uint32_t threadCount);
@@ -0,0 +1,252 @@
+#include "Headless.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <Luna/Utility/Time.hpp>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "FramebufferBenchmark.hpp"
+#include "ImageWriter.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "MeshLoader.hpp"
+#include "RandomBenchmark.hpp"
+#include "SceneFile.hpp"
+#include "SchedulerBenchmark.hpp"
+#include "Scenes.hpp"
+#include "Tracer.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+namespace {
+struct HeadlessOptions {
+	std::string Scene;
+	glm::uvec2 Size          = glm::uvec2(800, 600);
+	uint32_t SamplesPerPixel = 100;
+	uint32_t ThreadCount     = 0;
+	std::string Output;
+	std::string Mesh;
+	std::string Benchmark;
+	TraceSettings Settings;
+};
+
+template <typename T>
+bool ParseNumber(std::string_view text, T& outValue) {
+	const auto result = std::from_chars(text.data(), text.data() + text.size(), outValue);
+
+	return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+bool ParseSize(std::string_view text, glm::uvec2& outSize) {
+	const auto split = text.find('x');
+	if (split == std::string_view::npos) { return false; }
+
+	// The camera divides by (size - 1), so single-pixel images are not allowed.
+	return ParseNumber(text.substr(0, split), outSize.x) && ParseNumber(text.substr(split + 1), outSize.y) &&
+	       outSize.x > 1 && outSize.y > 1;
+}
+
+bool ParseOptions(int argc, const char** argv, HeadlessOptions& options) {
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--headless") { continue; }
+		if (arg == "--packets") {
+			options.Settings.PacketTracing = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			Log::Error("Headless", "Missing value for option '{}'.", arg);
+			return false;
+		}
+		const std::string_view value = argv[++i];
+
+		bool valid = true;
+		if (arg == "--scene") {
+			options.Scene = value;
+		} else if (arg == "--size") {
+			valid = ParseSize(value, options.Size);
+		} else if (arg == "--spp") {
+			valid = ParseNumber(value, options.SamplesPerPixel) && options.SamplesPerPixel > 0;
+		} else if (arg == "--threads") {
+			valid = ParseNumber(value, options.ThreadCount);
+		} else if (arg == "--output") {
+			options.Output = value;
+		} else if (arg == "--mesh") {
+			options.Mesh = value;
+		} else if (arg == "--benchmark") {
+			valid             = value == "rng" || value == "framebuffer" || value == "scheduler";
+			options.Benchmark = value;
+		} else if (arg == "--scheduler") {
+			valid = value == "stealing" || value == "shared";
+			if (value == "shared") { options.Settings.Scheduler = TraceScheduler::SharedQueue; }
+		} else if (arg == "--integrator") {
+			valid = value == "recursive" || value == "wavefront";
+			if (value == "wavefront") { options.Settings.Integrator = TraceIntegrator::Wavefront; }
+		} else if (arg == "--max-depth") {
+			valid = ParseNumber(value, options.Settings.MaxDepth) && options.Settings.MaxDepth > 0;
+		} else if (arg == "--tile-size") {
+			valid = ParseNumber(value, options.Settings.TileSize);
+		} else if (arg == "--checkpoint") {
+			options.Settings.CheckpointFile = value;
+		} else if (arg == "--error") {
+			valid = ParseNumber(value, options.Settings.ErrorThreshold) && options.Settings.ErrorThreshold >= 0.0f;
+		} else {
+			Log::Error("Headless", "Unknown option '{}'.", arg);
+			return false;
+		}
+
+		if (!valid) {
+			Log::Error("Headless", "Invalid value '{}' for option '{}'.", value, arg);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Scenes are picked by name or index from the built-in worlds followed by the scene files, whose names are their file
+// names. Scene files elsewhere are given by path.
+std::shared_ptr<World> FindWorld(const std::string& scene, ITaskPool* taskPool) {
+	if (scene.ends_with(".scene")) { return LoadScene(scene, taskPool); }
+
+	const auto& worlds    = GetWorldFactories();
+	const auto sceneFiles = FindScenes(SceneDirectory);
+	if (scene.empty()) { return worlds.front().Create(); }
+
+	for (const auto& world : worlds) {
+		if (world.Name == scene) { return world.Create(); }
+	}
+	for (const auto& sceneFile : sceneFiles) {
+		if (std::filesystem::path(sceneFile).stem() == scene) { return LoadScene(sceneFile, taskPool); }
+	}
+	uint32_t index = 0;
+	if (ParseNumber(scene, index)) {
+		if (index < worlds.size()) { return worlds[index].Create(); }
+		const size_t sceneIndex = index - worlds.size();
+		if (sceneIndex < sceneFiles.size()) { return LoadScene(sceneFiles[sceneIndex], taskPool); }
+	}
+
+	Log::Error("Headless", "Unknown scene '{}'. Available scenes:", scene);
+	for (size_t i = 0; i < worlds.size(); ++i) { Log::Error("Headless", "- {}: {}", i, worlds[i].Name); }
+	for (size_t i = 0; i < sceneFiles.size(); ++i) {
+		Log::Error("Headless", "- {}: {}", worlds.size() + i, std::filesystem::path(sceneFiles[i]).stem().string());
+	}
+
+	return nullptr;
+}
+
+int Render(const HeadlessOptions& options) {
+	// The tracer's threads are idle until the trace starts, so they build the BVHs of the scene and the mesh.
+	Tracer tracer(options.ThreadCount);
+	const auto world = FindWorld(options.Scene, &tracer);
+	if (!world) { return 1; }
+
+	// Drop the requested mesh into the scene as-is, it is up to the user to pick a scene whose camera can see it.
+	if (!options.Mesh.empty()) {
+		const auto mesh = LoadMesh(options.Mesh, &tracer);
+		if (!mesh || mesh->GetTriangleCount() == 0) {
+			Log::Error("Headless", "Failed to load mesh '{}'!", options.Mesh);
+			return 1;
+		}
+		Luna::Utility::ElapsedTime buildTime;
+		buildTime.Update();
+		world->Objects.Add<TriangleMesh>(mesh, std::make_shared<LambertianMaterial>(Color(0.8)), &tracer);
+		buildTime.Update();
+		Log::Info("Headless",
+		          "Built BVH over {} triangles in {}ms.",
+		          mesh->GetTriangleCount(),
+		          buildTime.Get().AsMilliseconds<float>());
+	}
+
+	const std::string output =
+		options.Output.empty() ? fmt::format("{}-{}.png", world->Name, options.SamplesPerPixel) : options.Output;
+
+	if (!tracer.StartTrace(options.Size, options.SamplesPerPixel, world, options.Settings)) {
+		Log::Error("Headless", "Failed to start raytrace task!");
+		return 1;
+	}
+
+	// Nothing else needs this thread, so just poll the tracer and report progress now and then.
+	uint32_t reportedSamples = 0;
+	auto nextReport          = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (tracer.IsRunning()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		tracer.Update();
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now >= nextReport && tracer.GetCompletedSamples() != reportedSamples) {
+			reportedSamples = tracer.GetCompletedSamples();
+			nextReport      = now + std::chrono::seconds(1);
+			Log::Info("Headless", "{} / {} samples completed.", reportedSamples, options.SamplesPerPixel);
+		}
+	}
+
+	// EXR keeps the linear radiance as it is, anything else is written as a gamma corrected PNG.
+	std::vector<Color> pixels;
+	tracer.CopyPixels(pixels);
+	Luna::Utility::ElapsedTime writeTime;
+	writeTime.Update();
+	bool written = false;
+	if (output.ends_with(".exr")) {
+		written = WriteEXR(output, options.Size, pixels, &tracer);
+	} else {
+		ApplyGamma(pixels);
+		written = WritePNG(output, options.Size, pixels, &tracer);
+	}
+	writeTime.Update();
+	if (!written) {
+		Log::Error("Headless", "Failed to write render result to '{}'!", output);
+		return 1;
+	}
+
+	const auto elapsed = tracer.GetElapsedTime().AsSeconds<double>();
+	Log::Info("Headless", "Wrote {} in {}ms.", output, writeTime.Get().AsMilliseconds<float>());
+	Log::Info("Headless",
+	          "Traced {} rays in {:.3f}s ({:.2f} Mrays/s, {:.2f} spp, error {:.5f}).",
+	          tracer.GetRaycastCount(),
+	          elapsed,
+	          elapsed > 0.0 ? tracer.GetRaycastCount() / elapsed / 1e6 : 0.0,
+	          tracer.GetAverageSamples(),
+	          tracer.GetError());
+	Log::Info("Headless", "Paths took {:.2f} rays on average. Rays per bounce:", tracer.GetAveragePathLength());
+	for (uint32_t bounce = 0; bounce < Tracer::BounceStatCount; ++bounce) {
+		const uint64_t rays = tracer.GetBounceRaycastCount(bounce);
+		if (rays == 0) { break; }
+		Log::Info("Headless",
+		          "- {}{}: {} rays ({:.2f} Mrays/s)",
+		          bounce,
+		          bounce == Tracer::BounceStatCount - 1 ? "+" : "",
+		          rays,
+		          elapsed > 0.0 ? rays / elapsed / 1e6 : 0.0);
+	}
+
+	return 0;
+}
+}  // namespace
+
+int RunHeadless(int argc, const char** argv) {
+	Log::Initialize();
+
+	HeadlessOptions options;
+	int result = 1;
+	if (ParseOptions(argc, argv, options)) {
+		if (options.Benchmark == "rng") {
+			result = RunRandomBenchmark();
+		} else if (options.Benchmark == "framebuffer") {
+			result = RunFramebufferBenchmark(options.ThreadCount);
+		} else if (options.Benchmark == "scheduler") {
+			result = RunSchedulerBenchmark(options.ThreadCount);
+		} else {
+			result = Render(options);
+		}
+	}
+
+	Log::Shutdown();
+
+	return result;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Renders a single image straight through the Tracer without starting the engine, so no window or graphics device is
+// ever created. Returns the process exit code.
+//
+// Usage: Rake --headless [--scene <name|index>] [--size <width>x<height>] [--spp <samples>] [--threads <count>]
+//                        [--output <file.png>] [--scheduler <stealing|shared>] [--integrator <recursive|wavefront>]
+//                        [--tile-size <pixels>] [--error <threshold>] [--packets]
+//        Rake --headless --benchmark <rng|framebuffer|scheduler> [--threads <count>]
+int RunHeadless(int argc, const char** argv);
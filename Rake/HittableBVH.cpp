@@ -0,0 +1,300 @@
+#include "HittableBVH.hpp"
+
+#include <Luna/Utility/BitOps.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "Rectangle.hpp"
+#include "Sphere.hpp"
+#include "World.hpp"
+
+static AABB GetPrimitiveBounds(const World& world, PrimitiveID primitive) {
+	switch (primitive.GetType()) {
+		case PrimitiveType::Sphere:
+			return world.Spheres.GetBounds(primitive.GetIndex());
+		case PrimitiveType::Rectangle:
+			return world.Rectangles.GetBounds(primitive.GetIndex());
+		default:
+			break;
+	}
+
+	AABB bounds;
+	if (!world.Objects.Objects[primitive.GetIndex()]->Bounds(bounds)) {
+		throw std::runtime_error("Failed to get AABB bounds!");
+	}
+
+	return bounds;
+}
+
+HittableBVH::HittableBVH(const World& world, ITaskPool* taskPool) : _world(&world) {
+	std::vector<PrimitiveID> primitives;
+	std::vector<AABB> bounds;
+	GatherPrimitives(world, primitives, bounds);
+	Build(primitives, bounds, taskPool);
+}
+
+HittableBVH::HittableBVH(const World& world,
+                         const std::vector<PrimitiveID>& primitives,
+                         const std::vector<AABB>& bounds,
+                         ITaskPool* taskPool)
+		: _world(&world) {
+	Build(primitives, bounds, taskPool);
+}
+
+void HittableBVH::GatherPrimitives(const World& world,
+                                   std::vector<PrimitiveID>& outPrimitives,
+                                   std::vector<AABB>& outBounds) {
+	const uint32_t sphereCount    = uint32_t(world.Spheres.Size());
+	const uint32_t rectangleCount = uint32_t(world.Rectangles.Size());
+	const uint32_t objectCount    = uint32_t(world.Objects.Objects.size());
+
+	outPrimitives.clear();
+	outPrimitives.reserve(sphereCount + rectangleCount + objectCount);
+	for (uint32_t i = 0; i < sphereCount; ++i) { outPrimitives.emplace_back(PrimitiveType::Sphere, i); }
+	for (uint32_t i = 0; i < rectangleCount; ++i) { outPrimitives.emplace_back(PrimitiveType::Rectangle, i); }
+	for (uint32_t i = 0; i < objectCount; ++i) { outPrimitives.emplace_back(PrimitiveType::Object, i); }
+
+	outBounds.resize(outPrimitives.size());
+	for (size_t i = 0; i < outPrimitives.size(); ++i) { outBounds[i] = GetPrimitiveBounds(world, outPrimitives[i]); }
+}
+
+double HittableBVH::GetCostRatio() const {
+	const double buildCost = _bvh.GetBuildCost();
+	return buildCost > 0.0 ? _bvh.ComputeCost() / buildCost : 1.0;
+}
+
+void HittableBVH::Refit() {
+	std::vector<AABB> bounds(_primitives.size());
+	for (size_t i = 0; i < _primitives.size(); ++i) { bounds[i] = GetPrimitiveBounds(*_world, _primitives[i]); }
+	_bvh.Refit(bounds);
+	_wideBVH.Build(_bvh.GetNodes());
+}
+
+// The primitives belong to the world, which hashes them.
+void HittableBVH::Hash(Luna::Utility::Hasher& hasher) const {
+	if (_world) { hasher(_world->GetHash()); }
+}
+
+bool HittableBVH::Bounds(AABB& outBounds) const {
+	if (_primitives.empty()) { return false; }
+	outBounds = _bvh.GetBounds();
+
+	return true;
+}
+
+bool HittableBVH::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	uint32_t closest = 0;
+	const bool hit   = _wideBVH.Intersect(ray, tMin, tMax, [&](uint32_t first, uint32_t count, Real& leafMax) {
+		return IntersectLeaf(first, count, ray, tMin, leafMax, closest, outRecord);
+	});
+	if (hit) { FinishHit(closest, ray, outRecord); }
+
+	return hit;
+}
+
+bool HittableBVH::Occluded(const Ray& ray, Real tMin, Real tMax) const {
+	return _wideBVH.Occluded(ray, tMin, tMax, [&](uint32_t first, uint32_t count) {
+		Real distance    = tMax;
+		uint32_t closest = 0;
+		HitRecord hit;
+		return IntersectLeaf(first, count, ray, tMin, distance, closest, hit);
+	});
+}
+
+SimdMask HittableBVH::IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const {
+	return _bvh.IntersectPacket(packet, tMin, tMax, [&](uint32_t first, uint32_t count, SimdFloat& leafMax) {
+		return IntersectLeafPacket(first, count, packet, tMin, leafMax, nullptr);
+	});
+}
+
+uint32_t HittableBVH::HitPacket(const std::array<Ray, PacketWidth>& rays,
+                                Real tMin,
+                                std::array<HitRecord, PacketWidth>& outRecords) const {
+	constexpr uint32_t NoPrimitive = ~0u;
+
+	const RayPacket packet(rays);
+	const SimdFloat packetMin(static_cast<float>(tMin));
+	SimdFloat closest(std::numeric_limits<float>::infinity());
+	std::array<uint32_t, PacketWidth> closestPrimitive;
+	closestPrimitive.fill(NoPrimitive);
+
+	_bvh.IntersectPacket(packet, packetMin, closest, [&](uint32_t first, uint32_t count, SimdFloat& leafMax) {
+		return IntersectLeafPacket(first, count, packet, packetMin, leafMax, closestPrimitive.data());
+	});
+
+	// The packet test only tells us which primitive is closest, and only in single precision. Fill in the hit records
+	// with the full-precision scalar test against that one primitive, and fall back to a full scalar trace in the rare
+	// case the two disagree.
+	uint32_t hitMask = 0;
+	for (uint32_t lane = 0; lane < PacketWidth; ++lane) {
+		if (closestPrimitive[lane] == NoPrimitive) { continue; }
+
+		const Ray& ray   = rays[lane];
+		auto& record     = outRecords[lane];
+		Real distance    = Infinity;
+		uint32_t closest = 0;
+		if (IntersectLeaf(closestPrimitive[lane], 1, ray, tMin, distance, closest, record)) {
+			FinishHit(closest, ray, record);
+		} else if (!Hit(ray, tMin, Infinity, record)) {
+			continue;
+		}
+		hitMask |= 1u << lane;
+	}
+
+	return hitMask;
+}
+
+void HittableBVH::Build(const std::vector<PrimitiveID>& primitives,
+                        const std::vector<AABB>& bounds,
+                        ITaskPool* taskPool) {
+	if (primitives.empty()) { throw std::runtime_error("Cannot construct a BVH with 0 primitives!"); }
+
+	// Unlike the BVHs of meshes, this one is not quantized. Planes from World::AddPlane have infinite bounds, which no
+	// number of steps across a node can reach, and every refit would have to quantize the whole tree again.
+	_bvh.Build(bounds, taskPool);
+	_wideBVH.Build(_bvh.GetNodes());
+
+	// Store the primitives in leaf order, so each leaf is a contiguous range, and sort each leaf by type. Refitting
+	// only ever combines the bounds of a whole leaf, so the order within one does not matter to the tree.
+	const auto& indices = _bvh.GetPrimitiveIndices();
+	_primitives.resize(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i) { _primitives[i] = primitives[indices[i]]; }
+	for (const auto& node : _bvh.GetNodes()) {
+		if (!node.IsLeaf()) { continue; }
+		std::sort(_primitives.begin() + node.Offset,
+		          _primitives.begin() + node.Offset + node.Count,
+		          [](PrimitiveID a, PrimitiveID b) { return a.Value < b.Value; });
+	}
+}
+
+bool HittableBVH::IntersectLeaf(uint32_t first,
+                                uint32_t count,
+                                const Ray& ray,
+                                Real tMin,
+                                Real& tMax,
+                                uint32_t& outClosest,
+                                HitRecord& outRecord) const {
+	const SpherePool& spheres       = _world->Spheres;
+	const RectanglePool& rectangles = _world->Rectangles;
+	const uint32_t end              = first + count;
+	bool hitAnything                = false;
+	uint32_t i                      = first;
+	Real t;
+
+	for (; i < end && _primitives[i].GetType() == PrimitiveType::Sphere; ++i) {
+		const uint32_t index = _primitives[i].GetIndex();
+		if (IntersectSphere(ray, spheres.GetCenter(index), spheres.Radius[index], tMin, tMax, t)) {
+			hitAnything        = true;
+			tMax               = t;
+			outRecord.Distance = t;
+			outClosest         = i;
+		}
+	}
+
+	for (; i < end && _primitives[i].GetType() == PrimitiveType::Rectangle; ++i) {
+		const uint32_t index = _primitives[i].GetIndex();
+		if (IntersectRectangle(ray,
+		                       rectangles.Plane[index],
+		                       rectangles.Min[index],
+		                       rectangles.Max[index],
+		                       rectangles.Offset[index],
+		                       tMin,
+		                       tMax,
+		                       t)) {
+			hitAnything        = true;
+			tMax               = t;
+			outRecord.Distance = t;
+			outClosest         = i;
+		}
+	}
+
+	// Only sphere sets fill in the part they hit, so it is cleared for every other object, and put back if it misses.
+	for (; i < end; ++i) {
+		const uint32_t part = outRecord.Part;
+		outRecord.Part      = ~0u;
+		if (_world->Objects.Objects[_primitives[i].GetIndex()]->Hit(ray, tMin, tMax, outRecord)) {
+			hitAnything = true;
+			tMax        = outRecord.Distance;
+			outClosest  = i;
+		} else {
+			outRecord.Part = part;
+		}
+	}
+
+	return hitAnything;
+}
+
+SimdMask HittableBVH::IntersectLeafPacket(uint32_t first,
+                                          uint32_t count,
+                                          const RayPacket& packet,
+                                          const SimdFloat& tMin,
+                                          SimdFloat& tMax,
+                                          uint32_t* outClosest) const {
+	const SpherePool& spheres       = _world->Spheres;
+	const RectanglePool& rectangles = _world->Rectangles;
+	const uint32_t end              = first + count;
+	SimdMask hitAnything            = SimdMask::None();
+	uint32_t i                      = first;
+
+	const auto recordHits = [&](const SimdMask& hit) {
+		if (outClosest) {
+			Luna::Utility::ForEachBit(hit.Bits(), [&](uint32_t lane) { outClosest[lane] = i; });
+		}
+		hitAnything = hitAnything | hit;
+	};
+
+	for (; i < end && _primitives[i].GetType() == PrimitiveType::Sphere; ++i) {
+		const uint32_t index = _primitives[i].GetIndex();
+		const Real radius    = spheres.Radius[index];
+		recordHits(IntersectSpherePacket(packet,
+		                                 static_cast<float>(spheres.CenterX[index]),
+		                                 static_cast<float>(spheres.CenterY[index]),
+		                                 static_cast<float>(spheres.CenterZ[index]),
+		                                 static_cast<float>(radius * radius),
+		                                 tMin,
+		                                 tMax));
+	}
+
+	for (; i < end && _primitives[i].GetType() == PrimitiveType::Rectangle; ++i) {
+		const uint32_t index = _primitives[i].GetIndex();
+		recordHits(IntersectRectanglePacket(packet,
+		                                    rectangles.Plane[index],
+		                                    rectangles.Min[index],
+		                                    rectangles.Max[index],
+		                                    rectangles.Offset[index],
+		                                    tMin,
+		                                    tMax));
+	}
+
+	for (; i < end; ++i) {
+		recordHits(_world->Objects.Objects[_primitives[i].GetIndex()]->IntersectPacket(packet, tMin, tMax));
+	}
+
+	return hitAnything;
+}
+
+void HittableBVH::FinishHit(uint32_t closest, const Ray& ray, HitRecord& outRecord) const {
+	const PrimitiveID primitive = _primitives[closest];
+	const uint32_t index        = primitive.GetIndex();
+	outRecord.Primitive         = primitive.Value;
+	switch (primitive.GetType()) {
+		case PrimitiveType::Sphere: {
+			const SpherePool& spheres = _world->Spheres;
+			SetSphereHit(ray, spheres.GetCenter(index), spheres.Radius[index], outRecord.Distance, outRecord);
+			outRecord.Material = _world->Materials.Get(spheres.Material[index]);
+			outRecord.Part     = ~0u;
+			break;
+		}
+		case PrimitiveType::Rectangle: {
+			const RectanglePool& rectangles = _world->Rectangles;
+			SetRectangleHit(ray, rectangles.Plane[index], outRecord.Distance, outRecord);
+			outRecord.Material = _world->Materials.Get(rectangles.Material[index]);
+			outRecord.Part     = ~0u;
+			break;
+		}
+		case PrimitiveType::Object:
+			// Objects fill in the whole record as they are hit.
+			break;
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "IHittable.hpp"
+#include "LinearBVH.hpp"
+#include "PrimitivePool.hpp"
+#include "WideBVH.hpp"
+
+class ITaskPool;
+class World;
+
+// The top-level BVH of a world, over its pooled spheres and rectangles as well as its objects. The primitives are
+// not copied, only referred to by ID, so the world has to outlive its BVH. Within each leaf the primitives are sorted
+// by type, which lets the leaf test run through the spheres and rectangles without any virtual calls. Single rays
+// traverse a wide BVH collapsed from the binary one, while packets of coherent rays stay on the binary tree.
+class HittableBVH : public IHittable {
+ public:
+	HittableBVH() = default;
+	HittableBVH(const World& world, ITaskPool* taskPool = nullptr);
+	// Build from primitives gathered from the world earlier. This does not touch the world, so it can run in the
+	// background while the world changes.
+	HittableBVH(const World& world,
+	            const std::vector<PrimitiveID>& primitives,
+	            const std::vector<AABB>& bounds,
+	            ITaskPool* taskPool = nullptr);
+
+	// Every primitive of the world along with its bounds.
+	static void GatherPrimitives(const World& world,
+	                             std::vector<PrimitiveID>& outPrimitives,
+	                             std::vector<AABB>& outBounds);
+
+	size_t GetNodeCount() const {
+		return _bvh.GetNodeCount();
+	}
+	// How much more expensive the tree is to traverse now than right after it was built, 1.0 meaning no worse.
+	double GetCostRatio() const;
+
+	// Update the bounds of the tree for primitives that moved since it was built.
+	void Refit();
+
+	virtual bool Bounds(AABB& outBounds) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+
+	// Whether anything at all lies along the ray between tMin and tMax.
+	bool Occluded(const Ray& ray, Real tMin, Real tMax) const;
+
+	// Trace a packet of rays and fill in full hit records. Returns a bitmask of the lanes that hit something.
+	uint32_t HitPacket(const std::array<Ray, PacketWidth>& rays,
+	                   Real tMin,
+	                   std::array<HitRecord, PacketWidth>& outRecords) const;
+
+ private:
+	void Build(const std::vector<PrimitiveID>& primitives, const std::vector<AABB>& bounds, ITaskPool* taskPool);
+	// Test the primitives of a leaf, keeping the closest hit in outClosest. Objects fill in the record as they are hit,
+	// while pooled primitives only set its distance and are filled in by FinishHit once the closest one is known.
+	bool IntersectLeaf(uint32_t first,
+	                   uint32_t count,
+	                   const Ray& ray,
+	                   Real tMin,
+	                   Real& tMax,
+	                   uint32_t& outClosest,
+	                   HitRecord& outRecord) const;
+	// The packet version of IntersectLeaf, which also keeps the closest primitive of each lane if outClosest is set.
+	SimdMask IntersectLeafPacket(uint32_t first,
+	                             uint32_t count,
+	                             const RayPacket& packet,
+	                             const SimdFloat& tMin,
+	                             SimdFloat& tMax,
+	                             uint32_t* outClosest) const;
+	void FinishHit(uint32_t closest, const Ray& ray, HitRecord& outRecord) const;
+
+	const World* _world = nullptr;
+	LinearBVH _bvh;
+	WideBVH _wideBVH;
+	std::vector<PrimitiveID> _primitives;  // In leaf order.
+};
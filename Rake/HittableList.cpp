@@ -24,10 +24,10 @@ bool HittableList::Bounds(AABB& outBounds) const {
 	return true;
 }
 
-bool HittableList::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const {
+bool HittableList::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
 	HitRecord hit;
 	bool hitAnything  = false;
-	double closestHit = tMax;
+	Real closestHit = tMax;
 
 	for (const auto& object : Objects) {
 		if (object->Hit(ray, tMin, closestHit, hit)) {
@@ -39,3 +39,7 @@ bool HittableList::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outR
 
 	return hitAnything;
 }
+
+void HittableList::Hash(Luna::Utility::Hasher& hasher) const {
+	for (const auto& object : Objects) { object->Hash(hasher); }
+}
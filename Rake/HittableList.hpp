@@ -14,7 +14,8 @@ class HittableList : public IHittable {
 	void Clear();
 
 	virtual bool Bounds(AABB& outBounds) const override;
-	virtual bool Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
 
 	template <typename T, typename... Args>
 	void Add(Args&&... args) {
@@ -0,0 +1,21 @@
+#include "IHittable.hpp"
+
+SimdMask IHittable::IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const {
+	float mins[PacketWidth];
+	float maxes[PacketWidth];
+	float hits[PacketWidth];
+	tMin.Store(mins);
+	tMax.Store(maxes);
+
+	HitRecord hit;
+	for (uint32_t lane = 0; lane < PacketWidth; ++lane) {
+		hits[lane] = 0.0f;
+		if (Hit(packet.GetRay(lane), mins[lane], maxes[lane], hit)) {
+			hits[lane]  = 1.0f;
+			maxes[lane] = static_cast<float>(hit.Distance);
+		}
+	}
+	tMax = SimdFloat::Load(maxes);
+
+	return SimdFloat::Load(hits) > SimdFloat(0.0f);
+}
@@ -1,29 +1,48 @@
 #pragma once
 
+#include <Luna/Utility/Hash.hpp>
+#include <cstdint>
 #include <memory>
 
 #include "AABB.hpp"
 #include "DataTypes.hpp"
 #include "Ray.hpp"
+#include "RayPacket.hpp"
 
 class IMaterial;
 
 struct HitRecord {
 	Point3 Point;
-	double Distance;
+	Real Distance;
 	Vector3 Normal;
 	bool FrontFace;
 	Point2 UV;
 	const IMaterial* Material = nullptr;
+	uint32_t Primitive        = ~0u;  // PrimitiveID::Value of what was hit, filled in by the world's BVH.
+	uint32_t Part             = ~0u;  // Which sphere of a sphere set was hit, unset for anything else.
 
 	inline void SetFaceNormal(const Ray& ray, const Vector3& outwardNormal) {
 		FrontFace = glm::dot(ray.Direction, outwardNormal) < 0.0;
 		Normal    = FrontFace ? outwardNormal : -outwardNormal;
 	}
+
+	// Start a new ray at the hit point, nudged off the surface to the side the ray is leaving towards.
+	inline Ray SpawnRay(const Vector3& direction) const {
+		const Vector3 offsetNormal = glm::dot(direction, Normal) < 0 ? -Normal : Normal;
+		return Ray(OffsetRayOrigin(Point, offsetNormal), direction);
+	}
 };
 
 class IHittable {
  public:
 	virtual bool Bounds(AABB& outBounds) const                                             = 0;
-	virtual bool Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const = 0;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const = 0;
+
+	// Finds the closest hit for every ray in the packet, in single precision. Lanes that hit closer than tMax have
+	// their tMax updated and are set in the returned mask. The default falls back to calling Hit once per lane.
+	virtual SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const;
+
+	// Feeds the geometry and materials of the hittable and of everything it holds into the hasher, in a fixed order, so
+	// any change to what it looks like changes the hash.
+	virtual void Hash(Luna::Utility::Hasher& hasher) const = 0;
 };
@@ -1,12 +1,56 @@
 #pragma once
 
+#include <Luna/Utility/Hash.hpp>
+#include <cstdint>
+
 #include "DataTypes.hpp"
+#include "Ray.hpp"
 
 struct HitRecord;
-class Ray;
+
+// Identifies the built-in materials, so integrators can batch up hits by material and shade each batch with direct
+// calls. Anything else reports Generic and is shaded through the virtual interface.
+enum class MaterialType : uint8_t { Lambertian, Metal, Dielectric, DiffuseLight, Generic, Count };
+
+// A direction picked by IMaterial::Scatter to carry on a path in.
+struct ScatterRecord {
+	Ray Scattered;
+	Color Attenuation;  // The BSDF times the cosine over Pdf, which is what the light found along Scattered is scaled by.
+	Real Pdf = 0.0;     // Solid-angle density Scattered was picked with, or 0 if the material is specular.
+};
 
 class IMaterial {
  public:
-	virtual Color Emit(const Point2& uv, const Point3& p) const                                                = 0;
-	virtual bool Scatter(const Ray& ray, const HitRecord& hit, Color& outAttenuation, Ray& outScattered) const = 0;
+	virtual MaterialType GetType() const {
+		return MaterialType::Generic;
+	}
+	// Feeds the type of the material and everything that changes how it looks into the hasher.
+	virtual void Hash(Luna::Utility::Hasher& hasher) const = 0;
+	virtual Color Emit(const Point2& uv, const Point3& p) const = 0;
+	// Samples a direction for light to arrive from and leave back along the ray, ideally in proportion to Eval so the
+	// attenuation stays close to constant. Returns false if the path ends here. May draw at most 3 random numbers, as
+	// the tracer's next sampler dimension goes to Russian roulette (see Tracer::RouletteDimension).
+	virtual bool Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const = 0;
+
+	// Whether Scatter only ever picks from a handful of exact directions, as mirrors and glass do. Light sampled from
+	// anywhere else would never reflect off these, so they are left out of next-event estimation, and Eval and Pdf
+	// are never asked about them. Materials that do not say otherwise count as specular, which is always safe.
+	virtual bool IsSpecular() const {
+		return true;
+	}
+	// The BSDF times the cosine of the angle to the normal, for light arriving from direction and leaving back along
+	// the ray.
+	virtual Color Eval(const Ray& ray, const HitRecord& hit, const Vector3& direction) const {
+		return Color(0.0f);
+	}
+	// The solid-angle density with which Scatter picks direction.
+	virtual Real Pdf(const Ray& ray, const HitRecord& hit, const Vector3& direction) const {
+		return 0.0;
+	}
 };
+
+// Hashes a material that may not be set.
+inline void HashMaterial(Luna::Utility::Hasher& hasher, const IMaterial* material) {
+	hasher(material != nullptr);
+	if (material) { material->Hash(hasher); }
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <Luna/Utility/Hash.hpp>
+
 #include "DataTypes.hpp"
 
 class Ray;
@@ -7,4 +9,21 @@ class Ray;
 class ISkyMaterial {
  public:
 	virtual Color Sample(const Ray& ray) const = 0;
+	// Feeds the type of the sky and everything that changes how it looks into the hasher.
+	virtual void Hash(Luna::Utility::Hasher& hasher) const = 0;
+
+	// Skies with bright spots, such as the sun in a photographed environment, can pick directions to sample light from
+	// in proportion to how bright they are. Skies that do not only ever contribute through rays that escape the world.
+	virtual bool IsImportanceSampled() const {
+		return false;
+	}
+	// Picks a direction towards the sky using three uniform random numbers, and the solid-angle density it was picked
+	// with. Returns false if no direction could be picked.
+	virtual bool SampleDirection(const double u[3], Vector3& outDirection, Real& outPdf) const {
+		return false;
+	}
+	// The density with which SampleDirection picks direction.
+	virtual Real Pdf(const Vector3& direction) const {
+		return 0.0;
+	}
 };
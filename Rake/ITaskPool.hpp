@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// A set of threads that independent pieces of work can be spread across.
+class ITaskPool {
+ public:
+	// Number of threads that work on a ParallelFor at once, including the thread that called it.
+	virtual uint32_t GetThreadCount() const = 0;
+
+	// Call func(i) for every i in [0, count) and return once all of them have finished. The calling thread helps out
+	// rather than sitting idle. If any call throws, the first exception is rethrown once all of them are done.
+	virtual void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) = 0;
+};
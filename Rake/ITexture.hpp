@@ -1,8 +1,18 @@
 #pragma once
 
+#include <Luna/Utility/Hash.hpp>
+
 #include "DataTypes.hpp"
 
 class ITexture {
  public:
 	virtual Color Sample(const Point2& uv, const Point3& p) const = 0;
+	// Feeds the type of the texture and everything it samples into the hasher.
+	virtual void Hash(Luna::Utility::Hasher& hasher) const = 0;
 };
+
+// Hashes a texture that may not be set.
+inline void HashTexture(Luna::Utility::Hasher& hasher, const ITexture* texture) {
+	hasher(texture != nullptr);
+	if (texture) { texture->Hash(hasher); }
+}
@@ -3,6 +3,7 @@
 #include <stb_image.h>
 
 #include <Luna/Utility/Log.hpp>
+#include <string_view>
 
 using Luna::Log;
 
@@ -52,10 +53,16 @@ ImageTexture::ImageTexture(const std::string& filename) {
 Color ImageTexture::Sample(const Point2& uv, const Vector3& p) const {
 	if (Pixels.size() == 0) { return Color(0, 1, 1); }
 
-	const auto u = glm::clamp(uv.x, 0.0, 1.0);
-	const auto v = 1.0 - glm::clamp(uv.y, 0.0, 1.0);
+	const auto u = glm::clamp(uv.x, Real(0), Real(1));
+	const auto v = 1.0 - glm::clamp(uv.y, Real(0), Real(1));
 	const auto x = glm::clamp(static_cast<unsigned int>(u * Size.x), 0u, Size.x - 1);
 	const auto y = glm::clamp(static_cast<unsigned int>(v * Size.y), 0u, Size.y - 1);
 
 	return Pixels[(y * Size.x) + x];
 }
+
+void ImageTexture::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(std::string_view("Image"));
+	hasher.Data(sizeof(Size), &Size);
+	hasher.Data(Pixels.size() * sizeof(Color), Pixels.data());
+}
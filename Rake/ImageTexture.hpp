@@ -11,6 +11,7 @@ class ImageTexture : public ITexture {
 	ImageTexture(const std::string& filename);
 
 	virtual Color Sample(const Point2& uv, const Vector3& p) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
 
 	glm::uvec2 Size = glm::uvec2(0);
 	std::vector<Color> Pixels;
@@ -0,0 +1,492 @@
+#include "ImageWriter.hpp"
+
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <glm/gtc/packing.hpp>
+
+#include "ITaskPool.hpp"
+
+// The zlib compressor of stb_image_write, which it defines but does not declare in its header.
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int dataLength, int* outLength, int quality);
+
+namespace {
+constexpr uint32_t MinStripRows    = 32;     // Fewer rows than this per strip costs more in compression than it saves.
+constexpr uint32_t ExrBlockLines   = 16;     // Scanlines per block, fixed by the ZIP compression mode.
+constexpr uint32_t AdlerBase       = 65521;  // Largest prime below 2^16.
+constexpr uint32_t HashBits        = 15;
+constexpr uint32_t MinMatch        = 3;
+constexpr uint32_t MaxMatch        = 258;
+constexpr uint32_t MaxDistance     = 32768;
+constexpr uint8_t ZlibHeader[]     = {0x78, 0x01};                    // Deflate with a 32K window, fastest level.
+constexpr uint8_t ZlibFinalBlock[] = {0x01, 0x00, 0x00, 0xff, 0xff};  // An empty stored block with BFINAL set.
+
+constexpr std::array<uint16_t, 29> LengthBase = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<uint8_t, 29> LengthExtra = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<uint16_t, 30> DistanceBase = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                                   33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                                   1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+constexpr std::array<uint8_t, 30> DistanceExtra = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                                   6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// The fixed Huffman codes from the deflate spec, bit-reversed ready to be written out.
+struct FixedHuffmanCodes {
+	FixedHuffmanCodes() {
+		for (uint32_t symbol = 0; symbol < 288; ++symbol) {
+			uint32_t code, length;
+			if (symbol < 144) {
+				code = 0x30 + symbol, length = 8;
+			} else if (symbol < 256) {
+				code = 0x190 + symbol - 144, length = 9;
+			} else if (symbol < 280) {
+				code = symbol - 256, length = 7;
+			} else {
+				code = 0xc0 + symbol - 280, length = 8;
+			}
+			LiteralCodes[symbol]   = Reverse(code, length);
+			LiteralLengths[symbol] = length;
+		}
+		for (uint32_t symbol = 0; symbol < 30; ++symbol) { DistanceCodes[symbol] = Reverse(symbol, 5); }
+	}
+
+	static uint16_t Reverse(uint32_t code, uint32_t length) {
+		uint32_t reversed = 0;
+		for (uint32_t i = 0; i < length; ++i) { reversed |= ((code >> i) & 1) << (length - 1 - i); }
+
+		return static_cast<uint16_t>(reversed);
+	}
+
+	std::array<uint16_t, 288> LiteralCodes;
+	std::array<uint8_t, 288> LiteralLengths;
+	std::array<uint8_t, 30> DistanceCodes;
+};
+const FixedHuffmanCodes FixedCodes;
+
+const std::array<uint32_t, 256> CrcTable = []() {
+	std::array<uint32_t, 256> table;
+	for (uint32_t i = 0; i < 256; ++i) {
+		uint32_t crc = i;
+		for (int bit = 0; bit < 8; ++bit) { crc = (crc & 1) ? 0xedb88320u ^ (crc >> 1) : crc >> 1; }
+		table[i] = crc;
+	}
+
+	return table;
+}();
+
+// Packs bits into bytes starting from the least significant bit, the order deflate wants them in.
+class BitWriter {
+ public:
+	explicit BitWriter(std::vector<uint8_t>& output) : _output(output) {}
+
+	void Write(uint32_t bits, uint32_t count) {
+		_bits |= uint64_t(bits) << _count;
+		_count += count;
+		while (_count >= 8) {
+			_output.push_back(static_cast<uint8_t>(_bits));
+			_bits >>= 8;
+			_count -= 8;
+		}
+	}
+	void WriteLiteral(uint32_t symbol) {
+		Write(FixedCodes.LiteralCodes[symbol], FixedCodes.LiteralLengths[symbol]);
+	}
+	void WriteMatch(uint32_t length, uint32_t distance) {
+		const uint32_t lengthCode =
+			std::upper_bound(LengthBase.begin(), LengthBase.end(), length) - LengthBase.begin() - 1;
+		WriteLiteral(257 + lengthCode);
+		Write(length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+
+		const uint32_t distanceCode =
+			std::upper_bound(DistanceBase.begin(), DistanceBase.end(), distance) - DistanceBase.begin() - 1;
+		Write(FixedCodes.DistanceCodes[distanceCode], 5);
+		Write(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+	}
+	void Align() {
+		if (_count > 0) { Write(0, 8 - _count); }
+	}
+
+ private:
+	std::vector<uint8_t>& _output;
+	uint64_t _bits  = 0;
+	uint32_t _count = 0;
+};
+
+uint32_t Hash(const uint8_t* data) {
+	const uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+
+	return (value * 2654435761u) >> (32 - HashBits);
+}
+
+// Compress data as a single deflate block using the fixed Huffman codes, appending it to output. Matches are found
+// through a hash table that only remembers the last position for every hash, which compresses a little worse than
+// zlib does but is many times faster. Unless final is set, the block is followed by an empty stored block, which
+// leaves the stream on a byte boundary so that independently compressed data can be appended to it.
+void Deflate(const uint8_t* data, size_t size, bool final, std::vector<uint8_t>& output) {
+	BitWriter bits(output);
+	bits.Write(final ? 1 : 0, 1);
+	bits.Write(1, 2);
+
+	std::vector<int32_t> table(size_t(1) << HashBits, -1);
+	size_t i = 0;
+	while (i < size) {
+		if (i + MinMatch <= size) {
+			const uint32_t hash     = Hash(data + i);
+			const int32_t candidate = table[hash];
+			table[hash]             = static_cast<int32_t>(i);
+			if (candidate >= 0 && i - candidate <= MaxDistance &&
+			    std::memcmp(data + candidate, data + i, MinMatch) == 0) {
+				const size_t maxLength = std::min<size_t>(MaxMatch, size - i);
+				size_t length          = MinMatch;
+				while (length < maxLength && data[candidate + length] == data[i + length]) { ++length; }
+				bits.WriteMatch(static_cast<uint32_t>(length), static_cast<uint32_t>(i - candidate));
+
+				// Remember the positions inside the match as well, or a long run would hide everything in it.
+				for (size_t j = i + 1; j < i + length && j + MinMatch <= size; ++j) {
+					table[Hash(data + j)] = static_cast<int32_t>(j);
+				}
+				i += length;
+				continue;
+			}
+		}
+
+		bits.WriteLiteral(data[i]);
+		++i;
+	}
+
+	bits.WriteLiteral(256);
+	if (!final) {
+		bits.Write(0, 3);
+		bits.Align();
+		bits.Write(0xffff0000, 32);
+	}
+	bits.Align();
+}
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i) { crc = CrcTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8); }
+
+	return ~crc;
+}
+
+uint32_t Adler32(const uint8_t* data, size_t size) {
+	uint32_t a = 1;
+	uint32_t b = 0;
+	while (size > 0) {
+		// The largest number of bytes that can be summed before b could overflow.
+		const size_t block = std::min<size_t>(size, 5552);
+		for (size_t i = 0; i < block; ++i) {
+			a += data[i];
+			b += a;
+		}
+		a %= AdlerBase;
+		b %= AdlerBase;
+		data += block;
+		size -= block;
+	}
+
+	return (b << 16) | a;
+}
+
+// Checksum of two pieces of data back to back, given the checksum of each and the size of the second.
+uint32_t CombineAdler32(uint32_t first, uint32_t second, size_t secondSize) {
+	const uint32_t remainder = secondSize % AdlerBase;
+	const uint32_t firstA    = first & 0xffff;
+	const uint32_t a         = (firstA + (second & 0xffff) + AdlerBase - 1) % AdlerBase;
+	const uint32_t b =
+		((remainder * firstA) % AdlerBase + (first >> 16) + (second >> 16) + AdlerBase - remainder) % AdlerBase;
+
+	return (b << 16) | a;
+}
+
+void AppendBE32(std::vector<uint8_t>& output, uint32_t value) {
+	for (int shift = 24; shift >= 0; shift -= 8) { output.push_back(static_cast<uint8_t>(value >> shift)); }
+}
+void AppendLE32(std::vector<uint8_t>& output, uint32_t value) {
+	for (int shift = 0; shift < 32; shift += 8) { output.push_back(static_cast<uint8_t>(value >> shift)); }
+}
+void AppendLE64(std::vector<uint8_t>& output, uint64_t value) {
+	for (int shift = 0; shift < 64; shift += 8) { output.push_back(static_cast<uint8_t>(value >> shift)); }
+}
+void AppendBytes(std::vector<uint8_t>& output, const void* data, size_t size) {
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	output.insert(output.end(), bytes, bytes + size);
+}
+
+// Run func(i) for every i in [0, count), spread across the task pool if there is one.
+void ParallelFor(ITaskPool* taskPool, uint32_t count, const std::function<void(uint32_t)>& func) {
+	if (taskPool) {
+		taskPool->ParallelFor(count, func);
+	} else {
+		for (uint32_t i = 0; i < count; ++i) { func(i); }
+	}
+}
+
+// Rows per strip so that every thread gets a few strips, which evens out strips that compress at different speeds.
+uint32_t GetStripRows(ITaskPool* taskPool, uint32_t rows, uint32_t minRows) {
+	const uint32_t strips = (taskPool ? taskPool->GetThreadCount() : 1) * 4;
+
+	return std::max((rows + strips - 1) / strips, minRows);
+}
+
+std::vector<uint8_t> MakePNGChunk(const char* type, const std::vector<uint8_t>& data) {
+	std::vector<uint8_t> chunk;
+	chunk.reserve(data.size() + 12);
+	AppendBE32(chunk, static_cast<uint32_t>(data.size()));
+	AppendBytes(chunk, type, 4);
+	AppendBytes(chunk, data.data(), data.size());
+	AppendBE32(chunk, Crc32(chunk.data() + 4, data.size() + 4));
+
+	return chunk;
+}
+
+void ConvertRow(const Color* pixels, uint32_t width, uint8_t* output) {
+	for (uint32_t x = 0; x < width; ++x) {
+		const auto& p = pixels[x];
+		*output++     = static_cast<uint8_t>(glm::clamp(p.r, 0.0f, 1.0f) * 255.999f);
+		*output++     = static_cast<uint8_t>(glm::clamp(p.g, 0.0f, 1.0f) * 255.999f);
+		*output++     = static_cast<uint8_t>(glm::clamp(p.b, 0.0f, 1.0f) * 255.999f);
+	}
+}
+
+uint8_t PaethPredictor(int a, int b, int c) {
+	const int p  = a + b - c;
+	const int pa = std::abs(p - a);
+	const int pb = std::abs(p - b);
+	const int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc) { return static_cast<uint8_t>(a); }
+
+	return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+// Filter a row of RGB bytes with whichever of the five PNG filters leaves the smallest values, the usual heuristic
+// for what will compress best. Writes the filter type followed by the filtered row.
+void FilterRow(const uint8_t* row, const uint8_t* previous, uint32_t rowBytes, uint8_t* output) {
+	constexpr uint32_t BytesPerPixel = 3;
+
+	std::vector<uint8_t> candidate(rowBytes);
+	uint64_t bestCost = ~uint64_t(0);
+	for (uint8_t filter = 0; filter < 5; ++filter) {
+		uint64_t cost = 0;
+		for (uint32_t i = 0; i < rowBytes; ++i) {
+			const int a = i >= BytesPerPixel ? row[i - BytesPerPixel] : 0;
+			const int b = previous[i];
+			const int c = i >= BytesPerPixel ? previous[i - BytesPerPixel] : 0;
+			int predicted;
+			switch (filter) {
+				case 0:
+					predicted = 0;
+					break;
+				case 1:
+					predicted = a;
+					break;
+				case 2:
+					predicted = b;
+					break;
+				case 3:
+					predicted = (a + b) >> 1;
+					break;
+				default:
+					predicted = PaethPredictor(a, b, c);
+					break;
+			}
+			candidate[i] = static_cast<uint8_t>(row[i] - predicted);
+			cost += std::abs(static_cast<int8_t>(candidate[i]));
+		}
+
+		if (cost < bestCost) {
+			bestCost  = cost;
+			output[0] = filter;
+			std::copy(candidate.begin(), candidate.end(), output + 1);
+		}
+	}
+}
+}  // namespace
+
+void ApplyGamma(std::vector<Color>& pixels) {
+	for (auto& pixel : pixels) { pixel = GammaCorrect(pixel); }
+}
+
+// Each strip of rows is compressed on its own, into its own IDAT chunk. Strips end with an empty stored block to
+// bring them to a byte boundary, so the chunks' contents join up into one valid zlib stream, and the Adler-32 of the
+// whole image is put together from the checksums of every strip. Strips cannot refer back to the strip above, which
+// costs a little compression in exchange for every strip being independent.
+bool WritePNG(const std::string& filename,
+              const glm::uvec2& size,
+              const std::vector<Color>& pixels,
+              ITaskPool* taskPool) {
+	const uint32_t rowBytes   = size.x * 3;
+	const uint32_t stripRows  = GetStripRows(taskPool, size.y, MinStripRows);
+	const uint32_t stripCount = (size.y + stripRows - 1) / stripRows;
+
+	std::vector<std::vector<uint8_t>> chunks(stripCount);
+	std::vector<uint32_t> checksums(stripCount);
+	ParallelFor(taskPool, stripCount, [&](uint32_t strip) {
+		const uint32_t firstRow = strip * stripRows;
+		const uint32_t lastRow  = std::min(firstRow + stripRows, size.y);
+
+		// Filters look at the row above, so the strip needs the last row of the strip before it too.
+		std::vector<uint8_t> previous(rowBytes, 0);
+		std::vector<uint8_t> row(rowBytes);
+		if (firstRow > 0) { ConvertRow(&pixels[size_t(firstRow - 1) * size.x], size.x, previous.data()); }
+
+		std::vector<uint8_t> filtered(size_t(lastRow - firstRow) * (rowBytes + 1));
+		for (uint32_t y = firstRow; y < lastRow; ++y) {
+			ConvertRow(&pixels[size_t(y) * size.x], size.x, row.data());
+			FilterRow(row.data(), previous.data(), rowBytes, &filtered[size_t(y - firstRow) * (rowBytes + 1)]);
+			std::swap(row, previous);
+		}
+		checksums[strip] = Adler32(filtered.data(), filtered.size());
+
+		std::vector<uint8_t> compressed;
+		if (strip == 0) { AppendBytes(compressed, ZlibHeader, sizeof(ZlibHeader)); }
+		Deflate(filtered.data(), filtered.size(), false, compressed);
+		chunks[strip] = MakePNGChunk("IDAT", compressed);
+	});
+
+	uint32_t checksum = checksums[0];
+	for (uint32_t strip = 1; strip < stripCount; ++strip) {
+		const uint32_t rows = std::min(stripRows, size.y - strip * stripRows);
+		checksum            = CombineAdler32(checksum, checksums[strip], size_t(rows) * (rowBytes + 1));
+	}
+	std::vector<uint8_t> streamEnd;
+	AppendBytes(streamEnd, ZlibFinalBlock, sizeof(ZlibFinalBlock));
+	AppendBE32(streamEnd, checksum);
+
+	std::vector<uint8_t> header;
+	AppendBE32(header, size.x);
+	AppendBE32(header, size.y);
+	AppendBytes(header, "\x08\x02\x00\x00\x00", 5);  // 8-bit RGB, deflate, adaptive filtering, no interlacing.
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) { return false; }
+
+	const auto write = [&file](const std::vector<uint8_t>& data) {
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	};
+	file.write("\x89PNG\r\n\x1a\n", 8);
+	write(MakePNGChunk("IHDR", header));
+	for (const auto& chunk : chunks) { write(chunk); }
+	write(MakePNGChunk("IDAT", streamEnd));
+	write(MakePNGChunk("IEND", {}));
+
+	return static_cast<bool>(file);
+}
+
+// Every block of scanlines is compressed as its own zlib stream with stb_image_write's compressor, so they are all
+// independent and can be compressed in parallel. The channels are stored in order of their names, so a scanline holds
+// all of its blue values, then all of its green values, then all of its red values.
+bool WriteEXR(const std::string& filename,
+              const glm::uvec2& size,
+              const std::vector<Color>& pixels,
+              ITaskPool* taskPool) {
+	const uint32_t blockCount = (size.y + ExrBlockLines - 1) / ExrBlockLines;
+
+	std::vector<std::vector<uint8_t>> blocks(blockCount);
+	ParallelFor(taskPool, blockCount, [&](uint32_t block) {
+		const uint32_t firstLine = block * ExrBlockLines;
+		const uint32_t lastLine  = std::min(firstLine + ExrBlockLines, size.y);
+
+		std::vector<uint8_t> raw;
+		raw.reserve(size_t(lastLine - firstLine) * size.x * 3 * sizeof(uint16_t));
+		for (uint32_t y = firstLine; y < lastLine; ++y) {
+			const Color* line = &pixels[size_t(y) * size.x];
+			for (int channel = 2; channel >= 0; --channel) {
+				for (uint32_t x = 0; x < size.x; ++x) {
+					const uint16_t half = glm::packHalf1x16(line[x][channel]);
+					raw.push_back(static_cast<uint8_t>(half));
+					raw.push_back(static_cast<uint8_t>(half >> 8));
+				}
+			}
+		}
+
+		// ZIP compression splits the bytes into the even and the odd ones and then delta encodes them, which lines
+		// the slowly changing high bytes of neighbouring halves up for the compressor.
+		std::vector<uint8_t> predicted(raw.size());
+		const size_t half = (raw.size() + 1) / 2;
+		for (size_t i = 0; i < raw.size(); ++i) { predicted[(i & 1) ? half + i / 2 : i / 2] = raw[i]; }
+		for (size_t i = predicted.size() - 1; i > 0; --i) {
+			predicted[i] = static_cast<uint8_t>(predicted[i] - predicted[i - 1] + 128);
+		}
+
+		int compressedSize = 0;
+		unsigned char* compressed =
+			stbi_zlib_compress(predicted.data(), int(predicted.size()), &compressedSize, stbi_write_png_compression_level);
+
+		// Blocks that would not get any smaller are stored as they are.
+		const bool useCompressed = compressed && size_t(compressedSize) < raw.size();
+		const size_t dataSize    = useCompressed ? size_t(compressedSize) : raw.size();
+		AppendLE32(blocks[block], firstLine);
+		AppendLE32(blocks[block], static_cast<uint32_t>(dataSize));
+		AppendBytes(blocks[block], useCompressed ? compressed : raw.data(), dataSize);
+		std::free(compressed);
+	});
+
+	std::vector<uint8_t> header;
+	const auto appendAttribute = [&header](const char* name, const char* type, const std::vector<uint8_t>& value) {
+		AppendBytes(header, name, std::strlen(name) + 1);
+		AppendBytes(header, type, std::strlen(type) + 1);
+		AppendLE32(header, static_cast<uint32_t>(value.size()));
+		AppendBytes(header, value.data(), value.size());
+	};
+	const auto makeBox = [&size]() {
+		std::vector<uint8_t> box;
+		AppendLE32(box, 0);
+		AppendLE32(box, 0);
+		AppendLE32(box, size.x - 1);
+		AppendLE32(box, size.y - 1);
+		return box;
+	};
+	const auto makeFloats = [](std::initializer_list<float> values) {
+		std::vector<uint8_t> floats;
+		for (float value : values) {
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			AppendLE32(floats, bits);
+		}
+		return floats;
+	};
+
+	std::vector<uint8_t> channels;
+	for (const char* name : {"B", "G", "R"}) {
+		AppendBytes(channels, name, 2);
+		AppendLE32(channels, 1);  // Half float.
+		AppendLE32(channels, 0);  // Perceptually linear flag and reserved bytes.
+		AppendLE32(channels, 1);  // X sampling.
+		AppendLE32(channels, 1);  // Y sampling.
+	}
+	channels.push_back(0);
+
+	AppendLE32(header, 20000630);  // Magic number.
+	AppendLE32(header, 2);         // Version 2, single-part scanline image.
+	appendAttribute("channels", "chlist", channels);
+	appendAttribute("compression", "compression", {3});  // ZIP, 16 scanlines per block.
+	appendAttribute("dataWindow", "box2i", makeBox());
+	appendAttribute("displayWindow", "box2i", makeBox());
+	appendAttribute("lineOrder", "lineOrder", {0});  // Increasing y.
+	appendAttribute("pixelAspectRatio", "float", makeFloats({1.0f}));
+	appendAttribute("screenWindowCenter", "v2f", makeFloats({0.0f, 0.0f}));
+	appendAttribute("screenWindowWidth", "float", makeFloats({1.0f}));
+	header.push_back(0);
+
+	uint64_t offset = header.size() + sizeof(uint64_t) * blockCount;
+	for (const auto& block : blocks) {
+		AppendLE64(header, offset);
+		offset += block.size();
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file) { return false; }
+
+	file.write(reinterpret_cast<const char*>(header.data()), header.size());
+	for (const auto& block : blocks) { file.write(reinterpret_cast<const char*>(block.data()), block.size()); }
+
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "DataTypes.hpp"
+
+class ITaskPool;
+
+// Converts accumulated linear radiance into display values, using a gamma of 2.
+inline Color GammaCorrect(const Color& pixel) {
+	return glm::sqrt(pixel);
+}
+void ApplyGamma(std::vector<Color>& pixels);
+
+// Writes display-ready pixels out as an 8-bit RGB PNG. The image is split into horizontal strips that are converted,
+// filtered and compressed independently, on all of the task pool's threads if one is given.
+bool WritePNG(const std::string& filename,
+              const glm::uvec2& size,
+              const std::vector<Color>& pixels,
+              ITaskPool* taskPool = nullptr);
+
+// Writes linear radiance out as a ZIP-compressed, half-float OpenEXR image, which keeps the full dynamic range of the
+// render. Blocks of scanlines are compressed independently, on all of the task pool's threads if one is given.
+bool WriteEXR(const std::string& filename,
+              const glm::uvec2& size,
+              const std::vector<Color>& pixels,
+              ITaskPool* taskPool = nullptr);
@@ -0,0 +1,53 @@
+#include "Instance.hpp"
+
+#include "IMaterial.hpp"
+
+Instance::Instance(const std::shared_ptr<const IHittable>& object,
+                   const Matrix4& transform,
+                   const std::shared_ptr<IMaterial>& material)
+		: Object(object), Material(material) {
+	SetTransform(transform);
+}
+
+void Instance::SetTransform(const Matrix4& transform) {
+	_objectToWorld = transform;
+	_worldToObject = glm::inverse(transform);
+	_normalToWorld = glm::transpose(glm::inverse(Matrix3(transform)));
+}
+
+bool Instance::Bounds(AABB& outBounds) const {
+	AABB objectBounds;
+	if (!Object->Bounds(objectBounds)) { return false; }
+
+	outBounds = AABB();
+	for (int corner = 0; corner < 8; ++corner) {
+		const Point3 p((corner & 1) ? objectBounds.Max.x : objectBounds.Min.x,
+		               (corner & 2) ? objectBounds.Max.y : objectBounds.Min.y,
+		               (corner & 4) ? objectBounds.Max.z : objectBounds.Min.z);
+		outBounds = outBounds.Contain(Point3(_objectToWorld * glm::vec<4, Real>(p, 1)));
+	}
+
+	return true;
+}
+
+bool Instance::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	// Everything expects unit length ray directions, so normalize the direction in object space and use its length to
+	// convert distances between the two spaces.
+	const Point3 origin     = Point3(_worldToObject * glm::vec<4, Real>(ray.Origin, 1));
+	const Vector3 direction = Vector3(_worldToObject * glm::vec<4, Real>(ray.Direction, 0));
+	const Real scale        = glm::length(direction);
+	if (!Object->Hit(Ray(origin, direction / scale), tMin * scale, tMax * scale, outRecord)) { return false; }
+
+	outRecord.Distance /= scale;
+	outRecord.Point     = Point3(_objectToWorld * glm::vec<4, Real>(outRecord.Point, 1));
+	outRecord.Normal    = glm::normalize(_normalToWorld * outRecord.Normal);
+	if (Material) { outRecord.Material = Material.get(); }
+
+	return true;
+}
+
+void Instance::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher.Data(sizeof(_objectToWorld), &_objectToWorld);
+	HashMaterial(hasher, Material.get());
+	Object->Hash(hasher);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+
+#include "IHittable.hpp"
+
+class IMaterial;
+
+// Places a shared object in the world with an affine transform. The object is usually something with its own BVH,
+// such as a TriangleMesh or a HittableBVH, acting as the bottom level of a two-level hierarchy: it is stored once no
+// matter how many instances use it, and moving an instance only changes the bounds seen by the world's top-level BVH.
+// The object must have finite bounds.
+class Instance : public IHittable {
+ public:
+	Instance(const std::shared_ptr<const IHittable>& object,
+	         const Matrix4& transform                   = Matrix4(1),
+	         const std::shared_ptr<IMaterial>& material = nullptr);
+
+	const Matrix4& GetTransform() const {
+		return _objectToWorld;
+	}
+	void SetTransform(const Matrix4& transform);
+
+	virtual bool Bounds(AABB& outBounds) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+
+	std::shared_ptr<const IHittable> Object;
+	std::shared_ptr<IMaterial> Material;  // Replaces the object's own materials if set.
+
+ private:
+	Matrix4 _objectToWorld;
+	Matrix4 _worldToObject;
+	Matrix3 _normalToWorld;
+};
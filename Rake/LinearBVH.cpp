@@ -0,0 +1,386 @@
+#include "LinearBVH.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "ITaskPool.hpp"
+
+namespace {
+constexpr uint32_t BinCount         = 16;
+constexpr uint32_t MaxLeafSize      = 4;
+constexpr uint32_t MaxLeafCount     = std::numeric_limits<uint16_t>::max();
+constexpr double TraversalCost      = 0.125;
+constexpr double IntersectionCost   = 1.0;
+constexpr double UnboundedExtent    = 1e30;
+
+// Trees with fewer primitives than this are not worth waking up other threads for.
+constexpr uint32_t ParallelBuildThreshold = 16384;
+// Smallest range of primitives that gets binned by a thread of its own, and smallest subtree handed out as a task.
+constexpr uint32_t ParallelChunkSize = 16384;
+constexpr uint32_t MinSubtreeSize    = 1024;
+// Aim for this many subtrees per thread, so threads that draw the small ones can pick up more.
+constexpr uint32_t SubtreesPerThread = 8;
+
+// Convert a double-precision bound to float, rounding outwards so the node bounds never shrink.
+float RoundDown(double v) {
+	const float f = static_cast<float>(v);
+	return static_cast<double>(f) <= v ? f : std::nextafter(f, -std::numeric_limits<float>::infinity());
+}
+
+float RoundUp(double v) {
+	const float f = static_cast<float>(v);
+	return static_cast<double>(f) >= v ? f : std::nextafter(f, std::numeric_limits<float>::infinity());
+}
+
+struct Bin {
+	AABB Bounds;
+	uint32_t Count = 0;
+};
+
+// Bounds of a range of primitives and bins along every axis, computed for parts of the range at a time and merged.
+struct BinningResult {
+	AABB Bounds;
+	AABB CentroidBounds;
+	std::array<std::array<Bin, BinCount>, 3> Bins;
+};
+
+uint32_t GetChunkCount(ITaskPool* taskPool, uint32_t count) {
+	if (!taskPool) { return 1; }
+
+	return std::clamp((count + ParallelChunkSize - 1) / ParallelChunkSize, 1u, taskPool->GetThreadCount() * 4);
+}
+
+// Split [first, first + count) into chunkCount even parts and call func(chunk, begin, end) for each of them.
+template <typename Func>
+void ForEachChunk(ITaskPool* taskPool, uint32_t chunkCount, uint32_t first, uint32_t count, Func&& func) {
+	const auto RunChunk = [&](uint32_t chunk) {
+		const uint32_t begin = first + static_cast<uint32_t>(uint64_t(count) * chunk / chunkCount);
+		const uint32_t end   = first + static_cast<uint32_t>(uint64_t(count) * (chunk + 1) / chunkCount);
+		func(chunk, begin, end);
+	};
+
+	if (chunkCount <= 1) {
+		RunChunk(0);
+	} else {
+		taskPool->ParallelFor(chunkCount, RunChunk);
+	}
+}
+}  // namespace
+
+void LinearBVH::Build(const std::vector<AABB>& primitiveBounds, ITaskPool* taskPool) {
+	Clear();
+	if (primitiveBounds.empty()) { return; }
+
+	const uint32_t primitiveCount = static_cast<uint32_t>(primitiveBounds.size());
+	if (taskPool && (taskPool->GetThreadCount() < 2 || primitiveCount < ParallelBuildThreshold)) { taskPool = nullptr; }
+
+	// Infinite primitives (such as planes) would poison the surface area calculations, so clamp everything to a
+	// very large but finite box for the purposes of building.
+	const AABB limits(Point3(-UnboundedExtent), Point3(UnboundedExtent));
+	std::vector<BuildPrimitive> primitives(primitiveCount);
+	ForEachChunk(taskPool,
+	             GetChunkCount(taskPool, primitiveCount),
+	             0,
+	             primitiveCount,
+	             [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+		             for (uint32_t i = begin; i < end; ++i) {
+			             const AABB& bounds     = primitiveBounds[i];
+			             primitives[i].Bounds   = AABB(glm::clamp(bounds.Min, limits.Min, limits.Max),
+                                            glm::clamp(bounds.Max, limits.Min, limits.Max));
+			             primitives[i].Centroid = primitives[i].Bounds.Centroid();
+		             }
+	             });
+
+	_primitiveIndices.resize(primitives.size());
+	for (uint32_t i = 0; i < _primitiveIndices.size(); ++i) { _primitiveIndices[i] = i; }
+
+	BuildState state{primitives, taskPool};
+	if (taskPool) {
+		state.SubtreeSize = std::max(MinSubtreeSize, primitiveCount / (taskPool->GetThreadCount() * SubtreesPerThread));
+	} else {
+		_nodes.reserve(2 * primitives.size());
+	}
+	BuildRecursive(state, _nodes, 0, primitiveCount, 1);
+
+	if (!state.Subtrees.empty()) {
+		// Start on the biggest subtrees first, so no thread is left with a big one at the very end.
+		std::vector<uint32_t> order(state.Subtrees.size());
+		for (uint32_t i = 0; i < order.size(); ++i) { order[i] = i; }
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			return state.Subtrees[a].Count > state.Subtrees[b].Count;
+		});
+
+		taskPool->ParallelFor(static_cast<uint32_t>(order.size()), [&](uint32_t i) {
+			auto& subtree = state.Subtrees[order[i]];
+			BuildState subtreeState{primitives};
+			subtree.Nodes.reserve(2 * subtree.Count);
+			BuildRecursive(subtreeState, subtree.Nodes, subtree.First, subtree.Count, subtree.Depth);
+		});
+		StitchSubtrees(state.Subtrees);
+	}
+
+	_nodes.shrink_to_fit();
+	_nodeData  = _nodes.data();
+	_nodeCount = _nodes.size();
+	_buildCost = ComputeCost();
+}
+
+void LinearBVH::Refit(const std::vector<AABB>& leafOrderBounds) {
+	if (leafOrderBounds.size() != _primitiveIndices.size()) {
+		throw std::runtime_error("Cannot refit a BVH with a different number of primitives!");
+	}
+	if (_nodeData != _nodes.data()) { throw std::runtime_error("Cannot refit a BVH attached to external nodes!"); }
+
+	// Children are always stored after their parent, so walking the array backwards visits them first.
+	const AABB limits(Point3(-UnboundedExtent), Point3(UnboundedExtent));
+	for (size_t i = _nodes.size(); i-- > 0;) {
+		auto& node = _nodes[i];
+		AABB bounds;
+		if (node.IsLeaf()) {
+			for (uint32_t p = node.Offset; p < node.Offset + node.Count; ++p) {
+				bounds = bounds.Contain(AABB(glm::clamp(leafOrderBounds[p].Min, limits.Min, limits.Max),
+				                             glm::clamp(leafOrderBounds[p].Max, limits.Min, limits.Max)));
+			}
+			for (int axis = 0; axis < 3; ++axis) {
+				node.Min[axis] = RoundDown(bounds.Min[axis]);
+				node.Max[axis] = RoundUp(bounds.Max[axis]);
+			}
+		} else {
+			const auto& left  = _nodes[i + 1];
+			const auto& right = _nodes[node.Offset];
+			for (int axis = 0; axis < 3; ++axis) {
+				node.Min[axis] = std::min(left.Min[axis], right.Min[axis]);
+				node.Max[axis] = std::max(left.Max[axis], right.Max[axis]);
+			}
+		}
+	}
+}
+
+void LinearBVH::Attach(const LinearBVHNode* nodes, size_t nodeCount) {
+	// Working out the cost would read every node, while the point of attaching is to only touch the ones rays visit.
+	// An attached tree never gets refit, so there is nothing to compare it against anyway.
+	Clear();
+	_nodeData  = nodes;
+	_nodeCount = nodeCount;
+}
+
+void LinearBVH::Clear() {
+	_nodes.clear();
+	_nodeData  = nullptr;
+	_nodeCount = 0;
+	_primitiveIndices.clear();
+	_buildCost = 0.0;
+}
+
+double LinearBVH::ComputeCost() const {
+	if (_nodeCount == 0) { return 0.0; }
+
+	// Nodes holding unbounded primitives would drown out everything else and never change, so leave them out. The
+	// result is not divided by the root area either, as it is only ever compared against another cost of this tree.
+	double cost = 0.0;
+	for (const auto& node : GetNodes()) {
+		const AABB bounds(Point3(node.Min[0], node.Min[1], node.Min[2]), Point3(node.Max[0], node.Max[1], node.Max[2]));
+		const Vector3 extent = bounds.Max - bounds.Min;
+		if (std::max({extent.x, extent.y, extent.z}) >= Real(UnboundedExtent)) { continue; }
+
+		const double nodeCost = node.IsLeaf() ? IntersectionCost * node.Count : TraversalCost;
+		cost += nodeCost * bounds.SurfaceArea();
+	}
+
+	return cost;
+}
+
+AABB LinearBVH::GetBounds() const {
+	if (_nodeCount == 0) { return AABB(); }
+
+	const auto& root = _nodeData[0];
+	return AABB(Point3(root.Min[0], root.Min[1], root.Min[2]), Point3(root.Max[0], root.Max[1], root.Max[2]));
+}
+
+uint32_t LinearBVH::BuildRecursive(
+	BuildState& state, std::vector<LinearBVHNode>& nodes, uint32_t first, uint32_t count, uint32_t depth) {
+	const uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+	nodes.emplace_back();
+
+	// Deep enough into the tree that the rest of it can be left to a single thread.
+	if (state.TaskPool && count <= state.SubtreeSize) {
+		state.Subtrees.push_back({nodeIndex, first, count, depth});
+		return nodeIndex;
+	}
+
+	// Most nodes are binned by a single thread, and those should not have to allocate.
+	const auto& primitives    = state.Primitives;
+	const uint32_t chunkCount = GetChunkCount(state.TaskPool, count);
+	BinningResult singleChunk;
+	std::vector<BinningResult> manyChunks(chunkCount > 1 ? chunkCount : 0);
+	BinningResult* chunks = chunkCount > 1 ? manyChunks.data() : &singleChunk;
+
+	ForEachChunk(state.TaskPool, chunkCount, first, count, [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+		auto& result = chunks[chunk];
+		for (uint32_t i = begin; i < end; ++i) {
+			const auto& primitive = primitives[_primitiveIndices[i]];
+			result.Bounds         = result.Bounds.Contain(primitive.Bounds);
+			result.CentroidBounds = result.CentroidBounds.Contain(primitive.Centroid);
+		}
+	});
+
+	AABB bounds;
+	AABB centroidBounds;
+	for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) {
+		bounds         = bounds.Contain(chunks[chunk].Bounds);
+		centroidBounds = centroidBounds.Contain(chunks[chunk].CentroidBounds);
+	}
+
+	{
+		auto& node = nodes[nodeIndex];
+		for (int axis = 0; axis < 3; ++axis) {
+			node.Min[axis] = RoundDown(bounds.Min[axis]);
+			node.Max[axis] = RoundUp(bounds.Max[axis]);
+		}
+	}
+
+	const auto MakeLeaf = [&]() {
+		auto& node  = nodes[nodeIndex];
+		node.Offset = first;
+		node.Count  = static_cast<uint16_t>(count);
+		node.Axis   = 0;
+		return nodeIndex;
+	};
+
+	if (count <= 1) { return MakeLeaf(); }
+
+	// Bin the primitives along all three axes in a single pass.
+	std::array<double, 3> binScales;
+	for (int axis = 0; axis < 3; ++axis) {
+		const double extent = centroidBounds.Max[axis] - centroidBounds.Min[axis];
+		binScales[axis]     = extent > 0.0 ? BinCount / extent : 0.0;
+	}
+	ForEachChunk(state.TaskPool, chunkCount, first, count, [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+		auto& bins = chunks[chunk].Bins;
+		for (uint32_t i = begin; i < end; ++i) {
+			const auto& primitive = primitives[_primitiveIndices[i]];
+			for (int axis = 0; axis < 3; ++axis) {
+				const uint32_t bin = std::min(
+					BinCount - 1,
+					static_cast<uint32_t>((primitive.Centroid[axis] - centroidBounds.Min[axis]) * binScales[axis]));
+				bins[axis][bin].Bounds = bins[axis][bin].Bounds.Contain(primitive.Bounds);
+				++bins[axis][bin].Count;
+			}
+		}
+	});
+
+	// Find the cheapest split plane across all three axes using binned SAH.
+	const double leafCost = IntersectionCost * count;
+	const double areaInv  = 1.0 / std::max(bounds.SurfaceArea(), std::numeric_limits<double>::min());
+	double bestCost       = std::numeric_limits<double>::infinity();
+	int bestAxis          = -1;
+	uint32_t bestSplit    = 0;
+
+	for (int axis = 0; axis < 3; ++axis) {
+		if (binScales[axis] == 0.0) { continue; }
+
+		std::array<Bin, BinCount> bins = chunks[0].Bins[axis];
+		for (uint32_t chunk = 1; chunk < chunkCount; ++chunk) {
+			for (uint32_t i = 0; i < BinCount; ++i) {
+				bins[i].Bounds  = bins[i].Bounds.Contain(chunks[chunk].Bins[axis][i].Bounds);
+				bins[i].Count  += chunks[chunk].Bins[axis][i].Count;
+			}
+		}
+
+		// Sweep from the right to accumulate the cost of everything to the right of each split plane.
+		std::array<double, BinCount - 1> rightCosts;
+		AABB rightBounds;
+		uint32_t rightCount = 0;
+		for (uint32_t i = BinCount - 1; i > 0; --i) {
+			rightBounds       = rightBounds.Contain(bins[i].Bounds);
+			rightCount       += bins[i].Count;
+			rightCosts[i - 1] = rightCount * rightBounds.SurfaceArea();
+		}
+
+		AABB leftBounds;
+		uint32_t leftCount = 0;
+		for (uint32_t i = 0; i < BinCount - 1; ++i) {
+			leftBounds = leftBounds.Contain(bins[i].Bounds);
+			leftCount += bins[i].Count;
+			if (leftCount == 0 || leftCount == count) { continue; }
+
+			const double cost =
+				TraversalCost + IntersectionCost * (leftCount * leftBounds.SurfaceArea() + rightCosts[i]) * areaInv;
+			if (cost < bestCost) {
+				bestCost  = cost;
+				bestAxis  = axis;
+				bestSplit = i;
+			}
+		}
+	}
+
+	const bool tooDeep = depth >= MaxDepth;
+	if (tooDeep && count > MaxLeafCount) { throw std::runtime_error("BVH exceeded maximum depth!"); }
+	if (tooDeep || (count <= MaxLeafSize && leafCost <= bestCost)) { return MakeLeaf(); }
+
+	uint32_t mid = first;
+	if (bestAxis >= 0) {
+		const double cMin     = centroidBounds.Min[bestAxis];
+		const double binScale = binScales[bestAxis];
+		const auto InLeftHalf = [&](uint32_t index) {
+			const uint32_t bin =
+				std::min(BinCount - 1, static_cast<uint32_t>((primitives[index].Centroid[bestAxis] - cMin) * binScale));
+			return bin <= bestSplit;
+		};
+		const auto begin = _primitiveIndices.begin();
+		mid              = static_cast<uint32_t>(std::partition(begin + first, begin + first + count, InLeftHalf) - begin);
+	} else {
+		// Every centroid is in the same spot, so no split plane can separate them.
+		if (count <= MaxLeafCount) { return MakeLeaf(); }
+		bestAxis = 0;
+		mid      = first + count / 2;
+	}
+
+	BuildRecursive(state, nodes, first, mid - first, depth + 1);
+	const uint32_t right = BuildRecursive(state, nodes, mid, first + count - mid, depth + 1);
+
+	auto& node  = nodes[nodeIndex];
+	node.Offset = right;
+	node.Count  = 0;
+	node.Axis   = static_cast<uint16_t>(bestAxis);
+
+	return nodeIndex;
+}
+
+void LinearBVH::StitchSubtrees(std::vector<BuildSubtree>& subtrees) {
+	// Every subtree takes the place of its placeholder node, which pushes back all nodes that come after it. Subtrees
+	// were found depth-first, so they are already in the order their placeholders appear in.
+	std::vector<uint32_t> newIndices(_nodes.size());
+	size_t nodeCount = 0;
+	size_t subtree   = 0;
+	for (uint32_t i = 0; i < _nodes.size(); ++i) {
+		newIndices[i] = static_cast<uint32_t>(nodeCount);
+		if (subtree < subtrees.size() && subtrees[subtree].NodeIndex == i) {
+			nodeCount += subtrees[subtree++].Nodes.size();
+		} else {
+			++nodeCount;
+		}
+	}
+
+	std::vector<LinearBVHNode> nodes;
+	nodes.reserve(nodeCount);
+	subtree = 0;
+	for (uint32_t i = 0; i < _nodes.size(); ++i) {
+		if (subtree < subtrees.size() && subtrees[subtree].NodeIndex == i) {
+			const uint32_t base = newIndices[i];
+			for (auto node : subtrees[subtree++].Nodes) {
+				if (!node.IsLeaf()) { node.Offset += base; }
+				nodes.push_back(node);
+			}
+		} else {
+			auto node = _nodes[i];
+			if (!node.IsLeaf()) { node.Offset = newIndices[node.Offset]; }
+			nodes.push_back(node);
+		}
+	}
+
+	_nodes = std::move(nodes);
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "AABB.hpp"
+#include "DataTypes.hpp"
+#include "Ray.hpp"
+#include "RayPacket.hpp"
+
+class ITaskPool;
+
+// A single node of a flattened BVH. The left child of an interior node always immediately follows its parent in the
+// node array, so only the index of the right child needs to be stored.
+struct alignas(32) LinearBVHNode {
+	float Min[3];
+	uint32_t Offset;  // Leaf: index of the first primitive. Interior: index of the right child.
+	float Max[3];
+	uint16_t Count;  // Number of primitives in a leaf, 0 for interior nodes.
+	uint16_t Axis;   // Split axis of an interior node, used to pick the near child during traversal.
+
+	bool IsLeaf() const {
+		return Count > 0;
+	}
+};
+static_assert(sizeof(LinearBVHNode) == 32, "LinearBVHNode must fit in half a cache line!");
+
+// Bounding volume hierarchy built with the binned Surface Area Heuristic and stored as one contiguous node array.
+// The BVH only deals with primitive bounds; callers reorder their primitives according to PrimitiveIndices and
+// provide a leaf callback to intersect them.
+class LinearBVH {
+ public:
+	LinearBVH()                 = default;
+	LinearBVH(const LinearBVH&) = delete;
+	LinearBVH(LinearBVH&&)      = default;
+
+	LinearBVH& operator=(const LinearBVH&) = delete;
+	LinearBVH& operator=(LinearBVH&&)      = default;
+
+	// Given a task pool, large trees are built in parallel: the top levels bin their primitives on every thread, and
+	// the subtrees below are handed out as tasks of their own. The resulting tree is the same either way.
+	void Build(const std::vector<AABB>& primitiveBounds, ITaskPool* taskPool = nullptr);
+	// Recompute the node bounds bottom-up for primitives that moved, keeping the tree as it is. The bounds are given in
+	// leaf order, so primitiveBounds[i] belongs to GetPrimitiveIndices()[i].
+	void Refit(const std::vector<AABB>& leafOrderBounds);
+	// Use a tree that was built earlier and stored somewhere else, such as a memory-mapped scene cache, without copying
+	// it. The nodes must outlive the BVH, and the primitives are expected to be stored in leaf order already, so there
+	// are no primitive indices. An attached tree cannot be refit.
+	void Attach(const LinearBVHNode* nodes, size_t nodeCount);
+	void Clear();
+
+	// Area-weighted SAH cost of the tree as it is now, and as it was when it was built. A refitted tree only gets worse
+	// as its primitives move away from where the split planes were chosen, so the ratio tells when a rebuild is worth
+	// it. The costs are only meaningful relative to each other.
+	double ComputeCost() const;
+	double GetBuildCost() const {
+		return _buildCost;
+	}
+
+	AABB GetBounds() const;
+	size_t GetNodeCount() const {
+		return _nodeCount;
+	}
+	std::span<const LinearBVHNode> GetNodes() const {
+		return {_nodeData, _nodeCount};
+	}
+	const std::vector<uint32_t>& GetPrimitiveIndices() const {
+		return _primitiveIndices;
+	}
+
+	// Walk the hierarchy front-to-back. leafFunc(first, count, tMax) is called for every leaf whose bounds the ray
+	// enters, must return true if it recorded a closer hit, and must shrink tMax to the distance of that hit.
+	template <typename LeafFunc>
+	bool Intersect(const Ray& ray, Real tMin, Real tMax, LeafFunc&& leafFunc) const {
+		if (_nodeCount == 0) { return false; }
+
+		const float origin[3]    = {float(ray.Origin.x), float(ray.Origin.y), float(ray.Origin.z)};
+		const float invDir[3]    = {float(ray.InvDirection.x), float(ray.InvDirection.y), float(ray.InvDirection.z)};
+		const bool dirNegative[3] = {invDir[0] < 0.0f, invDir[1] < 0.0f, invDir[2] < 0.0f};
+
+		uint32_t stack[MaxDepth];
+		uint32_t stackSize = 0;
+		uint32_t nodeIndex = 0;
+		bool hitAnything   = false;
+
+		while (true) {
+			const LinearBVHNode& node = _nodeData[nodeIndex];
+			if (IntersectNode(node, origin, invDir, float(tMin), float(tMax))) {
+				if (node.IsLeaf()) {
+					hitAnything |= leafFunc(node.Offset, node.Count, tMax);
+				} else if (dirNegative[node.Axis]) {
+					stack[stackSize++] = nodeIndex + 1;
+					nodeIndex          = node.Offset;
+					continue;
+				} else {
+					stack[stackSize++] = node.Offset;
+					nodeIndex          = nodeIndex + 1;
+					continue;
+				}
+			}
+
+			if (stackSize == 0) { break; }
+			nodeIndex = stack[--stackSize];
+		}
+
+		return hitAnything;
+	}
+
+	// Walk the hierarchy until leafFunc(first, count) reports any hit at all, in no particular order. Meant for shadow
+	// rays, which only need to know whether something is in the way.
+	template <typename LeafFunc>
+	bool Occluded(const Ray& ray, Real tMin, Real tMax, LeafFunc&& leafFunc) const {
+		if (_nodeCount == 0) { return false; }
+
+		const float origin[3]     = {float(ray.Origin.x), float(ray.Origin.y), float(ray.Origin.z)};
+		const float invDir[3]     = {float(ray.InvDirection.x), float(ray.InvDirection.y), float(ray.InvDirection.z)};
+		const bool dirNegative[3] = {invDir[0] < 0.0f, invDir[1] < 0.0f, invDir[2] < 0.0f};
+
+		uint32_t stack[MaxDepth];
+		uint32_t stackSize = 0;
+		uint32_t nodeIndex = 0;
+
+		while (true) {
+			const LinearBVHNode& node = _nodeData[nodeIndex];
+			if (IntersectNode(node, origin, invDir, float(tMin), float(tMax))) {
+				if (node.IsLeaf()) {
+					if (leafFunc(node.Offset, node.Count)) { return true; }
+				} else if (dirNegative[node.Axis]) {
+					stack[stackSize++] = nodeIndex + 1;
+					nodeIndex          = node.Offset;
+					continue;
+				} else {
+					stack[stackSize++] = node.Offset;
+					nodeIndex          = nodeIndex + 1;
+					continue;
+				}
+			}
+
+			if (stackSize == 0) { break; }
+			nodeIndex = stack[--stackSize];
+		}
+
+		return false;
+	}
+
+	// Walk the hierarchy with a whole packet of rays at once, descending into a node if any lane enters its bounds.
+	// leafFunc(first, count, tMax) must return the mask of lanes that found a closer hit and update tMax for them.
+	template <typename LeafFunc>
+	SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax, LeafFunc&& leafFunc) const {
+		SimdMask hitMask = SimdMask::None();
+		if (_nodeCount == 0) { return hitMask; }
+
+		// Primary rays are coherent, so the first lane's direction is good enough to order the children for everyone.
+		const bool dirNegative[3] = {
+			packet.InvDirection[0][0] < 0.0f, packet.InvDirection[1][0] < 0.0f, packet.InvDirection[2][0] < 0.0f};
+
+		uint32_t stack[MaxDepth];
+		uint32_t stackSize = 0;
+		uint32_t nodeIndex = 0;
+
+		while (true) {
+			const LinearBVHNode& node = _nodeData[nodeIndex];
+			if (IntersectNodePacket(node, packet, tMin, tMax).Any()) {
+				if (node.IsLeaf()) {
+					hitMask = hitMask | leafFunc(node.Offset, node.Count, tMax);
+				} else if (dirNegative[node.Axis]) {
+					stack[stackSize++] = nodeIndex + 1;
+					nodeIndex          = node.Offset;
+					continue;
+				} else {
+					stack[stackSize++] = node.Offset;
+					nodeIndex          = nodeIndex + 1;
+					continue;
+				}
+			}
+
+			if (stackSize == 0) { break; }
+			nodeIndex = stack[--stackSize];
+		}
+
+		return hitMask;
+	}
+
+	static constexpr uint32_t MaxDepth = 64;
+
+ private:
+	struct BuildPrimitive {
+		AABB Bounds;
+		Point3 Centroid;
+	};
+
+	// A part of the tree small enough to be built by a single thread, into a node array of its own.
+	struct BuildSubtree {
+		uint32_t NodeIndex;  // Placeholder node in the top of the tree that this subtree replaces.
+		uint32_t First;
+		uint32_t Count;
+		uint32_t Depth;
+		std::vector<LinearBVHNode> Nodes;
+	};
+
+	struct BuildState {
+		const std::vector<BuildPrimitive>& Primitives;
+		ITaskPool* TaskPool  = nullptr;  // Only set while building the top of the tree.
+		uint32_t SubtreeSize = 0;
+		std::vector<BuildSubtree> Subtrees;
+	};
+
+	uint32_t BuildRecursive(
+		BuildState& state, std::vector<LinearBVHNode>& nodes, uint32_t first, uint32_t count, uint32_t depth);
+	void StitchSubtrees(std::vector<BuildSubtree>& subtrees);
+
+	static bool IntersectNode(
+		const LinearBVHNode& node, const float origin[3], const float invDir[3], float tMin, float tMax) {
+		for (int axis = 0; axis < 3; ++axis) {
+			const float t0 = (node.Min[axis] - origin[axis]) * invDir[axis];
+			const float t1 = (node.Max[axis] - origin[axis]) * invDir[axis];
+			tMin           = std::max(tMin, std::min(t0, t1));
+			tMax           = std::min(tMax, std::max(t0, t1));
+		}
+
+		return tMin <= tMax;
+	}
+
+	static SimdMask IntersectNodePacket(const LinearBVHNode& node,
+	                                    const RayPacket& packet,
+	                                    const SimdFloat& tMin,
+	                                    const SimdFloat& tMax) {
+		SimdFloat tNear = tMin;
+		SimdFloat tFar  = tMax;
+		for (int axis = 0; axis < 3; ++axis) {
+			const SimdFloat t0 = (SimdFloat(node.Min[axis]) - packet.Origin[axis]) * packet.InvDirection[axis];
+			const SimdFloat t1 = (SimdFloat(node.Max[axis]) - packet.Origin[axis]) * packet.InvDirection[axis];
+			tNear              = Max(tNear, Min(t0, t1));
+			tFar               = Min(tFar, Max(t0, t1));
+		}
+
+		return tNear <= tFar;
+	}
+
+	std::vector<LinearBVHNode> _nodes;
+	const LinearBVHNode* _nodeData = nullptr;  // Either _nodes, or the nodes of an attached tree.
+	size_t _nodeCount              = 0;
+	std::vector<uint32_t> _primitiveIndices;
+	double _buildCost = 0.0;
+};
@@ -1,8 +1,14 @@
 #include <Luna.hpp>
+#include <string_view>
 
+#include "Headless.hpp"
 #include "Rake.hpp"
 
 int main(int argc, const char** argv) {
+	for (int i = 1; i < argc; ++i) {
+		if (std::string_view(argv[i]) == "--headless") { return RunHeadless(argc, argv); }
+	}
+
 	auto app    = std::make_unique<Rake>();
 	auto engine = std::make_unique<Luna::Engine>();
 	engine->SetApp(app.get());
@@ -0,0 +1,189 @@
+#include "MappedFile.hpp"
+
+#include <Luna/Utility/Log.hpp>
+
+#ifdef _WIN32
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+
+#	include <cerrno>
+#	include <cstring>
+#endif
+
+using Luna::Log;
+
+MappedFile::~MappedFile() noexcept {
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& filename, size_t size, bool discard) {
+	Close();
+
+	_file = CreateFileA(filename.c_str(),
+	                    GENERIC_READ | GENERIC_WRITE,
+	                    FILE_SHARE_READ,
+	                    nullptr,
+	                    OPEN_ALWAYS,
+	                    FILE_ATTRIBUTE_NORMAL,
+	                    nullptr);
+	if (_file == INVALID_HANDLE_VALUE) {
+		_file = nullptr;
+		Log::Error("MappedFile", "Failed to open '{}' (error {}).", filename, GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	_existed = !discard && GetFileSizeEx(_file, &fileSize) && size_t(fileSize.QuadPart) == size;
+	if (!_existed && !(SetFilePointer(_file, 0, nullptr, FILE_BEGIN) == 0 && SetEndOfFile(_file))) {
+		Log::Error("MappedFile", "Failed to truncate '{}' (error {}).", filename, GetLastError());
+		Close();
+		return false;
+	}
+
+	// Creating a mapping bigger than the file grows the file, and the new bytes read as zero.
+	const DWORD sizeHigh = static_cast<DWORD>(uint64_t(size) >> 32);
+	const DWORD sizeLow  = static_cast<DWORD>(size & 0xffffffff);
+	_mapping             = CreateFileMappingA(_file, nullptr, PAGE_READWRITE, sizeHigh, sizeLow, nullptr);
+	if (_mapping) { _data = MapViewOfFile(_mapping, FILE_MAP_ALL_ACCESS, 0, 0, size); }
+	if (!_data) {
+		Log::Error("MappedFile", "Failed to map '{}' (error {}).", filename, GetLastError());
+		Close();
+		return false;
+	}
+	_size = size;
+
+	return true;
+}
+
+bool MappedFile::OpenRead(const std::string& filename) {
+	Close();
+
+	_file = CreateFileA(
+		filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (_file == INVALID_HANDLE_VALUE) {
+		_file = nullptr;
+		Log::Error("MappedFile", "Failed to open '{}' (error {}).", filename, GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart == 0) {
+		Log::Error("MappedFile", "Cannot map '{}', it is empty.", filename);
+		Close();
+		return false;
+	}
+
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping) { _data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0); }
+	if (!_data) {
+		Log::Error("MappedFile", "Failed to map '{}' (error {}).", filename, GetLastError());
+		Close();
+		return false;
+	}
+	_size    = size_t(fileSize.QuadPart);
+	_existed = true;
+
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data) { UnmapViewOfFile(_data); }
+	if (_mapping) { CloseHandle(_mapping); }
+	if (_file) { CloseHandle(_file); }
+	_data    = nullptr;
+	_mapping = nullptr;
+	_file    = nullptr;
+	_size    = 0;
+}
+
+bool MappedFile::Flush(bool wait) {
+	if (!_data) { return false; }
+
+	// FlushViewOfFile only hands the pages to the system, waiting on them takes a flush of the file itself.
+	if (!FlushViewOfFile(_data, 0)) { return false; }
+
+	return !wait || FlushFileBuffers(_file);
+}
+#else
+bool MappedFile::Open(const std::string& filename, size_t size, bool discard) {
+	Close();
+
+	_file = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+	if (_file < 0) {
+		Log::Error("MappedFile", "Failed to open '{}': {}", filename, std::strerror(errno));
+		return false;
+	}
+
+	struct stat fileStat;
+	_existed = !discard && fstat(_file, &fileStat) == 0 && size_t(fileStat.st_size) == size;
+
+	// Growing an empty file leaves a hole, which reads as zero and takes no disk space until written to.
+	if (!_existed && (ftruncate(_file, 0) != 0 || ftruncate(_file, static_cast<off_t>(size)) != 0)) {
+		Log::Error("MappedFile", "Failed to resize '{}' to {} bytes: {}", filename, size, std::strerror(errno));
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+	if (data == MAP_FAILED) {
+		Log::Error("MappedFile", "Failed to map '{}': {}", filename, std::strerror(errno));
+		Close();
+		return false;
+	}
+	_data = data;
+	_size = size;
+
+	return true;
+}
+
+bool MappedFile::OpenRead(const std::string& filename) {
+	Close();
+
+	_file = open(filename.c_str(), O_RDONLY);
+	if (_file < 0) {
+		Log::Error("MappedFile", "Failed to open '{}': {}", filename, std::strerror(errno));
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(_file, &fileStat) != 0 || fileStat.st_size == 0) {
+		Log::Error("MappedFile", "Cannot map '{}', it is empty.", filename);
+		Close();
+		return false;
+	}
+
+	const size_t size = size_t(fileStat.st_size);
+	void* data        = mmap(nullptr, size, PROT_READ, MAP_SHARED, _file, 0);
+	if (data == MAP_FAILED) {
+		Log::Error("MappedFile", "Failed to map '{}': {}", filename, std::strerror(errno));
+		Close();
+		return false;
+	}
+	_data    = data;
+	_size    = size;
+	_existed = true;
+
+	return true;
+}
+
+void MappedFile::Close() {
+	if (_data) { munmap(_data, _size); }
+	if (_file >= 0) { close(_file); }
+	_data = nullptr;
+	_file = -1;
+	_size = 0;
+}
+
+bool MappedFile::Flush(bool wait) {
+	if (!_data) { return false; }
+
+	return msync(_data, _size, wait ? MS_SYNC : MS_ASYNC) == 0;
+}
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A file mapped into memory for reading and writing, or for reading only. Writes to the memory end up in the file even
+// if the process dies before it gets to close it, while Flush also gets them onto the disk to survive the whole machine
+// going down.
+class MappedFile {
+ public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	~MappedFile() noexcept;
+
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps size bytes of the file, creating it if it does not exist yet. A file of any other size, or any file at all
+	// if discard is set, is started over with size zero bytes. Returns false and logs the reason if the file could not
+	// be mapped.
+	bool Open(const std::string& filename, size_t size, bool discard = false);
+	// Maps the whole of an existing file as read-only memory. Returns false and logs the reason if it could not be
+	// mapped, which includes the file being empty.
+	bool OpenRead(const std::string& filename);
+	void Close();
+	// Starts writing every modified page out to disk. Unless wait is set, this returns before the writes are done.
+	bool Flush(bool wait = false);
+
+	bool IsOpen() const {
+		return _data != nullptr;
+	}
+	void* GetData() const {
+		return _data;
+	}
+	size_t GetSize() const {
+		return _size;
+	}
+	// Whether Open found an existing file of the requested size, rather than starting one over.
+	bool Existed() const {
+		return _existed;
+	}
+
+ private:
+	void* _data   = nullptr;
+	size_t _size  = 0;
+	bool _existed = false;
+#ifdef _WIN32
+	void* _file    = nullptr;
+	void* _mapping = nullptr;
+#else
+	int _file = -1;
+#endif
+};
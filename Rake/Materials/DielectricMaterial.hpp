@@ -2,15 +2,19 @@
 
 #include "IMaterial.hpp"
 
-class DielectricMaterial : public IMaterial {
+class DielectricMaterial final : public IMaterial {
  public:
-	DielectricMaterial(double index);
+	DielectricMaterial(Real index);
 
+	virtual MaterialType GetType() const override {
+		return MaterialType::Dielectric;
+	}
 	virtual Color Emit(const Point2& uv, const Point3& p) const override;
-	virtual bool Scatter(const Ray& ray, const HitRecord& hit, Color& outAttenuation, Ray& outScattered) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual bool Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const override;
 
-	double IndexOfRefraction;
+	Real IndexOfRefraction;
 
  private:
-	static double Reflectance(double cosine, double refIndex);
+	static Real Reflectance(Real cosine, Real refIndex);
 };
@@ -10,9 +10,11 @@ Color DiffuseLightMaterial::Emit(const Point2& uv, const Point3& p) const {
 	return Texture->Sample(uv, p);
 }
 
-bool DiffuseLightMaterial::Scatter(const Ray& ray,
-                                   const HitRecord& hit,
-                                   Color& outAttenuation,
-                                   Ray& outScattered) const {
+bool DiffuseLightMaterial::Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const {
 	return false;
 }
+
+void DiffuseLightMaterial::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(GetType());
+	HashTexture(hasher, Texture.get());
+}
@@ -5,13 +5,17 @@
 #include "IMaterial.hpp"
 #include "ITexture.hpp"
 
-class DiffuseLightMaterial : public IMaterial {
+class DiffuseLightMaterial final : public IMaterial {
  public:
 	DiffuseLightMaterial(const std::shared_ptr<ITexture>& texture);
 	DiffuseLightMaterial(const Color& color);
 
+	virtual MaterialType GetType() const override {
+		return MaterialType::DiffuseLight;
+	}
 	virtual Color Emit(const Point2& uv, const Point3& p) const override;
-	virtual bool Scatter(const Ray& ray, const HitRecord& hit, Color& outAttenuation, Ray& outScattered) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual bool Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const override;
 
 	std::shared_ptr<ITexture> Texture;
 };
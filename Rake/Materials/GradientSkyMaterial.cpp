@@ -1,11 +1,20 @@
 #include "GradientSkyMaterial.hpp"
 
+#include <string_view>
+
 #include "Ray.hpp"
 
-GradientSkyMaterial::GradientSkyMaterial(const Color& a, const Color& b, double gradient)
+GradientSkyMaterial::GradientSkyMaterial(const Color& a, const Color& b, Real gradient)
 		: AlbedoA(a), AlbedoB(b), Gradient(gradient) {}
 
 Color GradientSkyMaterial::Sample(const Ray& ray) const {
 	const float t = Gradient * (ray.Direction.y + 1.0f);
 	return (1.0f - t) * AlbedoA + t * AlbedoB;
 }
+
+void GradientSkyMaterial::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(std::string_view("GradientSky"));
+	hasher.Data(sizeof(AlbedoA), &AlbedoA);
+	hasher.Data(sizeof(AlbedoB), &AlbedoB);
+	hasher(Gradient);
+}
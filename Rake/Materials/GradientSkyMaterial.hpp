@@ -4,11 +4,12 @@
 
 class GradientSkyMaterial : public ISkyMaterial {
  public:
-	GradientSkyMaterial(const Color& a, const Color& b, double gradient);
+	GradientSkyMaterial(const Color& a, const Color& b, Real gradient);
 
 	virtual Color Sample(const Ray& ray) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
 
 	Color AlbedoA;
 	Color AlbedoB;
-	double Gradient;
+	Real Gradient;
 };
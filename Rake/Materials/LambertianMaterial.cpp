@@ -12,11 +12,32 @@ Color LambertianMaterial::Emit(const Point2& uv, const Point3& p) const {
 	return Color(0.0);
 }
 
-bool LambertianMaterial::Scatter(const Ray& ray, const HitRecord& hit, Color& outAttenuation, Ray& outScattered) const {
-	Point3 target = RandomInHemisphere(hit.Normal);
-	if (glm::length(target) < 0.001) { target = hit.Normal; }
-	outAttenuation = Texture->Sample(hit.UV, hit.Point);
-	outScattered   = Ray(hit.Point, glm::normalize(target));
+bool LambertianMaterial::Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const {
+	// Seen from where it touches the surface, a uniform point on the unit sphere resting on it lies in a direction
+	// with density cos / pi. That cancels out with the cosine in Eval, leaving the albedo as the attenuation.
+	Vector3 direction = hit.Normal + RandomUnitVector();
+	const Real length = glm::length(direction);
+	direction         = length > 1e-6 ? direction / length : hit.Normal;
 
-	return true;
+	outScatter.Scattered   = hit.SpawnRay(direction);
+	outScatter.Attenuation = Texture->Sample(hit.UV, hit.Point);
+	outScatter.Pdf         = Pdf(ray, hit, direction);
+
+	return outScatter.Pdf > 0.0;
+}
+
+Color LambertianMaterial::Eval(const Ray& ray, const HitRecord& hit, const Vector3& direction) const {
+	const Real cosine = glm::dot(direction, hit.Normal);
+	if (cosine <= 0.0) { return Color(0.0f); }
+
+	return Texture->Sample(hit.UV, hit.Point) * float(cosine / Pi);
+}
+
+Real LambertianMaterial::Pdf(const Ray& ray, const HitRecord& hit, const Vector3& direction) const {
+	return glm::max(glm::dot(direction, hit.Normal), Real(0)) / Pi;
+}
+
+void LambertianMaterial::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(GetType());
+	HashTexture(hasher, Texture.get());
 }
@@ -5,13 +5,22 @@
 #include "IMaterial.hpp"
 #include "ITexture.hpp"
 
-class LambertianMaterial : public IMaterial {
+class LambertianMaterial final : public IMaterial {
  public:
 	LambertianMaterial(const Color& albedo);
 	LambertianMaterial(const std::shared_ptr<ITexture>& texture);
 
+	virtual MaterialType GetType() const override {
+		return MaterialType::Lambertian;
+	}
 	virtual Color Emit(const Point2& uv, const Point3& p) const override;
-	virtual bool Scatter(const Ray& ray, const HitRecord& hit, Color& outAttenuation, Ray& outScattered) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual bool Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const override;
+	virtual bool IsSpecular() const override {
+		return false;
+	}
+	virtual Color Eval(const Ray& ray, const HitRecord& hit, const Vector3& direction) const override;
+	virtual Real Pdf(const Ray& ray, const HitRecord& hit, const Vector3& direction) const override;
 
 	std::shared_ptr<ITexture> Texture;
 };
@@ -1,19 +1,145 @@
 #include "MetalMaterial.hpp"
 
+#include <cmath>
+
 #include "IHittable.hpp"
 #include "Random.hpp"
-#include "Ray.hpp"
 
-MetalMaterial::MetalMaterial(const Color& albedo, double roughness) : Albedo(albedo), Roughness(roughness) {}
+namespace {
+// Lobes are worked out in a frame around the normal, which is the z axis in there.
+struct ShadingFrame {
+	explicit ShadingFrame(const Vector3& normal) : Normal(normal) {
+		// Duff et al., "Building an Orthonormal Basis, Revisited".
+		const Real sign = std::copysign(Real(1), normal.z);
+		const Real a    = -1 / (sign + normal.z);
+		const Real b    = normal.x * normal.y * a;
+		Tangent         = Vector3(1 + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		Bitangent       = Vector3(b, sign + normal.y * normal.y * a, -normal.y);
+	}
+
+	Vector3 ToLocal(const Vector3& v) const {
+		return Vector3(glm::dot(v, Tangent), glm::dot(v, Bitangent), glm::dot(v, Normal));
+	}
+	Vector3 ToWorld(const Vector3& v) const {
+		return Tangent * v.x + Bitangent * v.y + Normal * v.z;
+	}
+
+	Vector3 Tangent;
+	Vector3 Bitangent;
+	Vector3 Normal;
+};
+
+// Density of microfacet normals facing along h.
+Real GGX(const Vector3& h, Real alpha) {
+	const Real alpha2 = alpha * alpha;
+	const Real t      = (h.x * h.x + h.y * h.y) / alpha2 + h.z * h.z;
+
+	return 1 / (Pi * alpha2 * t * t);
+}
+
+// Smith's auxiliary function, for the microfacets that w is shadowed or masked by.
+Real SmithLambda(const Vector3& w, Real alpha) {
+	const Real tan2 = (w.x * w.x + w.y * w.y) / (w.z * w.z);
+
+	return (glm::sqrt(1 + alpha * alpha * tan2) - 1) / 2;
+}
+
+Color SchlickFresnel(const Color& f0, Real cosine) {
+	const float m  = float(glm::clamp(1 - cosine, Real(0), Real(1)));
+	const float m2 = m * m;
+
+	return f0 + (Color(1.0f) - f0) * (m2 * m2 * m);
+}
+
+// Heitz, "Sampling the GGX Distribution of Visible Normals": picks a microfacet normal among the ones wo can see,
+// in proportion to how much of them it sees.
+Vector3 SampleVisibleNormal(const Vector3& wo, Real alpha, Real u1, Real u2) {
+	const Vector3 stretched = glm::normalize(Vector3(alpha * wo.x, alpha * wo.y, wo.z));
+	const Real length2      = stretched.x * stretched.x + stretched.y * stretched.y;
+	const Vector3 t1 = length2 > 0 ? Vector3(-stretched.y, stretched.x, 0) / glm::sqrt(length2) : Vector3(1, 0, 0);
+	const Vector3 t2 = glm::cross(stretched, t1);
+
+	const Real r   = glm::sqrt(u1);
+	const Real phi = 2 * Pi * u2;
+	const Real p1  = r * std::cos(phi);
+	const Real s   = (1 + stretched.z) / 2;
+	const Real p2  = (1 - s) * glm::sqrt(glm::max(Real(0), 1 - p1 * p1)) + s * r * std::sin(phi);
+	const Vector3 n = p1 * t1 + p2 * t2 + glm::sqrt(glm::max(Real(0), 1 - p1 * p1 - p2 * p2)) * stretched;
+
+	return glm::normalize(Vector3(alpha * n.x, alpha * n.y, glm::max(Real(0), n.z)));
+}
+}  // namespace
+
+MetalMaterial::MetalMaterial(const Color& albedo, Real roughness) : Albedo(albedo), Roughness(roughness) {}
 
 Color MetalMaterial::Emit(const Point2& uv, const Point3& p) const {
 	return Color(0.0);
 }
 
-bool MetalMaterial::Scatter(const Ray& ray, const HitRecord& hit, Color& outAttenuation, Ray& outScattered) const {
-	const Vector3 reflected = glm::reflect(glm::normalize(ray.Direction), hit.Normal) + Roughness * RandomInUnitSphere();
-	outAttenuation          = Albedo;
-	outScattered            = Ray(hit.Point, glm::normalize(reflected));
+bool MetalMaterial::Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const {
+	const Vector3 view = -glm::normalize(ray.Direction);
+	if (IsSpecular()) {
+		const Vector3 reflected = glm::reflect(-view, hit.Normal);
+		outScatter.Scattered    = hit.SpawnRay(reflected);
+		outScatter.Attenuation  = SchlickFresnel(Albedo, glm::dot(view, hit.Normal));
+		outScatter.Pdf          = 0.0;
+
+		return true;
+	}
+
+	const ShadingFrame frame(hit.Normal);
+	const Vector3 wo = frame.ToLocal(view);
+	if (wo.z <= 0.0) { return false; }
+
+	double u[2];
+	ThreadSampler().NextDoubles(u, 2);
+	const Real alpha  = GetAlpha();
+	const Vector3 h   = SampleVisibleNormal(wo, alpha, Real(u[0]), Real(u[1]));
+	const Real cosine = glm::dot(wo, h);
+	const Vector3 wi  = 2 * cosine * h - wo;
+	if (wi.z <= 0.0) { return false; }
+
+	// With visible normals sampled, everything but the Fresnel term and the shadowing of the light cancels out.
+	const Real lambdaO     = SmithLambda(wo, alpha);
+	const Real lambdaI     = SmithLambda(wi, alpha);
+	const Real shadowing   = (1 + lambdaO) / (1 + lambdaO + lambdaI);
+	const Vector3 world    = glm::normalize(frame.ToWorld(wi));
+	outScatter.Scattered   = hit.SpawnRay(world);
+	outScatter.Attenuation = SchlickFresnel(Albedo, cosine) * float(shadowing);
+	outScatter.Pdf         = GGX(h, alpha) / (4 * (1 + lambdaO) * wo.z);
+
+	return outScatter.Pdf > 0.0;
+}
+
+Color MetalMaterial::Eval(const Ray& ray, const HitRecord& hit, const Vector3& direction) const {
+	const ShadingFrame frame(hit.Normal);
+	const Vector3 wo = frame.ToLocal(-glm::normalize(ray.Direction));
+	const Vector3 wi = frame.ToLocal(direction);
+	if (wo.z <= 0.0 || wi.z <= 0.0) { return Color(0.0f); }
+
+	const Real alpha = GetAlpha();
+	const Vector3 h  = glm::normalize(wo + wi);
+	const Real g     = 1 / (1 + SmithLambda(wo, alpha) + SmithLambda(wi, alpha));
+
+	// D G F / (4 cos(o) cos(i)), times cos(i).
+	return SchlickFresnel(Albedo, glm::dot(wi, h)) * float(GGX(h, alpha) * g / (4 * wo.z));
+}
+
+Real MetalMaterial::Pdf(const Ray& ray, const HitRecord& hit, const Vector3& direction) const {
+	const ShadingFrame frame(hit.Normal);
+	const Vector3 wo = frame.ToLocal(-glm::normalize(ray.Direction));
+	const Vector3 wi = frame.ToLocal(direction);
+	if (wo.z <= 0.0 || wi.z <= 0.0) { return 0.0; }
+
+	// The density of visible normals, G1(o) D(h) o.h / cos(o), over the 4 o.h that reflecting about h stretches it by.
+	const Real alpha = GetAlpha();
+	const Vector3 h  = glm::normalize(wo + wi);
+
+	return GGX(h, alpha) / (4 * (1 + SmithLambda(wo, alpha)) * wo.z);
+}
 
-	return glm::dot(outScattered.Direction, hit.Normal) > 0.0;
+void MetalMaterial::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(GetType());
+	hasher.Data(sizeof(Albedo), &Albedo);
+	hasher(Roughness);
 }
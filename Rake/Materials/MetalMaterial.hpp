@@ -2,13 +2,33 @@
 
 #include "IMaterial.hpp"
 
-class MetalMaterial : public IMaterial {
+// A conductor, with a GGX microfacet distribution for its roughness. Albedo is the reflectance straight on, which
+// rises towards white at grazing angles. Rough metals are importance sampled through the normals the viewer can see,
+// and take part in next-event estimation, while a roughness of 0 makes a perfect mirror.
+class MetalMaterial final : public IMaterial {
  public:
-	MetalMaterial(const Color& albedo, double roughness);
+	MetalMaterial(const Color& albedo, Real roughness);
 
+	virtual MaterialType GetType() const override {
+		return MaterialType::Metal;
+	}
 	virtual Color Emit(const Point2& uv, const Point3& p) const override;
-	virtual bool Scatter(const Ray& ray, const HitRecord& hit, Color& outAttenuation, Ray& outScattered) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual bool Scatter(const Ray& ray, const HitRecord& hit, ScatterRecord& outScatter) const override;
+	virtual bool IsSpecular() const override {
+		return Roughness <= 0.0;
+	}
+	virtual Color Eval(const Ray& ray, const HitRecord& hit, const Vector3& direction) const override;
+	virtual Real Pdf(const Ray& ray, const HitRecord& hit, const Vector3& direction) const override;
 
 	Color Albedo;
-	double Roughness;
+	Real Roughness;  // Perceptual roughness, the square root of the GGX alpha.
+
+ private:
+	Real GetAlpha() const {
+		return glm::max(Roughness * Roughness, MinAlpha);
+	}
+
+	// Narrower lobes than this are all but mirrors, and run out of precision.
+	static constexpr Real MinAlpha = 1e-3;
 };
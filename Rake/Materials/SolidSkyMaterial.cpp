@@ -1,15 +1,85 @@
 #include "SolidSkyMaterial.hpp"
 
+#include <cmath>
+#include <string_view>
+
+#include "ImageTexture.hpp"
 #include "Ray.hpp"
 #include "SolidTexture.hpp"
 
-SolidSkyMaterial::SolidSkyMaterial(const std::shared_ptr<ITexture>& texture) : Texture(texture) {}
+namespace {
+// The equirectangular mapping: u runs once around the horizon, and v from straight down at 0 to straight up at 1.
+Point2 GetUV(const Vector3& direction) {
+	return Point2(std::atan2(direction.z, direction.x) / (2 * Pi) + 0.5,
+	              std::asin(glm::clamp(direction.y, Real(-1), Real(1))) / Pi + 0.5);
+}
+
+// Image rows run from the top of the sky down, the other way around from v.
+glm::uvec2 GetPixel(const Point2& uv, const glm::uvec2& size) {
+	const auto x = glm::clamp(static_cast<unsigned int>(uv.x * size.x), 0u, size.x - 1);
+	const auto y = glm::clamp(static_cast<unsigned int>((1 - uv.y) * size.y), 0u, size.y - 1);
+
+	return glm::uvec2(x, y);
+}
+
+// Turns a density over the image into one over solid angle. A pixel near the poles covers less of the sphere than
+// one at the horizon, by the cosine of its elevation.
+Real ToSolidAngle(float pixelPdf, const glm::uvec2& size, Real cosElevation) {
+	if (cosElevation <= 0.0) { return 0.0; }
+
+	return Real(pixelPdf) * size.x * size.y / (2 * Pi * Pi * cosElevation);
+}
+}  // namespace
+
+SolidSkyMaterial::SolidSkyMaterial(const std::shared_ptr<ITexture>& texture) : Texture(texture) {
+	const auto* image = dynamic_cast<const ImageTexture*>(texture.get());
+	if (!image || image->Pixels.empty()) { return; }
+
+	// Weigh every pixel by how much light it sends, which is its luminance times the solid angle it covers.
+	_size = image->Size;
+	std::vector<double> weights(image->Pixels.size());
+	for (uint32_t y = 0; y < _size.y; ++y) {
+		const double elevation = (0.5 - (y + 0.5) / _size.y) * Pi;
+		const double area      = std::cos(elevation);
+		for (uint32_t x = 0; x < _size.x; ++x) {
+			const size_t pixel = size_t(y) * _size.x + x;
+			weights[pixel]     = double(Luminance(image->Pixels[pixel])) * area;
+		}
+	}
+	_distribution = AliasTable(weights);
+}
 
 SolidSkyMaterial::SolidSkyMaterial(const Color& color) : Texture(std::make_shared<SolidTexture>(color)) {}
 
 Color SolidSkyMaterial::Sample(const Ray& ray) const {
-	const auto uv =
-		(Point2(glm::atan(ray.Direction.z, ray.Direction.x), glm::asin(ray.Direction.y)) * Point2(0.1591, 0.3183)) +
-		Point2(0.5);
-	return Texture->Sample(uv, ray.Direction);
+	return Texture->Sample(GetUV(ray.Direction), ray.Direction);
+}
+
+bool SolidSkyMaterial::SampleDirection(const double u[3], Vector3& outDirection, Real& outPdf) const {
+	if (_distribution.Empty()) { return false; }
+
+	// Pick a pixel, then a spot within it.
+	const uint32_t pixel = _distribution.Sample(u[0]);
+	const Point2 uv((pixel % _size.x + Real(u[1])) / _size.x, 1 - (pixel / _size.x + Real(u[2])) / _size.y);
+	const Real elevation    = (uv.y - Real(0.5)) * Pi;
+	const Real azimuth      = (uv.x - Real(0.5)) * 2 * Pi;
+	const Real cosElevation = std::cos(elevation);
+	outDirection = Vector3(cosElevation * std::cos(azimuth), std::sin(elevation), cosElevation * std::sin(azimuth));
+	outPdf       = ToSolidAngle(_distribution.GetPdf(pixel), _size, cosElevation);
+
+	return outPdf > 0.0;
+}
+
+Real SolidSkyMaterial::Pdf(const Vector3& direction) const {
+	if (_distribution.Empty()) { return 0.0; }
+
+	const glm::uvec2 pixel  = GetPixel(GetUV(direction), _size);
+	const Real cosElevation = glm::sqrt(glm::max(Real(0), 1 - direction.y * direction.y));
+
+	return ToSolidAngle(_distribution.GetPdf(pixel.y * _size.x + pixel.x), _size, cosElevation);
+}
+
+void SolidSkyMaterial::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(std::string_view("SolidSky"));
+	HashTexture(hasher, Texture.get());
 }
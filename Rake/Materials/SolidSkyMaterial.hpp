@@ -2,9 +2,13 @@
 
 #include <memory>
 
+#include "AliasTable.hpp"
 #include "ISkyMaterial.hpp"
 #include "ITexture.hpp"
 
+// A sky that looks the same from everywhere, either one color or an equirectangular image such as an HDR environment
+// map. Images are importance sampled by the luminance of their pixels, using a distribution built when the material
+// is constructed.
 class SolidSkyMaterial : public ISkyMaterial {
  public:
 	SolidSkyMaterial() = default;
@@ -12,6 +16,16 @@ class SolidSkyMaterial : public ISkyMaterial {
 	SolidSkyMaterial(const Color& color);
 
 	virtual Color Sample(const Ray& ray) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual bool IsImportanceSampled() const override {
+		return !_distribution.Empty();
+	}
+	virtual bool SampleDirection(const double u[3], Vector3& outDirection, Real& outPdf) const override;
+	virtual Real Pdf(const Vector3& direction) const override;
 
 	std::shared_ptr<ITexture> Texture;
+
+ private:
+	glm::uvec2 _size = glm::uvec2(0);
+	AliasTable _distribution;  // Over the pixels of an image texture, in the order the image stores them.
 };
@@ -0,0 +1,858 @@
+#include "MeshLoader.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <string_view>
+
+#include "ITaskPool.hpp"
+
+using Luna::Log;
+
+namespace {
+// Face indices from OBJ chunks that were relative to the end of the vertex list are stored with this offset added,
+// and resolved once we know how many vertices came before the chunk.
+constexpr int64_t RelativeIndex = int64_t(1) << 62;
+
+// One chunk per task pool thread, or a single chunk when parsing on the calling thread alone.
+uint32_t GetChunkCount(ITaskPool* taskPool) {
+	return taskPool ? std::max(taskPool->GetThreadCount(), 1u) : 1u;
+}
+
+// Run func(chunk) for every chunk in [0, chunkCount), spread across the task pool if there is one.
+void ParallelChunks(ITaskPool* taskPool, size_t chunkCount, const std::function<void(uint32_t)>& func) {
+	if (taskPool) {
+		taskPool->ParallelFor(uint32_t(chunkCount), func);
+	} else {
+		for (uint32_t chunk = 0; chunk < chunkCount; ++chunk) { func(chunk); }
+	}
+}
+
+bool ReadFile(const std::string& filename, std::string& outData) {
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (!file) { return false; }
+
+	const auto size = file.tellg();
+	outData.resize(static_cast<size_t>(size));
+	file.seekg(0);
+	file.read(outData.data(), size);
+
+	return static_cast<bool>(file);
+}
+
+std::string_view GetExtension(std::string_view filename) {
+	const auto dot = filename.find_last_of('.');
+	return dot == std::string_view::npos ? std::string_view() : filename.substr(dot + 1);
+}
+
+bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Tokenizer over a single line of text.
+class LineParser {
+ public:
+	LineParser(std::string_view line) : _line(line) {}
+
+	std::string_view NextToken() {
+		while (_position < _line.size() && IsSpace(_line[_position])) { ++_position; }
+		const size_t begin = _position;
+		while (_position < _line.size() && !IsSpace(_line[_position])) { ++_position; }
+
+		return _line.substr(begin, _position - begin);
+	}
+
+	template <typename T>
+	bool Next(T& outValue) {
+		const auto token  = NextToken();
+		const auto result = std::from_chars(token.data(), token.data() + token.size(), outValue);
+
+		return !token.empty() && result.ec == std::errc() && result.ptr == token.data() + token.size();
+	}
+
+ private:
+	std::string_view _line;
+	size_t _position = 0;
+};
+
+// Pull the next line out of text, advancing position past its line break.
+std::string_view NextLine(std::string_view text, size_t& position) {
+	const size_t begin = position;
+	const size_t end   = text.find('\n', begin);
+	position           = end == std::string_view::npos ? text.size() : end + 1;
+
+	return text.substr(begin, (end == std::string_view::npos ? text.size() : end) - begin);
+}
+
+// Cut text into chunkCount pieces of roughly equal size, each ending on a line break.
+std::vector<std::string_view> SplitLines(std::string_view text, size_t chunkCount) {
+	std::vector<std::string_view> chunks;
+	size_t begin = 0;
+	for (size_t i = 1; i <= chunkCount && begin < text.size(); ++i) {
+		size_t end = i == chunkCount ? text.size() : std::max(begin, text.size() * i / chunkCount);
+		end        = text.find('\n', end);
+		end        = end == std::string_view::npos ? text.size() : end + 1;
+		chunks.push_back(text.substr(begin, end - begin));
+		begin = end;
+	}
+
+	return chunks;
+}
+
+/* ======================
+ * Wavefront OBJ
+ * ====================== */
+
+struct ObjChunk {
+	std::array<std::vector<float>, 3> Positions;
+	std::array<std::vector<float>, 3> Normals;
+	std::array<std::vector<float>, 2> UVs;
+	std::vector<int64_t> PositionIndices;
+	std::vector<int64_t> NormalIndices;
+	std::vector<int64_t> UVIndices;
+	bool AllNormals  = true;
+	bool AllUVs      = true;
+	size_t ErrorLine = 0;  // Line within the chunk of the first malformed statement, counting from 1.
+};
+
+// Convert an OBJ index (1-based, or negative to count back from the latest vertex) into our stored form.
+bool StoreObjIndex(int64_t index, size_t chunkCount, int64_t& outIndex) {
+	if (index > 0) {
+		outIndex = index - 1;
+	} else if (index < 0) {
+		outIndex = RelativeIndex + static_cast<int64_t>(chunkCount) + index;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+bool ParseObjFace(LineParser& parser, ObjChunk& chunk) {
+	struct Corner {
+		int64_t Position = 0;
+		int64_t UV       = 0;
+		int64_t Normal   = 0;
+		bool HasUV       = false;
+		bool HasNormal   = false;
+	};
+	std::vector<Corner> corners;
+
+	for (auto token = parser.NextToken(); !token.empty(); token = parser.NextToken()) {
+		Corner corner;
+		std::string_view parts[3];
+		for (int part = 0; part < 3; ++part) {
+			const auto slash = token.find('/');
+			parts[part]      = token.substr(0, slash);
+			if (slash == std::string_view::npos) { break; }
+			token = token.substr(slash + 1);
+		}
+
+		const auto ParseIndex = [](std::string_view text, size_t count, int64_t& outIndex) {
+			int64_t index     = 0;
+			const auto result = std::from_chars(text.data(), text.data() + text.size(), index);
+			return result.ec == std::errc() && result.ptr == text.data() + text.size() &&
+			       StoreObjIndex(index, count, outIndex);
+		};
+		if (!ParseIndex(parts[0], chunk.Positions[0].size(), corner.Position)) { return false; }
+		if (!parts[1].empty()) {
+			if (!ParseIndex(parts[1], chunk.UVs[0].size(), corner.UV)) { return false; }
+			corner.HasUV = true;
+		}
+		if (!parts[2].empty()) {
+			if (!ParseIndex(parts[2], chunk.Normals[0].size(), corner.Normal)) { return false; }
+			corner.HasNormal = true;
+		}
+		corners.push_back(corner);
+	}
+	if (corners.size() < 3) { return false; }
+
+	for (size_t i = 1; i + 1 < corners.size(); ++i) {
+		for (const auto& corner : {corners[0], corners[i], corners[i + 1]}) {
+			chunk.PositionIndices.push_back(corner.Position);
+			chunk.UVIndices.push_back(corner.UV);
+			chunk.NormalIndices.push_back(corner.Normal);
+			chunk.AllUVs     = chunk.AllUVs && corner.HasUV;
+			chunk.AllNormals = chunk.AllNormals && corner.HasNormal;
+		}
+	}
+
+	return true;
+}
+
+void ParseObjChunk(std::string_view text, ObjChunk& chunk) {
+	size_t position   = 0;
+	size_t lineNumber = 0;
+	while (position < text.size()) {
+		LineParser parser(NextLine(text, position));
+		++lineNumber;
+
+		const auto keyword = parser.NextToken();
+		bool valid         = true;
+		if (keyword == "v") {
+			float x, y, z;
+			valid = parser.Next(x) && parser.Next(y) && parser.Next(z);
+			chunk.Positions[0].push_back(x);
+			chunk.Positions[1].push_back(y);
+			chunk.Positions[2].push_back(z);
+		} else if (keyword == "vn") {
+			float x, y, z;
+			valid = parser.Next(x) && parser.Next(y) && parser.Next(z);
+			chunk.Normals[0].push_back(x);
+			chunk.Normals[1].push_back(y);
+			chunk.Normals[2].push_back(z);
+		} else if (keyword == "vt") {
+			float u, v = 0.0f;
+			valid = parser.Next(u);
+			parser.Next(v);
+			chunk.UVs[0].push_back(u);
+			chunk.UVs[1].push_back(v);
+		} else if (keyword == "f") {
+			valid = ParseObjFace(parser, chunk);
+		}
+
+		if (!valid) {
+			chunk.ErrorLine = lineNumber;
+			return;
+		}
+	}
+}
+
+// Turn the stored indices of one chunk into final indices, given how many vertices came before it.
+bool ResolveObjIndices(const std::vector<int64_t>& indices,
+                       int64_t base,
+                       size_t total,
+                       uint32_t* outIndices,
+                       std::string& outError) {
+	for (size_t i = 0; i < indices.size(); ++i) {
+		const int64_t index = indices[i] >= RelativeIndex / 2 ? base + (indices[i] - RelativeIndex) : indices[i];
+		if (index < 0 || static_cast<size_t>(index) >= total) {
+			outError = fmt::format("Face references vertex {}, but there are only {}.", index + 1, total);
+			return false;
+		}
+		outIndices[i] = static_cast<uint32_t>(index);
+	}
+
+	return true;
+}
+
+/* ======================
+ * Stanford PLY
+ * ====================== */
+
+enum class PlyFormat { Ascii, BinaryLittleEndian, BinaryBigEndian };
+enum class PlyType { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64 };
+
+struct PlyProperty {
+	std::string Name;
+	PlyType Type      = PlyType::Float32;
+	PlyType CountType = PlyType::UInt8;
+	bool IsList       = false;
+};
+
+struct PlyElement {
+	std::string Name;
+	size_t Count = 0;
+	std::vector<PlyProperty> Properties;
+};
+
+bool ParsePlyType(std::string_view name, PlyType& outType) {
+	if (name == "char" || name == "int8") {
+		outType = PlyType::Int8;
+	} else if (name == "uchar" || name == "uint8") {
+		outType = PlyType::UInt8;
+	} else if (name == "short" || name == "int16") {
+		outType = PlyType::Int16;
+	} else if (name == "ushort" || name == "uint16") {
+		outType = PlyType::UInt16;
+	} else if (name == "int" || name == "int32") {
+		outType = PlyType::Int32;
+	} else if (name == "uint" || name == "uint32") {
+		outType = PlyType::UInt32;
+	} else if (name == "float" || name == "float32") {
+		outType = PlyType::Float32;
+	} else if (name == "double" || name == "float64") {
+		outType = PlyType::Float64;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+size_t GetPlyTypeSize(PlyType type) {
+	switch (type) {
+		case PlyType::Int8:
+		case PlyType::UInt8:
+			return 1;
+		case PlyType::Int16:
+		case PlyType::UInt16:
+			return 2;
+		case PlyType::Int32:
+		case PlyType::UInt32:
+		case PlyType::Float32:
+			return 4;
+		case PlyType::Float64:
+			return 8;
+	}
+
+	return 0;
+}
+
+// Reads the values of PLY records one at a time, from either an ASCII or a binary body.
+class PlyReader {
+ public:
+	PlyReader(std::string_view data, size_t position, PlyFormat format)
+			: _data(data), _position(position), _format(format) {}
+
+	size_t GetPosition() const {
+		return _position;
+	}
+
+	bool Read(PlyType type, double& outValue) {
+		if (_format == PlyFormat::Ascii) {
+			while (_position < _data.size() && IsSpace(_data[_position])) { ++_position; }
+			const auto result = std::from_chars(_data.data() + _position, _data.data() + _data.size(), outValue);
+			if (result.ec != std::errc()) { return false; }
+			_position = result.ptr - _data.data();
+
+			return true;
+		}
+
+		const size_t size = GetPlyTypeSize(type);
+		if (_position + size > _data.size()) { return false; }
+		unsigned char bytes[8];
+		std::memcpy(bytes, _data.data() + _position, size);
+		if (_format == PlyFormat::BinaryBigEndian) { std::reverse(bytes, bytes + size); }
+		_position += size;
+
+		switch (type) {
+			case PlyType::Int8:
+				outValue = Decode<int8_t>(bytes);
+				break;
+			case PlyType::UInt8:
+				outValue = Decode<uint8_t>(bytes);
+				break;
+			case PlyType::Int16:
+				outValue = Decode<int16_t>(bytes);
+				break;
+			case PlyType::UInt16:
+				outValue = Decode<uint16_t>(bytes);
+				break;
+			case PlyType::Int32:
+				outValue = Decode<int32_t>(bytes);
+				break;
+			case PlyType::UInt32:
+				outValue = Decode<uint32_t>(bytes);
+				break;
+			case PlyType::Float32:
+				outValue = Decode<float>(bytes);
+				break;
+			case PlyType::Float64:
+				outValue = Decode<double>(bytes);
+				break;
+		}
+
+		return true;
+	}
+
+	// Reads a list count or vertex index. Malformed files may hold anything there, so only values that fit in 32 bits
+	// unsigned are accepted.
+	bool ReadIndex(PlyType type, uint32_t& outValue) {
+		double value;
+		if (!Read(type, value) || !std::isfinite(value) || value < 0.0 ||
+		    value > static_cast<double>(std::numeric_limits<uint32_t>::max())) {
+			return false;
+		}
+		outValue = static_cast<uint32_t>(value);
+
+		return true;
+	}
+
+	// Move on to the next record. ASCII records are one per line, binary ones simply follow each other.
+	bool EndRecord() {
+		if (_format != PlyFormat::Ascii) { return true; }
+
+		while (_position < _data.size() && IsSpace(_data[_position])) { ++_position; }
+		if (_position < _data.size() && _data[_position] != '\n') { return false; }
+		if (_position < _data.size()) { ++_position; }
+
+		return true;
+	}
+
+	bool SkipRecord(const PlyElement& element) {
+		if (_format == PlyFormat::Ascii) {
+			if (_position >= _data.size()) { return false; }
+			NextLine(_data, _position);
+			return true;
+		}
+
+		uint32_t count;
+		for (const auto& property : element.Properties) {
+			if (property.IsList) {
+				if (!ReadIndex(property.CountType, count)) { return false; }
+				_position += size_t(count) * GetPlyTypeSize(property.Type);
+			} else {
+				_position += GetPlyTypeSize(property.Type);
+			}
+		}
+
+		return _position <= _data.size();
+	}
+
+ private:
+	template <typename T>
+	static double Decode(const unsigned char* bytes) {
+		T value;
+		std::memcpy(&value, bytes, sizeof(T));
+		return static_cast<double>(value);
+	}
+
+	std::string_view _data;
+	size_t _position;
+	PlyFormat _format;
+};
+
+// The header's counts are not to be trusted, and everything after it sizes arrays and walks records by them. Every
+// ASCII record takes up at least one line, and every binary record at least its fixed size plus its list counts, so an
+// element can never hold more records than the body has room for.
+bool CheckPlyElementCounts(std::string_view body,
+                           PlyFormat format,
+                           const std::vector<PlyElement>& elements,
+                           std::string& outError) {
+	size_t remaining = body.size();
+	if (format == PlyFormat::Ascii) {
+		remaining = std::count(body.begin(), body.end(), '\n') + (body.empty() || body.back() == '\n' ? 0 : 1);
+	}
+
+	for (const auto& element : elements) {
+		size_t recordSize = 1;
+		if (format != PlyFormat::Ascii) {
+			recordSize = 0;
+			for (const auto& property : element.Properties) {
+				recordSize += GetPlyTypeSize(property.IsList ? property.CountType : property.Type);
+			}
+			recordSize = std::max<size_t>(recordSize, 1);  // Records without properties are still counted.
+		}
+
+		if (element.Count > remaining / recordSize) {
+			outError = fmt::format("PLY element '{}' has more records than the file has room for.", element.Name);
+			return false;
+		}
+		remaining -= element.Count * recordSize;
+	}
+
+	return true;
+}
+
+bool ParsePlyHeader(std::string_view data,
+                    PlyFormat& outFormat,
+                    std::vector<PlyElement>& outElements,
+                    size_t& outBodyStart,
+                    std::string& outError) {
+	size_t position = 0;
+	if (NextLine(data, position).substr(0, 3) != "ply") {
+		outError = "File does not start with a PLY signature.";
+		return false;
+	}
+
+	bool hasFormat = false;
+	while (position < data.size()) {
+		LineParser parser(NextLine(data, position));
+		const auto keyword = parser.NextToken();
+		if (keyword == "end_header") {
+			outBodyStart = position;
+			if (!hasFormat) {
+				outError = "PLY header does not declare a format.";
+				return false;
+			}
+			return CheckPlyElementCounts(data.substr(position), outFormat, outElements, outError);
+		} else if (keyword == "format") {
+			const auto format = parser.NextToken();
+			if (format == "ascii") {
+				outFormat = PlyFormat::Ascii;
+			} else if (format == "binary_little_endian") {
+				outFormat = PlyFormat::BinaryLittleEndian;
+			} else if (format == "binary_big_endian") {
+				outFormat = PlyFormat::BinaryBigEndian;
+			} else {
+				outError = fmt::format("Unknown PLY format '{}'.", format);
+				return false;
+			}
+			hasFormat = true;
+		} else if (keyword == "element") {
+			PlyElement element;
+			element.Name = parser.NextToken();
+			if (!parser.Next(element.Count)) {
+				outError = fmt::format("Invalid count for PLY element '{}'.", element.Name);
+				return false;
+			}
+			outElements.push_back(std::move(element));
+		} else if (keyword == "property") {
+			if (outElements.empty()) {
+				outError = "PLY property declared outside of an element.";
+				return false;
+			}
+
+			PlyProperty property;
+			auto type = parser.NextToken();
+			if (type == "list") {
+				property.IsList = true;
+				if (!ParsePlyType(parser.NextToken(), property.CountType)) {
+					outError = "Invalid PLY list count type.";
+					return false;
+				}
+				type = parser.NextToken();
+			}
+			if (!ParsePlyType(type, property.Type)) {
+				outError = fmt::format("Invalid PLY property type '{}'.", type);
+				return false;
+			}
+			property.Name = parser.NextToken();
+			outElements.back().Properties.push_back(std::move(property));
+		}
+	}
+
+	outError = "PLY header is not terminated.";
+	return false;
+}
+
+// Find where each of chunkCount runs of records in an element starts. Returns chunkCount + 1 offsets and first record
+// indices, the last of which mark the end of the element.
+bool SplitPlyElement(std::string_view data,
+                     size_t position,
+                     PlyFormat format,
+                     const PlyElement& element,
+                     size_t chunkCount,
+                     std::vector<size_t>& outOffsets,
+                     std::vector<size_t>& outFirstRecords) {
+	chunkCount = std::max<size_t>(std::min(chunkCount, element.Count), 1);
+	outOffsets.clear();
+	outFirstRecords.clear();
+
+	// Binary elements without lists have a fixed stride, so the chunks can be found without looking at the data.
+	bool fixedStride = format != PlyFormat::Ascii;
+	size_t stride    = 0;
+	for (const auto& property : element.Properties) {
+		fixedStride = fixedStride && !property.IsList;
+		stride += GetPlyTypeSize(property.Type);
+	}
+
+	PlyReader reader(data, position, format);
+	size_t record = 0;
+	for (size_t chunk = 0; chunk <= chunkCount; ++chunk) {
+		const size_t first = element.Count * chunk / chunkCount;
+		if (fixedStride) {
+			outOffsets.push_back(position + first * stride);
+		} else {
+			for (; record < first; ++record) {
+				if (!reader.SkipRecord(element)) { return false; }
+			}
+			outOffsets.push_back(reader.GetPosition());
+		}
+		outFirstRecords.push_back(first);
+	}
+
+	return outOffsets.back() <= data.size();
+}
+
+int FindPlyProperty(const PlyElement& element, std::initializer_list<std::string_view> names) {
+	for (size_t i = 0; i < element.Properties.size(); ++i) {
+		for (const auto name : names) {
+			if (element.Properties[i].Name == name) { return static_cast<int>(i); }
+		}
+	}
+
+	return -1;
+}
+}  // namespace
+
+std::shared_ptr<MeshData> LoadMesh(const std::string& filename, ITaskPool* taskPool) {
+	auto extension = std::string(GetExtension(filename));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return std::tolower(c); });
+
+	if (extension == "obj") { return LoadOBJ(filename, taskPool); }
+	if (extension == "ply") { return LoadPLY(filename, taskPool); }
+
+	Log::Error("MeshLoader", "Unsupported mesh format '{}' for file: {}", extension, filename);
+	return nullptr;
+}
+
+std::shared_ptr<MeshData> LoadOBJ(const std::string& filename, ITaskPool* taskPool) {
+	std::string data;
+	if (!ReadFile(filename, data)) {
+		Log::Error("MeshLoader", "Failed to open mesh file: {}", filename);
+		return nullptr;
+	}
+
+	const auto texts = SplitLines(data, GetChunkCount(taskPool));
+	std::vector<ObjChunk> chunks(texts.size());
+	ParallelChunks(taskPool, chunks.size(), [&](uint32_t chunk) { ParseObjChunk(texts[chunk], chunks[chunk]); });
+
+	// Work out where every chunk's data goes in the final arrays.
+	std::vector<size_t> positionBase(chunks.size() + 1, 0);
+	std::vector<size_t> normalBase(chunks.size() + 1, 0);
+	std::vector<size_t> uvBase(chunks.size() + 1, 0);
+	std::vector<size_t> indexBase(chunks.size() + 1, 0);
+	bool allNormals = true;
+	bool allUVs     = true;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		const auto& chunk = chunks[i];
+		if (chunk.ErrorLine > 0) {
+			size_t line = chunk.ErrorLine;
+			for (size_t j = 0; j < i; ++j) { line += std::count(texts[j].begin(), texts[j].end(), '\n'); }
+			Log::Error("MeshLoader", "Failed to parse OBJ file {}: Malformed statement on line {}.", filename, line);
+			return nullptr;
+		}
+
+		positionBase[i + 1] = positionBase[i] + chunk.Positions[0].size();
+		normalBase[i + 1]   = normalBase[i] + chunk.Normals[0].size();
+		uvBase[i + 1]       = uvBase[i] + chunk.UVs[0].size();
+		indexBase[i + 1]    = indexBase[i] + chunk.PositionIndices.size();
+		allNormals          = allNormals && chunk.AllNormals;
+		allUVs              = allUVs && chunk.AllUVs;
+	}
+
+	auto mesh = std::make_shared<MeshData>();
+	for (auto& positions : mesh->Positions) { positions.resize(positionBase.back()); }
+	for (auto& normals : mesh->Normals) { normals.resize(normalBase.back()); }
+	for (auto& uvs : mesh->UVs) { uvs.resize(uvBase.back()); }
+	mesh->PositionIndices.resize(indexBase.back());
+	if (allNormals && normalBase.back() > 0) { mesh->NormalIndices.resize(indexBase.back()); }
+	if (allUVs && uvBase.back() > 0) { mesh->UVIndices.resize(indexBase.back()); }
+
+	std::vector<std::string> errors(chunks.size());
+	ParallelChunks(taskPool, chunks.size(), [&](uint32_t i) {
+		// Most chunks hold only vertices or only faces, and the arrays they have nothing for may be empty altogether, so
+		// destinations are never indexed, as that would step past the end of those arrays.
+		auto& chunk = chunks[i];
+		for (int axis = 0; axis < 3; ++axis) {
+			std::copy(chunk.Positions[axis].begin(),
+			          chunk.Positions[axis].end(),
+			          mesh->Positions[axis].begin() + positionBase[i]);
+			std::copy(chunk.Normals[axis].begin(), chunk.Normals[axis].end(), mesh->Normals[axis].begin() + normalBase[i]);
+		}
+		for (int axis = 0; axis < 2; ++axis) {
+			std::copy(chunk.UVs[axis].begin(), chunk.UVs[axis].end(), mesh->UVs[axis].begin() + uvBase[i]);
+		}
+		if (chunk.PositionIndices.empty()) {
+			chunk = ObjChunk();
+			return;
+		}
+
+		const size_t first = indexBase[i];
+		bool valid         = ResolveObjIndices(chunk.PositionIndices,
+                                   positionBase[i],
+                                   positionBase.back(),
+                                   mesh->PositionIndices.data() + first,
+                                   errors[i]);
+		if (valid && mesh->HasNormals()) {
+			valid = ResolveObjIndices(
+				chunk.NormalIndices, normalBase[i], normalBase.back(), mesh->NormalIndices.data() + first, errors[i]);
+		}
+		if (valid && mesh->HasUVs()) {
+			valid = ResolveObjIndices(chunk.UVIndices, uvBase[i], uvBase.back(), mesh->UVIndices.data() + first, errors[i]);
+		}
+
+		chunk = ObjChunk();
+	});
+	for (const auto& error : errors) {
+		if (!error.empty()) {
+			Log::Error("MeshLoader", "Failed to parse OBJ file {}: {}", filename, error);
+			return nullptr;
+		}
+	}
+
+	Log::Info("MeshLoader",
+	          "Loaded {} triangles and {} vertices from {}.",
+	          mesh->GetTriangleCount(),
+	          mesh->GetVertexCount(),
+	          filename);
+
+	return mesh;
+}
+
+std::shared_ptr<MeshData> LoadPLY(const std::string& filename, ITaskPool* taskPool) {
+	std::string data;
+	if (!ReadFile(filename, data)) {
+		Log::Error("MeshLoader", "Failed to open mesh file: {}", filename);
+		return nullptr;
+	}
+
+	PlyFormat format;
+	std::vector<PlyElement> elements;
+	size_t position = 0;
+	std::string error;
+	if (!ParsePlyHeader(data, format, elements, position, error)) {
+		Log::Error("MeshLoader", "Failed to parse PLY file {}: {}", filename, error);
+		return nullptr;
+	}
+
+	auto mesh = std::make_shared<MeshData>();
+	bool hasNormals = false;
+	bool hasUVs     = false;
+	std::vector<size_t> offsets;
+	std::vector<size_t> firstRecords;
+	std::atomic_bool valid = true;
+
+	for (const auto& element : elements) {
+		if (!SplitPlyElement(data, position, format, element, GetChunkCount(taskPool), offsets, firstRecords)) {
+			Log::Error("MeshLoader", "Failed to parse PLY file {}: Element '{}' is truncated.", filename, element.Name);
+			return nullptr;
+		}
+		const size_t chunkCount = offsets.size() - 1;
+
+		if (element.Name == "vertex") {
+			const int properties[7] = {FindPlyProperty(element, {"x"}),
+			                           FindPlyProperty(element, {"y"}),
+			                           FindPlyProperty(element, {"z"}),
+			                           FindPlyProperty(element, {"nx"}),
+			                           FindPlyProperty(element, {"ny"}),
+			                           FindPlyProperty(element, {"nz"}),
+			                           FindPlyProperty(element, {"u", "s", "texture_u", "texture_s"})};
+			const int vProperty     = FindPlyProperty(element, {"v", "t", "texture_v", "texture_t"});
+			if (properties[0] < 0 || properties[1] < 0 || properties[2] < 0) {
+				Log::Error("MeshLoader", "Failed to parse PLY file {}: Vertices have no position.", filename);
+				return nullptr;
+			}
+			hasNormals = properties[3] >= 0 && properties[4] >= 0 && properties[5] >= 0;
+			hasUVs     = properties[6] >= 0 && vProperty >= 0;
+
+			for (auto& positions : mesh->Positions) { positions.resize(element.Count); }
+			if (hasNormals) {
+				for (auto& normals : mesh->Normals) { normals.resize(element.Count); }
+			}
+			if (hasUVs) {
+				for (auto& uvs : mesh->UVs) { uvs.resize(element.Count); }
+			}
+
+			ParallelChunks(taskPool, chunkCount, [&](uint32_t chunk) {
+				PlyReader reader(data, offsets[chunk], format);
+				std::vector<double> values(element.Properties.size());
+				for (size_t vertex = firstRecords[chunk]; vertex < firstRecords[chunk + 1]; ++vertex) {
+					for (size_t i = 0; i < element.Properties.size(); ++i) {
+						const auto& property = element.Properties[i];
+						uint32_t count       = 1;
+						if (property.IsList && !reader.ReadIndex(property.CountType, count)) {
+							valid = false;
+							return;
+						}
+						for (uint32_t item = 0; item < count; ++item) {
+							if (!reader.Read(property.Type, values[i])) {
+								valid = false;
+								return;
+							}
+						}
+					}
+					if (!reader.EndRecord() || !valid) {
+						valid = false;
+						return;
+					}
+
+					for (int axis = 0; axis < 3; ++axis) {
+						mesh->Positions[axis][vertex] = static_cast<float>(values[properties[axis]]);
+						if (hasNormals) { mesh->Normals[axis][vertex] = static_cast<float>(values[properties[axis + 3]]); }
+					}
+					if (hasUVs) {
+						mesh->UVs[0][vertex] = static_cast<float>(values[properties[6]]);
+						mesh->UVs[1][vertex] = static_cast<float>(values[vProperty]);
+					}
+				}
+			});
+		} else if (element.Name == "face") {
+			const int indexProperty = FindPlyProperty(element, {"vertex_indices", "vertex_index"});
+			if (indexProperty < 0 || !element.Properties[indexProperty].IsList) {
+				Log::Error("MeshLoader", "Failed to parse PLY file {}: Faces have no vertex indices.", filename);
+				return nullptr;
+			}
+
+			std::vector<std::vector<uint32_t>> chunkIndices(chunkCount);
+			ParallelChunks(taskPool, chunkCount, [&](uint32_t chunk) {
+				PlyReader reader(data, offsets[chunk], format);
+				auto& indices = chunkIndices[chunk];
+				std::vector<uint32_t> polygon;
+				for (size_t face = firstRecords[chunk]; face < firstRecords[chunk + 1]; ++face) {
+					for (size_t i = 0; i < element.Properties.size(); ++i) {
+						const auto& property = element.Properties[i];
+						const bool isIndices = static_cast<int>(i) == indexProperty;
+						uint32_t count       = 1;
+						if (property.IsList && !reader.ReadIndex(property.CountType, count)) {
+							valid = false;
+							return;
+						}
+
+						// Stop at the first value that fails to read, the rest of the record cannot be trusted.
+						polygon.clear();
+						for (uint32_t item = 0; item < count; ++item) {
+							bool read = false;
+							if (isIndices) {
+								uint32_t index;
+								read = reader.ReadIndex(property.Type, index);
+								if (read) { polygon.push_back(index); }
+							} else {
+								double value;
+								read = reader.Read(property.Type, value);
+							}
+							if (!read) {
+								valid = false;
+								return;
+							}
+						}
+						if (!isIndices) { continue; }
+
+						for (size_t corner = 1; corner + 1 < polygon.size(); ++corner) {
+							indices.push_back(polygon[0]);
+							indices.push_back(polygon[corner]);
+							indices.push_back(polygon[corner + 1]);
+						}
+					}
+					if (!reader.EndRecord() || !valid) {
+						valid = false;
+						return;
+					}
+				}
+			});
+
+			size_t indexCount = 0;
+			for (const auto& indices : chunkIndices) { indexCount += indices.size(); }
+			mesh->PositionIndices.reserve(indexCount);
+			for (const auto& indices : chunkIndices) {
+				mesh->PositionIndices.insert(mesh->PositionIndices.end(), indices.begin(), indices.end());
+			}
+		}
+
+		if (!valid) {
+			Log::Error("MeshLoader", "Failed to parse PLY file {}: Malformed '{}' element.", filename, element.Name);
+			return nullptr;
+		}
+		position = offsets.back();
+	}
+
+	const size_t vertexCount = mesh->GetVertexCount();
+	if (std::any_of(mesh->PositionIndices.begin(), mesh->PositionIndices.end(), [&](uint32_t index) {
+				return index >= vertexCount;
+			})) {
+		Log::Error("MeshLoader", "Failed to parse PLY file {}: Face references a vertex out of range.", filename);
+		return nullptr;
+	}
+
+	// PLY vertices carry all of their attributes, so every attribute shares the same indices.
+	if (hasNormals) { mesh->NormalIndices = mesh->PositionIndices; }
+	if (hasUVs) { mesh->UVIndices = mesh->PositionIndices; }
+
+	Log::Info("MeshLoader",
+	          "Loaded {} triangles and {} vertices from {}.",
+	          mesh->GetTriangleCount(),
+	          mesh->GetVertexCount(),
+	          filename);
+
+	return mesh;
+}
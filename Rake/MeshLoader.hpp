@@ -0,0 +1,15 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "TriangleMesh.hpp"
+
+class ITaskPool;
+
+// Load a triangle mesh from a Wavefront OBJ or Stanford PLY (ASCII or binary) file, chosen by file extension. Polygons
+// are triangulated as fans. The file is split into chunks that are parsed on all of the task pool's threads at once if
+// one is given. Returns nullptr and logs the reason if the file could not be loaded.
+std::shared_ptr<MeshData> LoadMesh(const std::string& filename, ITaskPool* taskPool = nullptr);
+std::shared_ptr<MeshData> LoadOBJ(const std::string& filename, ITaskPool* taskPool = nullptr);
+std::shared_ptr<MeshData> LoadPLY(const std::string& filename, ITaskPool* taskPool = nullptr);
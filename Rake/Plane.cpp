@@ -1,17 +1,17 @@
 #include "Plane.hpp"
 
-XYPlane::XYPlane(double z, const std::shared_ptr<IMaterial>& material)
-		: XYRectangle(Point2(-std::numeric_limits<double>::infinity()),
-                  Point2(std::numeric_limits<double>::infinity()),
+XYPlane::XYPlane(Real z, const std::shared_ptr<IMaterial>& material)
+		: XYRectangle(Point2(-std::numeric_limits<Real>::infinity()),
+                  Point2(std::numeric_limits<Real>::infinity()),
                   z,
                   material) {}
 
-XZPlane::XZPlane(double y, const std::shared_ptr<IMaterial>& material)
+XZPlane::XZPlane(Real y, const std::shared_ptr<IMaterial>& material)
 		: XZRectangle(
-				Point2(-std::numeric_limits<double>::max()), Point2(std::numeric_limits<double>::max()), y, material) {}
+				Point2(-std::numeric_limits<Real>::max()), Point2(std::numeric_limits<Real>::max()), y, material) {}
 
-YZPlane::YZPlane(double x, const std::shared_ptr<IMaterial>& material)
-		: YZRectangle(Point2(-std::numeric_limits<double>::infinity()),
-                  Point2(std::numeric_limits<double>::infinity()),
+YZPlane::YZPlane(Real x, const std::shared_ptr<IMaterial>& material)
+		: YZRectangle(Point2(-std::numeric_limits<Real>::infinity()),
+                  Point2(std::numeric_limits<Real>::infinity()),
                   x,
                   material) {}
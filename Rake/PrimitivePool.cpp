@@ -0,0 +1,88 @@
+#include "PrimitivePool.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+#include "IMaterial.hpp"
+
+uint32_t MaterialTable::Add(const std::shared_ptr<IMaterial>& material) {
+	const auto [it, added] = _indices.try_emplace(material.get(), uint32_t(_materials.size()));
+	if (added) { _materials.push_back(material); }
+
+	return it->second;
+}
+
+void MaterialTable::Clear() {
+	_materials.clear();
+	_indices.clear();
+}
+
+uint32_t SpherePool::Add(const Point3& center, Real radius, uint32_t material) {
+	if (Size() > PrimitiveID::MaxIndex) { throw std::runtime_error("Too many spheres in one world!"); }
+
+	CenterX.push_back(center.x);
+	CenterY.push_back(center.y);
+	CenterZ.push_back(center.z);
+	Radius.push_back(radius);
+	Material.push_back(material);
+
+	return uint32_t(Size() - 1);
+}
+
+void SpherePool::Clear() {
+	CenterX.clear();
+	CenterY.clear();
+	CenterZ.clear();
+	Radius.clear();
+	Material.clear();
+}
+
+AABB SpherePool::GetBounds(uint32_t index) const {
+	const Point3 center = GetCenter(index);
+	const Real r        = glm::abs(Radius[index]);
+
+	return AABB(center - Vector3(r), center + Vector3(r));
+}
+
+uint32_t RectanglePool::Add(
+	RectanglePlane plane, const Point2& min, const Point2& max, Real offset, uint32_t material) {
+	if (Size() > PrimitiveID::MaxIndex) { throw std::runtime_error("Too many rectangles in one world!"); }
+
+	Plane.push_back(plane);
+	Min.push_back(min);
+	Max.push_back(max);
+	Offset.push_back(offset);
+	Material.push_back(material);
+
+	return uint32_t(Size() - 1);
+}
+
+uint32_t RectanglePool::AddPlane(RectanglePlane plane, Real offset, uint32_t material) {
+	return Add(plane,
+	           Point2(-std::numeric_limits<Real>::max()),
+	           Point2(std::numeric_limits<Real>::max()),
+	           offset,
+	           material);
+}
+
+void RectanglePool::Clear() {
+	Plane.clear();
+	Min.clear();
+	Max.clear();
+	Offset.clear();
+	Material.clear();
+}
+
+AABB RectanglePool::GetBounds(uint32_t index) const {
+	const Point2& min = Min[index];
+	const Point2& max = Max[index];
+	const Real offset = Offset[index];
+	switch (Plane[index]) {
+		case RectanglePlane::XY:
+			return AABB(Point3(min.x, min.y, offset - 0.0001), Point3(max.x, max.y, offset + 0.0001));
+		case RectanglePlane::XZ:
+			return AABB(Point3(min.x, offset - 0.0001, min.y), Point3(max.x, offset + 0.0001, max.y));
+		default:
+			return AABB(Point3(offset - 0.0001, min.x, min.y), Point3(offset + 0.0001, max.x, max.y));
+	}
+}
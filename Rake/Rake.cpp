@@ -1,7 +1,5 @@
 #include "Rake.hpp"
 
-#include <stb_image_write.h>
-
 #include <Luna.hpp>
 #include <Luna/Graphics/Vulkan/Buffer.hpp>
 #include <Luna/Graphics/Vulkan/CommandBuffer.hpp>
@@ -9,21 +7,13 @@
 #include <Luna/Graphics/Vulkan/Image.hpp>
 #include <Luna/Utility/Log.hpp>
 #include <Luna/Utility/Time.hpp>
+#include <algorithm>
 #include <glm/gtc/type_ptr.hpp>
 
-#include "CheckerTexture.hpp"
-#include "ImageTexture.hpp"
-#include "Materials/DielectricMaterial.hpp"
-#include "Materials/DiffuseLightMaterial.hpp"
-#include "Materials/GradientSkyMaterial.hpp"
-#include "Materials/LambertianMaterial.hpp"
-#include "Materials/MetalMaterial.hpp"
-#include "Materials/SolidSkyMaterial.hpp"
-#include "Plane.hpp"
-#include "Random.hpp"
+#include "ImageWriter.hpp"
 #include "RenderMessages.hpp"
-#include "SolidTexture.hpp"
-#include "Sphere.hpp"
+#include "SceneFile.hpp"
+#include "Scenes.hpp"
 #include "Tracer.hpp"
 #include "World.hpp"
 
@@ -32,7 +22,7 @@ using namespace Luna;
 Rake::Rake() : App("Rake") {}
 
 Rake::~Rake() noexcept {
-	if (_exportThread.joinable()) { _exportThread.join(); }
+	StopExportThread();
 }
 
 void Rake::Start() {
@@ -40,98 +30,24 @@ void Rake::Start() {
 	Window::Get()->Maximize();
 	Window::Get()->SetTitle("Rake");
 
-	_tracer = std::make_unique<Tracer>();
+	_tracer       = std::make_unique<Tracer>();
+	_exportThread = std::thread([this]() { ExportThread(); });
 
 	Graphics::Get()->OnRender += [this]() { Render(); };
 
-	const auto CreateWorld = [this](const std::string& name) -> World& {
-		auto& world = _worlds.emplace_back(std::make_shared<World>(name));
-		return *world;
-	};
-
-	{
-		auto& world               = CreateWorld("World");
-		world.Sky                 = std::make_shared<GradientSkyMaterial>(Color(1.0), Color(0.5, 0.7, 1.0), 0.5);
-		world.CameraPos           = Point3(0.0, 0.0, 0.0);
-		world.CameraTarget        = Point3(0.0, 0.0, -1.0);
-		world.CameraFocusDistance = 1.0;
-		world.VerticalFOV         = 100;
-		auto ground               = std::make_shared<LambertianMaterial>(Color(0.3, 0.3, 0.8));
-		auto center               = std::make_shared<LambertianMaterial>(Color(0.3, 0.8, 0.3));
-		auto left                 = std::make_shared<DielectricMaterial>(1.5);
-		auto right                = std::make_shared<MetalMaterial>(Color(0.8, 0.6, 0.2), 1.0);
-		world.Objects.Add<Sphere>(Point3(0, -100.5, -1), 100, ground);
-		world.Objects.Add<Sphere>(Point3(0, 0, -1), 0.5, center);
-		world.Objects.Add<Sphere>(Point3(-1, 0, -1), 0.5, left);
-		world.Objects.Add<Sphere>(Point3(-1, 0, -1), -0.45, left);
-		world.Objects.Add<Sphere>(Point3(1, 0, -1), 0.5, right);
-	}
-
-	{
-		auto& world = CreateWorld("Raytracing In One Weekend");
-		// world.Sky          = std::make_shared<GradientSkyMaterial>(Color(1.0) * 0.2f, Color(0.5, 0.7, 1.0) * 0.2f, 0.5);
-		world.Sky = std::make_shared<SolidSkyMaterial>(std::make_shared<ImageTexture>("Assets/Textures/TokyoBigSight.hdr"));
-		world.CameraPos           = Point3(13.0, 2.0, 5.0);
-		world.CameraTarget        = Point3(0.0, 0.0, 0.0);
-		world.CameraFocusDistance = 12.0;
-		world.CameraAperture      = 0.1;
-		world.VerticalFOV         = 20;
-
-		auto sun          = std::make_shared<DiffuseLightMaterial>(Color(0.5, 0.9, 0.9) * 30.0f);
-		auto checker      = std::make_shared<CheckerTexture>(Color(0.2), Color(0.36, 0.0, 0.63), glm::vec2(Pi));
-		auto earth        = std::make_shared<ImageTexture>("Assets/Textures/Earth.jpg");
-		auto ground       = std::make_shared<LambertianMaterial>(checker);
-		auto center       = std::make_shared<DielectricMaterial>(1.5);
-		auto left         = std::make_shared<LambertianMaterial>(earth);
-		auto right        = std::make_shared<MetalMaterial>(Color(0.7, 0.6, 0.5), 0.0);
-		const auto sunPos = RandomInHemisphere(Vector3(0, 1, 0)) * 250.0;
-		world.Objects.Add<Sphere>(sunPos, 50, sun);
-		world.Objects.Add<XZPlane>(0.0, ground);
-		world.Objects.Add<Sphere>(Point3(0, 1, 0), 1, center);
-		world.Objects.Add<Sphere>(Point3(-4, 1, 0), 1, left);
-		world.Objects.Add<Sphere>(Point3(4, 1, 0), 1, right);
-
-		for (int x = -11; x < 11; x++) {
-			for (int y = -11; y < 11; y++) {
-				const auto randomMat = RandomDouble();
-				const Point3 center(x + 0.9 * RandomDouble(), 0.2, y + 0.9 * RandomDouble());
-
-				if (glm::length(center - Point3(4, 0.2, 0)) > 0.9) {
-					std::shared_ptr<IMaterial> material;
-					if (randomMat < 0.3) {
-						const auto albedo = RandomColor() * RandomColor();
-						material          = std::make_shared<LambertianMaterial>(albedo);
-					} else if (randomMat < 0.7) {
-						const auto albedoA = RandomColor() * RandomColor();
-						const auto albedoB = RandomColor() * RandomColor();
-						material           = std::make_shared<LambertianMaterial>(
-              std::make_shared<CheckerTexture>(albedoA, albedoB, glm::vec2(30.0f, 15.0f)));
-					} else if (randomMat < 0.8) {
-						const auto albedo = RandomColor() * RandomColor();
-						material          = std::make_shared<DiffuseLightMaterial>(albedo * 5.0f);
-					} else if (randomMat < 0.95) {
-						const auto albedo    = RandomColor(0.5, 1.0);
-						const auto roughness = RandomDouble(0.0, 0.5);
-						material             = std::make_shared<MetalMaterial>(albedo, roughness);
-					} else {
-						material = std::make_shared<DielectricMaterial>(1.5);
-					}
-
-					world.Objects.Add<Sphere>(center, 0.2, material);
-				}
-			}
-		}
-	}
+	_worlds            = CreateWorlds();
+	_builtInWorldCount = _worlds.size();
+	LoadScenes();
 }
 
 void Rake::Update() {
-	_exportTimer.Update();
 	_tracer->Update();
 	if (_dirty) { Invalidate(); }
-	if (_exportThread.joinable()) { _exportThread.join(); }
 }
 
 void Rake::Stop() {
+	// Queued exports are still written, and they use the tracer's threads to do it.
+	StopExportThread();
 	_tracer.reset();
 	_copyBuffer.Reset();
 	_renderImage.Reset();
@@ -142,16 +58,14 @@ void Rake::Render() {
 
 	auto cmdBuf = device.RequestCommandBuffer(Vulkan::CommandBufferType::Generic, "Main Command Buffer");
 
-	const bool renderUpdated = _tracer->UpdatePixels(_pixels);
+	// The tracer hands over only the tiles that changed, so only those are gamma corrected and copied, and only the rows
+	// they cover are uploaded.
+	uint32_t firstRow = 0;
+	uint32_t lastRow  = 0;
+	const bool renderUpdated =
+		_copyBuffer &&
+		_tracer->UpdateDisplay(reinterpret_cast<Color*>(_copyBuffer->Map()), _pixels.data(), firstRow, lastRow);
 	if (renderUpdated) {
-		for (auto& pixel : _pixels) {
-			pixel.r = glm::sqrt(pixel.r);
-			pixel.g = glm::sqrt(pixel.g);
-			pixel.b = glm::sqrt(pixel.b);
-		}
-		Color* pixelData = reinterpret_cast<Color*>(_copyBuffer->Map());
-		memcpy(pixelData, _pixels.data(), _copyBuffer->GetCreateInfo().Size);
-
 		const auto samples = _tracer->GetCompletedSamples();
 		auto nextExport    = _lastExport + _autoExport;
 		nextExport -= nextExport % _autoExport;
@@ -163,20 +77,21 @@ void Rake::Render() {
 			Export();
 		}
 
+		// The rows outside of the update have to survive, so the image keeps its contents through the transition.
 		cmdBuf->ImageBarrier(*_renderImage,
-		                     vk::ImageLayout::eUndefined,
+		                     vk::ImageLayout::eShaderReadOnlyOptimal,
 		                     vk::ImageLayout::eTransferDstOptimal,
-		                     vk::PipelineStageFlagBits::eTopOfPipe,
-		                     vk::AccessFlagBits::eNone,
+		                     vk::PipelineStageFlagBits::eFragmentShader,
+		                     vk::AccessFlagBits::eShaderRead,
 		                     vk::PipelineStageFlagBits::eTransfer,
 		                     vk::AccessFlagBits::eTransferWrite);
 
-		const vk::BufferImageCopy copy(0,
+		const vk::BufferImageCopy copy(firstRow * _renderSize.x * sizeof(Color),
 		                               0,
 		                               0,
 		                               vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1),
-		                               vk::Offset3D(0, 0, 0),
-		                               vk::Extent3D(_viewportSize.x, _viewportSize.y, 0));
+		                               vk::Offset3D(0, firstRow, 0),
+		                               vk::Extent3D(_renderSize.x, lastRow - firstRow, 1));
 		cmdBuf->CopyBufferToImage(*_renderImage, *_copyBuffer, {copy});
 
 		cmdBuf->ImageBarrier(*_renderImage,
@@ -197,20 +112,29 @@ void Rake::Render() {
 }
 
 void Rake::Export() {
-	if (_exporting) { return; }
-	_exporting = true;
-	_exportTimer.Start();
 	Color* pixels              = reinterpret_cast<Color*>(_copyBuffer->Map());
-	const size_t pixelCount    = _viewportSize.x * _viewportSize.y;
-	const std::string filename = fmt::format("{}-{}.png", _worlds[_currentWorld]->Name, _samplesCompleted);
+	const size_t pixelCount    = _renderSize.x * _renderSize.y;
+	const std::string filename = fmt::format("{}-{}", _worlds[_currentWorld]->Name, _samplesCompleted);
 	Log::Info("Rake", "Exporting render result {}.", filename);
-	_exportThread = std::thread(
-		[this](const std::string& filename, const glm::uvec2& size, const std::vector<Color> pixels) {
-			ExportThread(filename, size, pixels);
-		},
-		filename,
-		_viewportSize,
-		std::vector<Color>(pixels, pixels + pixelCount));
+
+	std::lock_guard<std::mutex> lock(_exportMutex);
+	_exporting = true;
+	_exportQueue.push_back({filename + ".png", _renderSize, std::vector<Color>(pixels, pixels + pixelCount)});
+	if (_exportEXR) {
+		ExportRequest& request = _exportQueue.emplace_back();
+		request.Filename       = filename + ".exr";
+		request.Size           = _renderSize;
+		request.Pixels         = _pixels;
+	}
+	_exportCondition.notify_one();
+}
+
+void Rake::LoadScenes() {
+	_worlds.resize(_builtInWorldCount);
+	for (const auto& filename : FindScenes(SceneDirectory)) {
+		if (auto world = LoadScene(filename, _tracer.get())) { _worlds.push_back(std::move(world)); }
+	}
+	if (_currentWorld >= _worlds.size()) { _currentWorld = 0; }
 }
 
 void Rake::RequestCancel() {
@@ -222,7 +146,14 @@ void Rake::RequestTrace(bool preview) {
 
 	const auto samplesRequested = preview ? _previewSamples : _samplesPerPixel;
 
-	if (_tracer->StartTrace(_viewportSize, samplesRequested, _worlds[_currentWorld])) {
+	// Previews are dominated by primary rays, so always trace those in packets. They also start out at a fraction of
+	// the viewport resolution, so dragging the camera around gives feedback right away.
+	TraceSettings settings = _traceSettings;
+	settings.PacketTracing |= preview;
+	settings.PreviewLevels = preview ? _previewLevels : 0;
+	settings.Display       = true;
+
+	if (_tracer->StartTrace(_viewportSize, samplesRequested, _worlds[_currentWorld], settings)) {
 		_pixels.resize(_viewportSize.x * _viewportSize.y);
 		std::fill(_pixels.begin(), _pixels.end(), Color(0.0f));
 
@@ -235,9 +166,12 @@ void Rake::RequestTrace(bool preview) {
 		                                        _viewportSize.x * _viewportSize.y * sizeof(Color),
 		                                        vk::BufferUsageFlagBits::eTransferSrc);
 		_copyBuffer = device.CreateBuffer(bufferCI);
+		memset(_copyBuffer->Map(), 0, bufferCI.Size);
+		_renderSize = _viewportSize;
 
 		_samplesRequested = samplesRequested;
 		_samplesCompleted = 0;
+		_previewing       = preview;
 		_renderTime.Start();
 		_threadStatus.clear();
 		_lastExport = 0;
@@ -248,6 +182,7 @@ void Rake::RequestTrace(bool preview) {
 
 void Rake::Invalidate() {
 	_dirty = false;
+	RequestCancel();
 	RequestTrace(true);
 }
 
@@ -259,6 +194,44 @@ void Rake::RenderRakeUI() {
 	ImGui::ShowDemoWindow();
 
 	ImGui::Begin("Debug");
+	{
+		if (_tracer->IsRunning()) { ImGui::BeginDisabled(); }
+		const char* schedulers[] = {"Work Stealing", "Shared Queue"};
+		ImGui::Combo("Scheduler", reinterpret_cast<int*>(&_traceSettings.Scheduler), schedulers, 2);
+		const char* integrators[] = {"Recursive", "Wavefront"};
+		ImGui::Combo("Integrator", reinterpret_cast<int*>(&_traceSettings.Integrator), integrators, 2);
+		ImGui::InputScalar("Max Depth", ImGuiDataType_U32, &_traceSettings.MaxDepth, nullptr, nullptr, "%u");
+		_traceSettings.MaxDepth = std::max(_traceSettings.MaxDepth, 1u);
+		ImGui::InputScalar("Tile Size", ImGuiDataType_U32, &_traceSettings.TileSize, nullptr, nullptr, "%u");
+		ImGui::Checkbox("Packet Tracing", &_traceSettings.PacketTracing);
+		ImGui::InputFloat("Error Threshold", &_traceSettings.ErrorThreshold, 0.0f, 0.0f, "%.4f");
+		_traceSettings.ErrorThreshold = std::max(_traceSettings.ErrorThreshold, 0.0f);
+		ImGui::InputScalar("Preview Levels", ImGuiDataType_U32, &_previewLevels, nullptr, nullptr, "%u");
+		if (_tracer->IsRunning()) { ImGui::EndDisabled(); }
+		ImGui::Checkbox("Export EXR", &_exportEXR);
+		ImGui::Separator();
+
+		const std::string errorStr = fmt::format("Estimated Error: {:.5f}", _tracer->GetError());
+		ImGui::Text("%s", errorStr.c_str());
+		const std::string samplesStr = fmt::format("Average Samples: {:.2f}", _tracer->GetAverageSamples());
+		ImGui::Text("%s", samplesStr.c_str());
+		const std::string pathStr = fmt::format("Average Path Length: {:.2f}", _tracer->GetAveragePathLength());
+		ImGui::Text("%s", pathStr.c_str());
+		if (ImGui::TreeNode("Rays per Bounce")) {
+			const float seconds = _tracer->GetElapsedTime().AsSeconds<float>();
+			for (uint32_t bounce = 0; bounce < Tracer::BounceStatCount; ++bounce) {
+				const uint64_t rays = _tracer->GetBounceRaycastCount(bounce);
+				if (rays == 0) { break; }
+				const uint64_t raysPerSecond = seconds > 0.0f ? std::floor(float(rays) / seconds) : 0ull;
+				const char* suffix           = bounce == Tracer::BounceStatCount - 1 ? "+" : "";
+				const std::string bounceStr =
+					fmt::format(std::locale("en_US.UTF-8"), "Bounce {}{}: {:L} RPS", bounce, suffix, raysPerSecond);
+				ImGui::Text("%s", bounceStr.c_str());
+			}
+			ImGui::TreePop();
+		}
+		ImGui::Separator();
+	}
 	for (size_t t = 0; t < _threadStatus.size(); ++t) {
 		const std::string status = fmt::format("Thread {}: {}", t, _threadStatus[t]);
 		ImGui::Text("%s", status.c_str());
@@ -300,15 +273,15 @@ void Rake::RenderControls() {
 				ImGui::SameLine();
 				ImGui::BeginGroup();
 				if (!CanExport()) { ImGui::BeginDisabled(); }
+				// Exporting again while an export is still being written just queues it up.
+				std::string exportLabel = "Export###Export";
 				if (_exporting) {
 					constexpr float interval = 0.2f;
-					const auto intervals     = _exportTimer.Get().AsSeconds<float>() * (1.0f / interval);
+					const auto intervals     = _exportTime.load(std::memory_order_relaxed) * (1.0f / interval);
 					const auto count         = (static_cast<int>(intervals) % 5) + 1;
-					const auto dots          = fmt::format("{:.>{}}", "", count);
-					ImGui::ButtonEx(dots.c_str(), ImVec2(48.0f, 24.0f));
-				} else {
-					if (ImGui::ButtonEx("Export", ImVec2(48.0f, 24.0f))) { Export(); }
+					exportLabel              = fmt::format("{:.>{}}###Export", "", count);
 				}
+				if (ImGui::ButtonEx(exportLabel.c_str(), ImVec2(48.0f, 24.0f))) { Export(); }
 				ImGui::SetNextItemWidth(48.0f);
 				ImGui::InputScalar("###AutoExport", ImGuiDataType_U32, &_autoExport, nullptr, nullptr, "%u");
 				if (!CanExport()) { ImGui::EndDisabled(); }
@@ -422,11 +395,13 @@ void Rake::RenderViewport() {
 }
 
 void Rake::RenderWorld() {
-	auto& world              = _worlds[_currentWorld];
-	const bool tracerRunning = _tracer->IsRunning();
+	// Held on to by value, as reloading the scenes replaces the worlds in the list.
+	const auto world = _worlds[_currentWorld];
+	// Previews are cheap to throw away, so the world stays editable while one is running and every edit restarts it.
+	const bool worldLocked = _tracer->IsRunning() && !_previewing;
 
 	if (ImGui::Begin("World")) {
-		if (tracerRunning) { ImGui::BeginDisabled(); }
+		if (worldLocked) { ImGui::BeginDisabled(); }
 
 		{
 			std::vector<const char*> worldNames;
@@ -435,54 +410,115 @@ void Rake::RenderWorld() {
 						"Active", reinterpret_cast<int*>(&_currentWorld), worldNames.data(), static_cast<int>(worldNames.size()))) {
 				Invalidate();
 			}
+
+			// Scene files are read again as they are now, the built-in worlds are left as they are.
+			if (ImGui::Button("Reload Scenes")) {
+				LoadScenes();
+				Invalidate();
+			}
 		}
 		ImGui::Separator();
 
 		glm::vec3 camPos = world->CameraPos;
 		if (ImGui::DragFloat3("Camera Position", glm::value_ptr(camPos), 0.1f, 0.0f, 0.0f, "%.2f")) {
 			world->CameraPos = camPos;
+			_dirty           = true;
 		}
 
 		glm::vec3 camTarget = world->CameraTarget;
 		if (ImGui::DragFloat3("Camera Target", glm::value_ptr(camTarget), 0.1f, 0.0f, 0.0f, "%.2f")) {
 			world->CameraTarget = camTarget;
+			_dirty              = true;
 		}
 
 		float vFov = world->VerticalFOV;
-		if (ImGui::DragFloat("Vertical FOV", &vFov, 0.1f, 0.0f, 0.0f, "%.2f")) { world->VerticalFOV = vFov; }
+		if (ImGui::DragFloat("Vertical FOV", &vFov, 0.1f, 0.0f, 0.0f, "%.2f")) {
+			world->VerticalFOV = vFov;
+			_dirty             = true;
+		}
 
 		float camAperture = world->CameraAperture;
 		if (ImGui::DragFloat("Camera Aperture", &camAperture, 0.1f, 0.0f, 0.0f, "%.2f")) {
 			world->CameraAperture = camAperture;
+			_dirty                = true;
 		}
 
 		float camFocus = world->CameraFocusDistance;
 		if (ImGui::DragFloat("Camera Focus", &camFocus, 0.1f, 0.0f, 0.0f, "%.2f")) {
 			world->CameraFocusDistance = camFocus;
+			_dirty                     = true;
 		}
 
+		// Moving a sphere only refits the world BVH, so spheres can be dragged around even in large worlds. The render
+		// threads read the sphere pool directly, so the trace has to stop before a sphere moves.
+		if (world->Spheres.Size() > 0) {
+			ImGui::Separator();
+			const uint32_t firstSphere = 0;
+			const uint32_t lastSphere  = static_cast<uint32_t>(world->Spheres.Size() - 1);
+			_selectedSphere            = std::min(_selectedSphere, lastSphere);
+			ImGui::SliderScalar("Sphere", ImGuiDataType_U32, &_selectedSphere, &firstSphere, &lastSphere);
+
+			glm::vec3 sphereCenter = world->Spheres.GetCenter(_selectedSphere);
+			if (ImGui::DragFloat3("Sphere Position", glm::value_ptr(sphereCenter), 0.1f, 0.0f, 0.0f, "%.2f")) {
+				RequestCancel();
+				world->Spheres.SetCenter(_selectedSphere, sphereCenter);
+				world->MarkMoved();
+				_dirty = true;
+			}
+		}
+		ImGui::Separator();
+
 		if (ImGui::ButtonEx("Refresh", ImVec2(ImGui::GetContentRegionAvail().x, 0.0f))) { _dirty = true; }
 
-		if (tracerRunning) { ImGui::EndDisabled(); }
+		if (worldLocked) { ImGui::EndDisabled(); }
 	}
 	ImGui::End();
 }
 
 bool Rake::CanExport() const {
-	return !_tracer->IsRunning() && _copyBuffer && !_exporting;
+	return !_tracer->IsRunning() && _copyBuffer;
+}
+
+void Rake::ExportThread() {
+	// Only this thread touches the stopwatch, the UI reads the time it publishes.
+	Luna::Utility::Stopwatch exportTimer;
+	bool idle = true;
+
+	std::unique_lock<std::mutex> lock(_exportMutex);
+	while (true) {
+		_exportCondition.wait(lock, [this]() { return _exportStopping || !_exportQueue.empty(); });
+		if (_exportQueue.empty()) { return; }
+
+		if (idle) {
+			idle = false;
+			exportTimer.Start();
+			_exportTime.store(0.0f, std::memory_order_relaxed);
+		}
+
+		const ExportRequest request = std::move(_exportQueue.front());
+		_exportQueue.pop_front();
+		lock.unlock();
+
+		const bool written = request.Filename.ends_with(".exr")
+		                       ? WriteEXR(request.Filename, request.Size, request.Pixels, _tracer.get())
+		                       : WritePNG(request.Filename, request.Size, request.Pixels, _tracer.get());
+		if (!written) { Log::Error("Rake", "Failed to write render result to '{}'!", request.Filename); }
+		exportTimer.Update();
+		_exportTime.store(exportTimer.Get().AsSeconds<float>(), std::memory_order_relaxed);
+
+		lock.lock();
+		if (_exportQueue.empty()) {
+			_exporting = false;
+			idle       = true;
+		}
+	}
 }
 
-void Rake::ExportThread(const std::string& filename, const glm::uvec2& viewportSize, const std::vector<Color> pixels) {
-	const auto pixelCount = viewportSize.x * viewportSize.y;
-	std::vector<uint32_t> rgba(pixelCount, 0xff000000);
-	for (uint64_t pixel = 0; pixel < pixelCount; ++pixel) {
-		const auto& p    = pixels[pixel];
-		const uint32_t r = static_cast<uint8_t>(glm::clamp(p.r, 0.0f, 1.0f) * 255.999f);
-		const uint32_t g = static_cast<uint8_t>(glm::clamp(p.g, 0.0f, 1.0f) * 255.999f) << 8;
-		const uint32_t b = static_cast<uint8_t>(glm::clamp(p.b, 0.0f, 1.0f) * 255.999f) << 16;
-		rgba[pixel] |= r | g | b;
+void Rake::StopExportThread() {
+	{
+		std::lock_guard<std::mutex> lock(_exportMutex);
+		_exportStopping = true;
 	}
-	stbi_write_png(filename.c_str(), viewportSize.x, viewportSize.y, 4, rgba.data(), sizeof(uint32_t) * viewportSize.x);
-	_exporting = false;
-	_exportTimer.Stop();
+	_exportCondition.notify_one();
+	if (_exportThread.joinable()) { _exportThread.join(); }
 }
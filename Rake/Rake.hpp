@@ -3,14 +3,19 @@
 #include <Luna/Core/App.hpp>
 #include <Luna/Graphics/Vulkan/Common.hpp>
 #include <Luna/Utility/Time.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <glm/glm.hpp>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "DataTypes.hpp"
+#include "Tracer.hpp"
 
-class Tracer;
 class World;
 
 class Rake : public Luna::App {
@@ -26,11 +31,18 @@ class Rake : public Luna::App {
 	virtual void Update() override;
 
  private:
+	struct ExportRequest {
+		std::string Filename;
+		glm::uvec2 Size;
+		std::vector<Color> Pixels;  // Linear for EXR, gamma corrected for PNG.
+	};
+
 	void Render();
 	void Export();
 	void RequestCancel();
 	void RequestTrace(bool preview = false);
 	void Invalidate();
+	void LoadScenes();
 
 	void RenderRakeUI();
 	void RenderDockspace();
@@ -40,29 +52,43 @@ class Rake : public Luna::App {
 
 	bool CanExport() const;
 
-	void ExportThread(const std::string& filename, const glm::uvec2& size, const std::vector<Color> pixels);
+	void ExportThread();
+	void StopExportThread();
 
 	Luna::Vulkan::BufferHandle _copyBuffer;
 	Luna::Vulkan::ImageHandle _renderImage;
 	Luna::Utility::Stopwatch _renderTime;
 	std::unique_ptr<Tracer> _tracer;
 	glm::uvec2 _viewportSize = glm::uvec2(800, 600);
-	std::vector<Color> _pixels;
+	glm::uvec2 _renderSize   = glm::uvec2(0);  // Size of the traced image, the viewport may have changed since.
+	std::vector<Color> _pixels;  // Linear copy of the displayed image, for EXR exports.
 
 	unsigned int _currentWorld = 0;
-	std::vector<std::shared_ptr<World>> _worlds;
+	std::vector<std::shared_ptr<World>> _worlds;  // The built-in worlds, followed by the scene files on disk.
+	size_t _builtInWorldCount = 0;
+	uint32_t _selectedSphere  = 0;  // The sphere the World window moves around.
 	bool _dirty = false;
 
 	unsigned int _previewSamples  = 1;
+	unsigned int _previewLevels   = 3;
 	unsigned int _samplesPerPixel = 100;
+	TraceSettings _traceSettings;
+	bool _previewing = false;
 
 	uint64_t _raysCompleted        = 0;
 	unsigned int _samplesCompleted = 0;
 	unsigned int _samplesRequested = 0;
 
+	// Exports are written one after another on a thread of their own, so a slow write never holds up the UI and
+	// exports requested in the meantime wait their turn instead of being dropped.
 	std::thread _exportThread;
-	std::atomic_bool _exporting = false;
-	Luna::Utility::Stopwatch _exportTimer;
+	std::mutex _exportMutex;
+	std::condition_variable _exportCondition;
+	std::deque<ExportRequest> _exportQueue;
+	bool _exportStopping           = false;
+	std::atomic_bool _exporting    = false;  // Whether any export is queued or being written.
+	std::atomic<float> _exportTime = 0.0f;   // Seconds spent on the current exports, timed by the export thread.
+	bool _exportEXR                = false;
 	uint32_t _lastExport = 0;
 	uint32_t _autoExport = 100;
 
@@ -1,14 +1,88 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
-#include <random>
+#include <cstdint>
 
 #include "DataTypes.hpp"
 
+// Counter-based random number generator. Every value is a hash of a key and a counter, so a stream can be started at
+// any (pixel, sample, dimension) without carrying state over from previous pixels, and a render comes out the same no
+// matter which thread traces which pixel.
+class Sampler {
+ public:
+	Sampler() = default;
+	explicit Sampler(uint64_t seed) : _key(Mix(seed)) {}
+	Sampler(uint32_t pixel, uint32_t sample, uint32_t dimension = 0) {
+		Start(pixel, sample, dimension);
+	}
+
+	void Start(uint32_t pixel, uint32_t sample, uint32_t dimension = 0) {
+		_key       = Mix((static_cast<uint64_t>(pixel) << 32) | sample);
+		_dimension = dimension;
+	}
+	uint32_t GetDimension() const {
+		return _dimension;
+	}
+	void SetDimension(uint32_t dimension) {
+		_dimension = dimension;
+	}
+
+	uint64_t NextUInt64() {
+		return Value(_dimension++);
+	}
+	float NextFloat() {
+		return ToFloat(NextUInt64());
+	}
+	double NextDouble() {
+		return ToDouble(NextUInt64());
+	}
+
+	// Generate a whole run of dimensions at once. Each value only depends on its own counter, so there is no dependency
+	// between iterations and the compiler is free to vectorize the loop.
+	void NextFloats(float* values, uint32_t count) {
+		for (uint32_t i = 0; i < count; ++i) { values[i] = ToFloat(Value(_dimension + i)); }
+		_dimension += count;
+	}
+	void NextDoubles(double* values, uint32_t count) {
+		for (uint32_t i = 0; i < count; ++i) { values[i] = ToDouble(Value(_dimension + i)); }
+		_dimension += count;
+	}
+
+ private:
+	static constexpr uint64_t Gamma = 0x9e3779b97f4a7c15ull;
+
+	// SplitMix64 finalizer, a cheap bijective hash with full avalanche.
+	static uint64_t Mix(uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		return z ^ (z >> 31);
+	}
+	static float ToFloat(uint64_t bits) {
+		return static_cast<float>(bits >> 40) * 0x1.0p-24f;
+	}
+	static double ToDouble(uint64_t bits) {
+		return static_cast<double>(bits >> 11) * 0x1.0p-53;
+	}
+
+	uint64_t Value(uint32_t dimension) const {
+		return Mix(_key + static_cast<uint64_t>(dimension + 1) * Gamma);
+	}
+
+	uint64_t _key       = 0;
+	uint32_t _dimension = 0;
+};
+
+// The sampler behind the Random* functions below. The tracer restarts it for every pixel sample, render threads seed
+// it with their index and built-in worlds with their name. Anywhere else it keeps counting from the same seed on every
+// thread, so what a thread draws never depends on how many other threads happened to start before it.
+inline Sampler& ThreadSampler() {
+	static thread_local Sampler sampler(0);
+	return sampler;
+}
+
 inline float RandomFloat() {
-	static thread_local std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
-	static thread_local std::mt19937 generator;
-	return distribution(generator);
+	return ThreadSampler().NextFloat();
 }
 
 inline float RandomFloat(float min, float max) {
@@ -16,15 +90,17 @@ inline float RandomFloat(float min, float max) {
 }
 
 inline double RandomDouble() {
-	static thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
-	static thread_local std::mt19937 generator;
-	return distribution(generator);
+	return ThreadSampler().NextDouble();
 }
 
 inline double RandomDouble(double min, double max) {
 	return min + (max - min) * RandomDouble();
 }
 
+inline Real RandomReal() {
+	return static_cast<Real>(RandomDouble());
+}
+
 inline int RandomInt(int min, int max) {
 	return static_cast<int>(RandomDouble(min, max + 1));
 }
@@ -33,33 +109,25 @@ inline Color RandomColor(float min = 0.0, float max = 1.0) {
 	return Color(RandomFloat(min, max), RandomFloat(min, max), RandomFloat(min, max));
 }
 
+inline Vector3 RandomUnitVector() {
+	// The height of a uniformly distributed point on the sphere is itself uniform, so only the azimuth needs any trig.
+	const Real z   = 1 - 2 * RandomReal();
+	const Real r   = std::sqrt(std::max(Real(0), 1 - z * z));
+	const Real phi = 2 * Pi * RandomReal();
+	return Vector3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
 inline Vector3 RandomInUnitSphere() {
-	const auto u        = RandomDouble();
-	const auto v        = RandomDouble();
-	const auto theta    = u * 2.0 * Pi;
-	const auto phi      = glm::acos(2.0 * v - 1.0);
-	const auto r        = std::cbrt(RandomDouble());
-	const auto sinTheta = glm::sin(theta);
-	const auto cosTheta = glm::cos(theta);
-	const auto sinPhi   = glm::sin(phi);
-	const auto cosPhi   = glm::cos(phi);
-	const auto x        = r * sinPhi * cosTheta;
-	const auto y        = r * sinPhi * sinTheta;
-	const auto z        = r * cosPhi;
-	return Vector3(x, y, z);
+	return RandomUnitVector() * std::cbrt(RandomReal());
 }
 
 inline Vector3 RandomInHemisphere(const Vector3& normal) {
 	const Vector3 inUnitSphere = RandomInUnitSphere();
-	return (glm::dot(inUnitSphere, normal) > 0.0) ? inUnitSphere : -inUnitSphere;
-}
-
-inline Vector3 RandomUnitVector() {
-	return glm::normalize(RandomInUnitSphere());
+	return (glm::dot(inUnitSphere, normal) > 0) ? inUnitSphere : -inUnitSphere;
 }
 
 inline Vector3 RandomInUnitDisk() {
-	const double r     = glm::sqrt(RandomDouble(0.0, 1.0));
-	const double theta = RandomDouble(0.0, 1.0) * 2.0 * Pi;
-	return Vector3(r * glm::cos(theta), r * glm::sin(theta), 0.0);
+	const Real r     = std::sqrt(RandomReal());
+	const Real theta = 2 * Pi * RandomReal();
+	return Vector3(r * std::cos(theta), r * std::sin(theta), 0);
 }
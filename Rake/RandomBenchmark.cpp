@@ -0,0 +1,93 @@
+#include "RandomBenchmark.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <chrono>
+#include <random>
+
+#include "Random.hpp"
+
+using Luna::Log;
+
+namespace {
+constexpr uint32_t Iterations = 10'000'000;
+
+// The original implementations, kept here only as a baseline.
+namespace Legacy {
+double RandomDouble() {
+	static thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
+	static thread_local std::mt19937 generator;
+	return distribution(generator);
+}
+
+Vector3 RandomInUnitSphere() {
+	const auto u        = RandomDouble();
+	const auto v        = RandomDouble();
+	const auto theta    = u * 2.0 * Pi;
+	const auto phi      = glm::acos(2.0 * v - 1.0);
+	const auto r        = std::cbrt(RandomDouble());
+	const auto sinTheta = glm::sin(theta);
+	const auto cosTheta = glm::cos(theta);
+	const auto sinPhi   = glm::sin(phi);
+	const auto cosPhi   = glm::cos(phi);
+	return Vector3(r * sinPhi * cosTheta, r * sinPhi * sinTheta, r * cosPhi);
+}
+
+Vector3 RandomUnitVector() {
+	return glm::normalize(RandomInUnitSphere());
+}
+
+Vector3 RandomInUnitDisk() {
+	const double r     = glm::sqrt(RandomDouble());
+	const double theta = RandomDouble() * 2.0 * Pi;
+	return Vector3(r * glm::cos(theta), r * glm::sin(theta), 0.0);
+}
+}  // namespace Legacy
+
+template <typename Func>
+double Measure(Func&& func) {
+	// Accumulate every result so the compiler cannot throw the work away.
+	double sink      = 0.0;
+	const auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < Iterations; ++i) { sink += func(); }
+	const auto end       = std::chrono::steady_clock::now();
+	volatile double keep = sink;
+	(void) keep;
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / Iterations;
+}
+
+void Report(const char* name, double legacyNs, double currentNs) {
+	Log::Info("Benchmark", "{:<20} {:>8.2f}ns -> {:>8.2f}ns ({:.2f}x)", name, legacyNs, currentNs, legacyNs / currentNs);
+}
+}  // namespace
+
+int RunRandomBenchmark() {
+	Log::Info("Benchmark", "Timing {} calls of each random routine (mt19937 -> counter-based sampler).", Iterations);
+
+	Report("RandomDouble", Measure([]() { return Legacy::RandomDouble(); }), Measure([]() { return RandomDouble(); }));
+
+	// Batches of 8, as a whole camera ray or bounce would request them.
+	const double batchNs = Measure([]() {
+		double values[8];
+		ThreadSampler().NextDoubles(values, 8);
+		return values[0] + values[7];
+	});
+	const double legacyBatchNs = Measure([]() {
+		double values[8];
+		for (auto& value : values) { value = Legacy::RandomDouble(); }
+		return values[0] + values[7];
+	});
+	Report("8x RandomDouble", legacyBatchNs, batchNs);
+
+	Report("RandomInUnitSphere",
+	       Measure([]() { return Legacy::RandomInUnitSphere().x; }),
+	       Measure([]() { return RandomInUnitSphere().x; }));
+	Report("RandomUnitVector",
+	       Measure([]() { return Legacy::RandomUnitVector().x; }),
+	       Measure([]() { return RandomUnitVector().x; }));
+	Report("RandomInUnitDisk",
+	       Measure([]() { return Legacy::RandomInUnitDisk().x; }),
+	       Measure([]() { return RandomInUnitDisk().x; }));
+
+	return 0;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Times the Random.hpp sampling routines against the mt19937-based versions they replaced, and logs the results.
+// Returns the process exit code.
+int RunRandomBenchmark();
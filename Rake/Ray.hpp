@@ -1,14 +1,19 @@
 #pragma once
 
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
 #include "DataTypes.hpp"
 
 class Ray {
  public:
 	Ray() = default;
 	Ray(const Point3& origin, const Vector3& direction)
-			: Origin(origin), Direction(direction), InvDirection(1.0 / Direction) {}
+			: Origin(origin), Direction(direction), InvDirection(Real(1) / Direction) {}
 
-	Point3 At(double t) const {
+	Point3 At(Real t) const {
 		return Origin + t * Direction;
 	}
 
@@ -16,3 +21,28 @@ class Ray {
 	Vector3 Direction    = Vector3(0.0);
 	Vector3 InvDirection = Vector3(0.0);
 };
+
+// Push a surface point off the surface along its normal, far enough that a ray leaving from it cannot hit the same
+// surface again because of rounding error (Wächter and Binder, "A Fast and Robust Method for Avoiding
+// Self-Intersection", Ray Tracing Gems ch. 6). The offset is a fixed number of ULPs, so it scales with the magnitude of
+// the point instead of being one epsilon that is too large near the origin and too small far away from it. Close to the
+// origin, where ULPs get tiny, a small absolute offset is used instead.
+// The paper's constants are for floats: IntScale is a number of float ULPs and FloatScale an absolute offset. Doubles
+// round 2^29 times more finely, so both are scaled to give offsets 2^10 times smaller relative to the point:
+// IntScale counts 2^19 times as many of the much smaller double ULPs, and FloatScale shrinks by 2^10 to match.
+inline Point3 OffsetRayOrigin(const Point3& p, const Vector3& n) {
+	using Bits                   = std::conditional_t<std::is_same_v<Real, float>, int32_t, int64_t>;
+	constexpr bool IsFloat       = std::is_same_v<Real, float>;
+	constexpr Real OriginEpsilon = Real(1.0 / 32.0);
+	constexpr Real FloatScale    = IsFloat ? Real(1.0 / 65536.0) : Real(1.0 / 65536.0 / 1024.0);
+	constexpr Real IntScale      = IsFloat ? Real(256) : Real(256.0 * (1ull << 19));
+
+	Point3 result;
+	for (int axis = 0; axis < 3; ++axis) {
+		const Bits offset = static_cast<Bits>(IntScale * n[axis]);
+		const Real moved  = std::bit_cast<Real>(std::bit_cast<Bits>(p[axis]) + (p[axis] < 0 ? -offset : offset));
+		result[axis]     = std::abs(p[axis]) < OriginEpsilon ? p[axis] + FloatScale * n[axis] : moved;
+	}
+
+	return result;
+}
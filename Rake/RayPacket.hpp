@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+
+#include "Ray.hpp"
+#include "SIMD.hpp"
+
+// A bundle of PacketWidth rays stored as single-precision structure-of-arrays, used to trace coherent rays together.
+struct RayPacket {
+	RayPacket() = default;
+	RayPacket(const std::array<Ray, PacketWidth>& rays) {
+		float lanes[9][PacketWidth];
+		for (uint32_t i = 0; i < PacketWidth; ++i) {
+			for (int axis = 0; axis < 3; ++axis) {
+				lanes[axis][i]     = static_cast<float>(rays[i].Origin[axis]);
+				lanes[axis + 3][i] = static_cast<float>(rays[i].Direction[axis]);
+				lanes[axis + 6][i] = static_cast<float>(rays[i].InvDirection[axis]);
+			}
+		}
+		for (int axis = 0; axis < 3; ++axis) {
+			Origin[axis]       = SimdFloat::Load(lanes[axis]);
+			Direction[axis]    = SimdFloat::Load(lanes[axis + 3]);
+			InvDirection[axis] = SimdFloat::Load(lanes[axis + 6]);
+		}
+	}
+
+	Ray GetRay(uint32_t lane) const {
+		return Ray(Point3(Origin[0][lane], Origin[1][lane], Origin[2][lane]),
+		           Vector3(Direction[0][lane], Direction[1][lane], Direction[2][lane]));
+	}
+
+	SimdFloat Origin[3];
+	SimdFloat Direction[3];
+	SimdFloat InvDirection[3];
+};
@@ -8,7 +8,20 @@ static Point3 GetPrimaryDir(const Vector3& normal) {
 	return glm::normalize(glm::dot(maxAB, maxAB) < glm::dot(c, c) ? c : maxAB);
 }
 
-XYRectangle::XYRectangle(const Point2& min, const Point2& max, double z, const std::shared_ptr<IMaterial>& material)
+void SetRectangleHit(const Ray& ray, RectanglePlane plane, Real t, HitRecord& outRecord) {
+	static const Vector3 normals[] = {Vector3(0, 0, 1), Vector3(0, 1, 0), Vector3(1, 0, 0)};
+	static const Vector3 uAxes[]   = {GetPrimaryDir(normals[0]), GetPrimaryDir(normals[1]), GetPrimaryDir(normals[2])};
+
+	const Vector3& outwardNormal = normals[int(plane)];
+	const Vector3& u             = uAxes[int(plane)];
+	const Vector3 v              = glm::cross(outwardNormal, u);
+	outRecord.Distance           = t;
+	outRecord.Point              = ray.At(t);
+	outRecord.SetFaceNormal(ray, outwardNormal);
+	outRecord.UV = Point2(glm::dot(u, outRecord.Point), glm::dot(v, outRecord.Point));
+}
+
+XYRectangle::XYRectangle(const Point2& min, const Point2& max, Real z, const std::shared_ptr<IMaterial>& material)
 		: Min(min), Max(max), Z(z), Material(material) {}
 
 bool XYRectangle::Bounds(AABB& outBounds) const {
@@ -17,27 +30,20 @@ bool XYRectangle::Bounds(AABB& outBounds) const {
 	return true;
 }
 
-bool XYRectangle::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const {
-	const auto t = (Z - ray.Origin.z) / ray.Direction.z;
-	if (t < tMin || t > tMax) { return false; }
-
-	const auto x = ray.Origin.x + t * ray.Direction.x;
-	const auto y = ray.Origin.y + t * ray.Direction.y;
-	if (x < Min.x || x > Max.x || y < Min.y || y > Max.y) { return false; }
-
-	outRecord.Distance       = t;
-	outRecord.Point          = ray.At(outRecord.Distance);
-	const auto outwardNormal = Point3(0, 0, 1);
-	outRecord.SetFaceNormal(ray, outwardNormal);
+bool XYRectangle::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	Real t;
+	if (!IntersectRectangle(ray, RectanglePlane::XY, Min, Max, Z, tMin, tMax, t)) { return false; }
+	SetRectangleHit(ray, RectanglePlane::XY, t, outRecord);
 	outRecord.Material = Material.get();
-	const auto u       = GetPrimaryDir(outwardNormal);
-	const auto v       = glm::cross(outwardNormal, u);
-	outRecord.UV       = Point2(glm::dot(u, outRecord.Point), glm::dot(v, outRecord.Point));
 
 	return true;
 }
 
-XZRectangle::XZRectangle(const Point2& min, const Point2& max, double y, const std::shared_ptr<IMaterial>& material)
+SimdMask XYRectangle::IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const {
+	return IntersectRectanglePacket(packet, RectanglePlane::XY, Min, Max, Z, tMin, tMax);
+}
+
+XZRectangle::XZRectangle(const Point2& min, const Point2& max, Real y, const std::shared_ptr<IMaterial>& material)
 		: Min(min), Max(max), Y(y), Material(material) {}
 
 bool XZRectangle::Bounds(AABB& outBounds) const {
@@ -46,27 +52,20 @@ bool XZRectangle::Bounds(AABB& outBounds) const {
 	return true;
 }
 
-bool XZRectangle::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const {
-	const auto t = (Y - ray.Origin.y) / ray.Direction.y;
-	if (t < tMin || t > tMax) { return false; }
-
-	const auto x = ray.Origin.x + t * ray.Direction.x;
-	const auto z = ray.Origin.z + t * ray.Direction.z;
-	if (x < Min.x || x > Max.x || z < Min.y || z > Max.y) { return false; }
-
-	outRecord.Distance       = t;
-	outRecord.Point          = ray.At(outRecord.Distance);
-	const auto outwardNormal = Point3(0, 1, 0);
-	outRecord.SetFaceNormal(ray, outwardNormal);
+bool XZRectangle::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	Real t;
+	if (!IntersectRectangle(ray, RectanglePlane::XZ, Min, Max, Y, tMin, tMax, t)) { return false; }
+	SetRectangleHit(ray, RectanglePlane::XZ, t, outRecord);
 	outRecord.Material = Material.get();
-	const auto u       = GetPrimaryDir(outwardNormal);
-	const auto v       = glm::cross(outwardNormal, u);
-	outRecord.UV       = Point2(glm::dot(u, outRecord.Point), glm::dot(v, outRecord.Point));
 
 	return true;
 }
 
-YZRectangle::YZRectangle(const Point2& min, const Point2& max, double x, const std::shared_ptr<IMaterial>& material)
+SimdMask XZRectangle::IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const {
+	return IntersectRectanglePacket(packet, RectanglePlane::XZ, Min, Max, Y, tMin, tMax);
+}
+
+YZRectangle::YZRectangle(const Point2& min, const Point2& max, Real x, const std::shared_ptr<IMaterial>& material)
 		: Min(min), Max(max), X(x), Material(material) {}
 
 bool YZRectangle::Bounds(AABB& outBounds) const {
@@ -75,22 +74,36 @@ bool YZRectangle::Bounds(AABB& outBounds) const {
 	return true;
 }
 
-bool YZRectangle::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const {
-	const auto t = (X - ray.Origin.x) / ray.Direction.x;
-	if (t < tMin || t > tMax) { return false; }
-
-	const auto y = ray.Origin.y + t * ray.Direction.y;
-	const auto z = ray.Origin.z + t * ray.Direction.z;
-	if (y < Min.x || y > Max.x || z < Min.y || z > Max.y) { return false; }
-
-	outRecord.Distance       = t;
-	outRecord.Point          = ray.At(outRecord.Distance);
-	const auto outwardNormal = Point3(1, 0, 0);
-	outRecord.SetFaceNormal(ray, outwardNormal);
+bool YZRectangle::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	Real t;
+	if (!IntersectRectangle(ray, RectanglePlane::YZ, Min, Max, X, tMin, tMax, t)) { return false; }
+	SetRectangleHit(ray, RectanglePlane::YZ, t, outRecord);
 	outRecord.Material = Material.get();
-	const auto u       = GetPrimaryDir(outwardNormal);
-	const auto v       = glm::cross(outwardNormal, u);
-	outRecord.UV       = Point2(glm::dot(u, outRecord.Point), glm::dot(v, outRecord.Point));
 
 	return true;
 }
+
+SimdMask YZRectangle::IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const {
+	return IntersectRectanglePacket(packet, RectanglePlane::YZ, Min, Max, X, tMin, tMax);
+}
+
+void XYRectangle::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher.Data(sizeof(Min), &Min);
+	hasher.Data(sizeof(Max), &Max);
+	hasher(Z);
+	HashMaterial(hasher, Material.get());
+}
+
+void XZRectangle::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher.Data(sizeof(Min), &Min);
+	hasher.Data(sizeof(Max), &Max);
+	hasher(Y);
+	HashMaterial(hasher, Material.get());
+}
+
+void YZRectangle::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher.Data(sizeof(Min), &Min);
+	hasher.Data(sizeof(Max), &Max);
+	hasher(X);
+	HashMaterial(hasher, Material.get());
+}
@@ -1,48 +1,115 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 #include "IHittable.hpp"
 #include "IMaterial.hpp"
 
+// The plane an axis-aligned rectangle lies in. Its normal points along the remaining axis.
+enum class RectanglePlane : uint8_t { XY, XZ, YZ };
+
 class XYRectangle : public IHittable {
  public:
 	XYRectangle() = default;
-	XYRectangle(const Point2& min, const Point2& max, double z, const std::shared_ptr<IMaterial>& material);
+	XYRectangle(const Point2& min, const Point2& max, Real z, const std::shared_ptr<IMaterial>& material);
 
 	virtual bool Bounds(AABB& outBounds) const override;
-	virtual bool Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const override;
 
 	Point2 Min;
 	Point2 Max;
-	double Z = 0.0;
+	Real Z = 0.0;
 	std::shared_ptr<IMaterial> Material;
 };
 
 class XZRectangle : public IHittable {
  public:
 	XZRectangle() = default;
-	XZRectangle(const Point2& min, const Point2& max, double y, const std::shared_ptr<IMaterial>& material);
+	XZRectangle(const Point2& min, const Point2& max, Real y, const std::shared_ptr<IMaterial>& material);
 
 	virtual bool Bounds(AABB& outBounds) const override;
-	virtual bool Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const override;
 
 	Point2 Min;
 	Point2 Max;
-	double Y = 0.0;
+	Real Y = 0.0;
 	std::shared_ptr<IMaterial> Material;
 };
 
 class YZRectangle : public IHittable {
  public:
 	YZRectangle() = default;
-	YZRectangle(const Point2& min, const Point2& max, double x, const std::shared_ptr<IMaterial>& material);
+	YZRectangle(const Point2& min, const Point2& max, Real x, const std::shared_ptr<IMaterial>& material);
 
 	virtual bool Bounds(AABB& outBounds) const override;
-	virtual bool Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const override;
 
 	Point2 Min;
 	Point2 Max;
-	double X = 0.0;
+	Real X = 0.0;
 	std::shared_ptr<IMaterial> Material;
 };
+
+// The axis along the normal of a plane, and the two axes it spans, in the order rectangles give their extents in.
+inline void GetRectangleAxes(RectanglePlane plane, int& outNormal, int& outU, int& outV) {
+	outNormal = plane == RectanglePlane::XY ? 2 : (plane == RectanglePlane::XZ ? 1 : 0);
+	outU      = plane == RectanglePlane::YZ ? 1 : 0;
+	outV      = plane == RectanglePlane::XY ? 1 : 2;
+}
+
+// The rectangle test, shared with everything that keeps its rectangles in bulk instead of as rectangle objects. The
+// rectangle lies at offset along the normal of its plane and spans [min, max] along the other two axes, in order.
+inline bool IntersectRectangle(const Ray& ray,
+                               RectanglePlane plane,
+                               const Point2& min,
+                               const Point2& max,
+                               Real offset,
+                               Real tMin,
+                               Real tMax,
+                               Real& outT) {
+	int normalAxis, uAxis, vAxis;
+	GetRectangleAxes(plane, normalAxis, uAxis, vAxis);
+
+	const auto t = (offset - ray.Origin[normalAxis]) / ray.Direction[normalAxis];
+	if (t < tMin || t > tMax) { return false; }
+
+	const auto u = ray.Origin[uAxis] + t * ray.Direction[uAxis];
+	const auto v = ray.Origin[vAxis] + t * ray.Direction[vAxis];
+	if (u < min.x || u > max.x || v < min.y || v > max.y) { return false; }
+	outT = t;
+
+	return true;
+}
+
+// Fills in everything about a hit at distance t except for the material.
+void SetRectangleHit(const Ray& ray, RectanglePlane plane, Real t, HitRecord& outRecord);
+
+inline SimdMask IntersectRectanglePacket(const RayPacket& packet,
+                                         RectanglePlane plane,
+                                         const Point2& min,
+                                         const Point2& max,
+                                         Real offset,
+                                         const SimdFloat& tMin,
+                                         SimdFloat& tMax) {
+	int normalAxis, uAxis, vAxis;
+	GetRectangleAxes(plane, normalAxis, uAxis, vAxis);
+
+	const SimdFloat t =
+		(SimdFloat(static_cast<float>(offset)) - packet.Origin[normalAxis]) * packet.InvDirection[normalAxis];
+	const SimdFloat u = packet.Origin[uAxis] + t * packet.Direction[uAxis];
+	const SimdFloat v = packet.Origin[vAxis] + t * packet.Direction[vAxis];
+
+	const SimdMask hit = (t >= tMin) & (t <= tMax) & (u >= SimdFloat(static_cast<float>(min.x))) &
+	                     (u <= SimdFloat(static_cast<float>(max.x))) & (v >= SimdFloat(static_cast<float>(min.y))) &
+	                     (v <= SimdFloat(static_cast<float>(max.y)));
+	tMax = Select(hit, t, tMax);
+
+	return hit;
+}
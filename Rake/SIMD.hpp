@@ -0,0 +1,275 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(RAKE_NO_SIMD)
+// Plain C++ even where SSE or AVX2 are available, to test the fallback.
+#elif defined(__AVX2__)
+#	include <immintrin.h>
+#	define RAKE_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define RAKE_SIMD_SSE
+#endif
+
+// Thin wrappers around the widest float vector we were compiled for. Packets are 8 wide with AVX2, 4 wide with SSE,
+// and fall back to plain 4-element arrays elsewhere.
+#if defined(RAKE_SIMD_AVX2)
+constexpr uint32_t PacketWidth = 8;
+#else
+constexpr uint32_t PacketWidth = 4;
+#endif
+
+struct SimdMask {
+#if defined(RAKE_SIMD_AVX2)
+	__m256 V;
+#elif defined(RAKE_SIMD_SSE)
+	__m128 V;
+#else
+	uint32_t V[PacketWidth];
+#endif
+
+	static SimdMask None() {
+#if defined(RAKE_SIMD_AVX2)
+		return {_mm256_setzero_ps()};
+#elif defined(RAKE_SIMD_SSE)
+		return {_mm_setzero_ps()};
+#else
+		return {};
+#endif
+	}
+
+	uint32_t Bits() const {
+#if defined(RAKE_SIMD_AVX2)
+		return static_cast<uint32_t>(_mm256_movemask_ps(V));
+#elif defined(RAKE_SIMD_SSE)
+		return static_cast<uint32_t>(_mm_movemask_ps(V));
+#else
+		uint32_t bits = 0;
+		for (uint32_t i = 0; i < PacketWidth; ++i) { bits |= (V[i] ? 1u : 0u) << i; }
+		return bits;
+#endif
+	}
+	bool Any() const {
+		return Bits() != 0;
+	}
+	bool All() const {
+		return Bits() == (1u << PacketWidth) - 1;
+	}
+	bool operator[](uint32_t lane) const {
+		return (Bits() >> lane) & 1;
+	}
+
+	friend SimdMask operator&(const SimdMask& a, const SimdMask& b) {
+#if defined(RAKE_SIMD_AVX2)
+		return {_mm256_and_ps(a.V, b.V)};
+#elif defined(RAKE_SIMD_SSE)
+		return {_mm_and_ps(a.V, b.V)};
+#else
+		SimdMask r;
+		for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = a.V[i] & b.V[i]; }
+		return r;
+#endif
+	}
+	friend SimdMask operator|(const SimdMask& a, const SimdMask& b) {
+#if defined(RAKE_SIMD_AVX2)
+		return {_mm256_or_ps(a.V, b.V)};
+#elif defined(RAKE_SIMD_SSE)
+		return {_mm_or_ps(a.V, b.V)};
+#else
+		SimdMask r;
+		for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = a.V[i] | b.V[i]; }
+		return r;
+#endif
+	}
+	// Returns a & ~b.
+	friend SimdMask AndNot(const SimdMask& a, const SimdMask& b) {
+#if defined(RAKE_SIMD_AVX2)
+		return {_mm256_andnot_ps(b.V, a.V)};
+#elif defined(RAKE_SIMD_SSE)
+		return {_mm_andnot_ps(b.V, a.V)};
+#else
+		SimdMask r;
+		for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = a.V[i] & ~b.V[i]; }
+		return r;
+#endif
+	}
+};
+
+struct SimdFloat {
+#if defined(RAKE_SIMD_AVX2)
+	__m256 V;
+#elif defined(RAKE_SIMD_SSE)
+	__m128 V;
+#else
+	float V[PacketWidth];
+#endif
+
+	SimdFloat() = default;
+#if defined(RAKE_SIMD_AVX2)
+	SimdFloat(__m256 v) : V(v) {}
+	explicit SimdFloat(float f) : V(_mm256_set1_ps(f)) {}
+#elif defined(RAKE_SIMD_SSE)
+	SimdFloat(__m128 v) : V(v) {}
+	explicit SimdFloat(float f) : V(_mm_set1_ps(f)) {}
+#else
+	explicit SimdFloat(float f) {
+		for (uint32_t i = 0; i < PacketWidth; ++i) { V[i] = f; }
+	}
+#endif
+
+	static SimdFloat Load(const float* data) {
+#if defined(RAKE_SIMD_AVX2)
+		return _mm256_loadu_ps(data);
+#elif defined(RAKE_SIMD_SSE)
+		return _mm_loadu_ps(data);
+#else
+		SimdFloat r;
+		for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = data[i]; }
+		return r;
+#endif
+	}
+	// Loads PacketWidth bytes as unsigned integers, converted to floats.
+	static SimdFloat LoadBytes(const uint8_t* data) {
+#if defined(RAKE_SIMD_AVX2)
+		return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data))));
+#elif defined(RAKE_SIMD_SSE)
+		int32_t bytes;
+		std::memcpy(&bytes, data, sizeof(bytes));
+		const __m128i zero  = _mm_setzero_si128();
+		const __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+#else
+		SimdFloat r;
+		for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = data[i]; }
+		return r;
+#endif
+	}
+	void Store(float* data) const {
+#if defined(RAKE_SIMD_AVX2)
+		_mm256_storeu_ps(data, V);
+#elif defined(RAKE_SIMD_SSE)
+		_mm_storeu_ps(data, V);
+#else
+		for (uint32_t i = 0; i < PacketWidth; ++i) { data[i] = V[i]; }
+#endif
+	}
+	float operator[](uint32_t lane) const {
+		float lanes[PacketWidth];
+		Store(lanes);
+		return lanes[lane];
+	}
+};
+
+#if defined(RAKE_SIMD_AVX2)
+#	define RAKE_SIMD_BINARY_OP(op, intrinsic)                                \
+		inline SimdFloat operator op(const SimdFloat& a, const SimdFloat& b) { \
+			return intrinsic(a.V, b.V);                                          \
+		}
+#	define RAKE_SIMD_COMPARE_OP(op, predicate)                              \
+		inline SimdMask operator op(const SimdFloat& a, const SimdFloat& b) { \
+			return {_mm256_cmp_ps(a.V, b.V, predicate)};                        \
+		}
+RAKE_SIMD_BINARY_OP(+, _mm256_add_ps)
+RAKE_SIMD_BINARY_OP(-, _mm256_sub_ps)
+RAKE_SIMD_BINARY_OP(*, _mm256_mul_ps)
+RAKE_SIMD_BINARY_OP(/, _mm256_div_ps)
+RAKE_SIMD_COMPARE_OP(<, _CMP_LT_OQ)
+RAKE_SIMD_COMPARE_OP(<=, _CMP_LE_OQ)
+RAKE_SIMD_COMPARE_OP(>, _CMP_GT_OQ)
+RAKE_SIMD_COMPARE_OP(>=, _CMP_GE_OQ)
+
+inline SimdFloat Min(const SimdFloat& a, const SimdFloat& b) {
+	return _mm256_min_ps(a.V, b.V);
+}
+inline SimdFloat Max(const SimdFloat& a, const SimdFloat& b) {
+	return _mm256_max_ps(a.V, b.V);
+}
+inline SimdFloat Sqrt(const SimdFloat& a) {
+	return _mm256_sqrt_ps(a.V);
+}
+// Picks a where the mask is set, b elsewhere.
+inline SimdFloat Select(const SimdMask& mask, const SimdFloat& a, const SimdFloat& b) {
+	return _mm256_blendv_ps(b.V, a.V, mask.V);
+}
+#elif defined(RAKE_SIMD_SSE)
+#	define RAKE_SIMD_BINARY_OP(op, intrinsic)                                \
+		inline SimdFloat operator op(const SimdFloat& a, const SimdFloat& b) { \
+			return intrinsic(a.V, b.V);                                          \
+		}
+#	define RAKE_SIMD_COMPARE_OP(op, intrinsic)                              \
+		inline SimdMask operator op(const SimdFloat& a, const SimdFloat& b) { \
+			return {intrinsic(a.V, b.V)};                                       \
+		}
+RAKE_SIMD_BINARY_OP(+, _mm_add_ps)
+RAKE_SIMD_BINARY_OP(-, _mm_sub_ps)
+RAKE_SIMD_BINARY_OP(*, _mm_mul_ps)
+RAKE_SIMD_BINARY_OP(/, _mm_div_ps)
+RAKE_SIMD_COMPARE_OP(<, _mm_cmplt_ps)
+RAKE_SIMD_COMPARE_OP(<=, _mm_cmple_ps)
+RAKE_SIMD_COMPARE_OP(>, _mm_cmpgt_ps)
+RAKE_SIMD_COMPARE_OP(>=, _mm_cmpge_ps)
+
+inline SimdFloat Min(const SimdFloat& a, const SimdFloat& b) {
+	return _mm_min_ps(a.V, b.V);
+}
+inline SimdFloat Max(const SimdFloat& a, const SimdFloat& b) {
+	return _mm_max_ps(a.V, b.V);
+}
+inline SimdFloat Sqrt(const SimdFloat& a) {
+	return _mm_sqrt_ps(a.V);
+}
+// Picks a where the mask is set, b elsewhere.
+inline SimdFloat Select(const SimdMask& mask, const SimdFloat& a, const SimdFloat& b) {
+	return _mm_or_ps(_mm_and_ps(mask.V, a.V), _mm_andnot_ps(mask.V, b.V));
+}
+#else
+#	define RAKE_SIMD_BINARY_OP(op, unused)                                        \
+		inline SimdFloat operator op(const SimdFloat& a, const SimdFloat& b) {      \
+			SimdFloat r;                                                              \
+			for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = a.V[i] op b.V[i]; } \
+			return r;                                                                 \
+		}
+#	define RAKE_SIMD_COMPARE_OP(op, unused)                                                  \
+		inline SimdMask operator op(const SimdFloat& a, const SimdFloat& b) {                  \
+			SimdMask r;                                                                          \
+			for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = a.V[i] op b.V[i] ? ~0u : 0u; } \
+			return r;                                                                            \
+		}
+RAKE_SIMD_BINARY_OP(+, 0)
+RAKE_SIMD_BINARY_OP(-, 0)
+RAKE_SIMD_BINARY_OP(*, 0)
+RAKE_SIMD_BINARY_OP(/, 0)
+RAKE_SIMD_COMPARE_OP(<, 0)
+RAKE_SIMD_COMPARE_OP(<=, 0)
+RAKE_SIMD_COMPARE_OP(>, 0)
+RAKE_SIMD_COMPARE_OP(>=, 0)
+
+// Written the way minps and maxps behave, so that b comes out whenever either value is NaN.
+inline SimdFloat Min(const SimdFloat& a, const SimdFloat& b) {
+	SimdFloat r;
+	for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = a.V[i] < b.V[i] ? a.V[i] : b.V[i]; }
+	return r;
+}
+inline SimdFloat Max(const SimdFloat& a, const SimdFloat& b) {
+	SimdFloat r;
+	for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = a.V[i] > b.V[i] ? a.V[i] : b.V[i]; }
+	return r;
+}
+inline SimdFloat Sqrt(const SimdFloat& a) {
+	SimdFloat r;
+	for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = std::sqrt(a.V[i]); }
+	return r;
+}
+// Picks a where the mask is set, b elsewhere.
+inline SimdFloat Select(const SimdMask& mask, const SimdFloat& a, const SimdFloat& b) {
+	SimdFloat r;
+	for (uint32_t i = 0; i < PacketWidth; ++i) { r.V[i] = mask.V[i] ? a.V[i] : b.V[i]; }
+	return r;
+}
+#endif
+
+#undef RAKE_SIMD_BINARY_OP
+#undef RAKE_SIMD_COMPARE_OP
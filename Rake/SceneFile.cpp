@@ -0,0 +1,825 @@
+#include "SceneFile.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <Luna/Utility/Time.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <glm/gtc/matrix_transform.hpp>
+#include <map>
+#include <new>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "CheckerTexture.hpp"
+#include "ImageTexture.hpp"
+#include "Instance.hpp"
+#include "LinearBVH.hpp"
+#include "MappedFile.hpp"
+#include "Materials/DielectricMaterial.hpp"
+#include "Materials/DiffuseLightMaterial.hpp"
+#include "Materials/GradientSkyMaterial.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "Materials/MetalMaterial.hpp"
+#include "Materials/SolidSkyMaterial.hpp"
+#include "MeshLoader.hpp"
+#include "Scenes.hpp"
+#include "SolidTexture.hpp"
+#include "SphereSet.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+namespace {
+constexpr char Magic[8]       = {'R', 'A', 'K', 'E', 'S', 'C', 'N', 'E'};
+constexpr uint32_t Version    = 2;
+constexpr size_t SectionAlign = 64;
+constexpr int32_t NoTexture   = -1;
+
+enum class SkyType : uint32_t { Gradient, Solid };
+enum class TextureType : uint32_t { Solid, Checker, Image };
+enum class MaterialType : uint32_t { Lambertian, Metal, Dielectric, Light };
+enum class MeshType : uint32_t { File, Torus };
+enum class ObjectType : uint32_t { Plane, Rectangle, Mesh, Instance };
+
+// Everything in the cache is plain data, so a cache is only ever read back by the same build that wrote it.
+struct SkyRecord {
+	SkyType Type    = SkyType::Gradient;
+	int32_t Texture = NoTexture;
+	float ColorA[3] = {1.0f, 1.0f, 1.0f};
+	float ColorB[3] = {0.5f, 0.7f, 1.0f};
+	float Gradient  = 0.5f;
+};
+
+struct TextureRecord {
+	TextureType Type;
+	uint32_t Path;  // Offset into the string section.
+	float ColorA[3];
+	float ColorB[3];
+	float Scale[2];
+};
+
+struct MaterialRecord {
+	MaterialType Type;
+	int32_t Texture;
+	float Color[3];
+	float Parameter;  // Roughness of metals, index of refraction of dielectrics.
+};
+
+struct MeshRecord {
+	MeshType Type;
+	uint32_t Path;
+	float MajorRadius;
+	float MinorRadius;
+	uint32_t MajorSegments;
+	uint32_t MinorSegments;
+};
+
+// The primitives that are not spheres. There are few enough of them to become one object each.
+struct ObjectRecord {
+	ObjectType Type;
+	uint32_t Axis;  // Planes and rectangles: 0 for XY, 1 for XZ, 2 for YZ.
+	uint32_t Mesh;
+	uint32_t Material;
+	float Min[2];
+	float Max[2];
+	float Offset;
+	float Transform[16];
+};
+
+struct Section {
+	uint64_t Offset;
+	uint64_t Count;
+};
+
+struct CacheHeader {
+	char Magic[8];
+	uint32_t Version;
+	uint32_t RealSize;  // Size of Real in the build that wrote the cache, which has to be the one reading it.
+	uint32_t Name;
+	uint64_t SourceSize;  // Size and modification time of the scene file the cache was compiled from.
+	int64_t SourceTime;
+	float CameraPosition[3];
+	float CameraTarget[3];
+	float VerticalFOV;
+	float CameraAperture;
+	float CameraFocusDistance;
+	SkyRecord Sky;
+	Section Strings;
+	Section Textures;
+	Section Materials;
+	Section Meshes;
+	Section Objects;
+	Section Spheres;  // Spheres and their material indices, in BVH leaf order.
+	Section SphereMaterials;
+	Section SphereNodes;
+};
+
+// A scene as it is parsed, before it is laid out as a cache.
+struct SceneData {
+	std::string Name;
+	float CameraPosition[3]   = {0.0f, 0.0f, 0.0f};
+	float CameraTarget[3]     = {0.0f, 0.0f, -1.0f};
+	float VerticalFOV         = 90.0f;
+	float CameraAperture      = 0.01f;
+	float CameraFocusDistance = 100.0f;
+	SkyRecord Sky;
+	std::string Strings;
+	std::vector<TextureRecord> Textures;
+	std::vector<MaterialRecord> Materials;
+	std::vector<MeshRecord> Meshes;
+	std::vector<ObjectRecord> Objects;
+	std::vector<PackedSphere> Spheres;
+	std::vector<uint32_t> SphereMaterials;
+	std::vector<LinearBVHNode> SphereNodes;
+};
+
+size_t AlignSection(size_t offset) {
+	return (offset + SectionAlign - 1) & ~(SectionAlign - 1);
+}
+
+template <typename T>
+const T* GetSection(const uint8_t* data, const Section& section) {
+	return reinterpret_cast<const T*>(data + section.Offset);
+}
+
+template <typename T>
+std::span<const T> GetSpan(const uint8_t* data, const Section& section) {
+	return {GetSection<T>(data, section), size_t(section.Count)};
+}
+
+bool IsSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Tokenizer over a single statement.
+class StatementParser {
+ public:
+	StatementParser(std::string_view line) : _line(line) {}
+
+	bool AtEnd() {
+		SkipSpace();
+		return _position >= _line.size();
+	}
+
+	std::string_view NextToken() {
+		SkipSpace();
+		const size_t begin = _position;
+		while (_position < _line.size() && !IsSpace(_line[_position])) { ++_position; }
+
+		return _line.substr(begin, _position - begin);
+	}
+
+	// Everything up to the end of the line, for names and paths that may contain spaces.
+	std::string_view Rest() {
+		SkipSpace();
+		size_t end = _line.size();
+		while (end > _position && IsSpace(_line[end - 1])) { --end; }
+		const auto rest = _line.substr(_position, end - _position);
+		_position       = _line.size();
+
+		return rest;
+	}
+
+	template <typename T>
+	bool Next(T& outValue) {
+		return Parse(NextToken(), outValue);
+	}
+
+	bool Next(float* outValues, int count) {
+		for (int i = 0; i < count; ++i) {
+			if (!Next(outValues[i])) { return false; }
+		}
+
+		return true;
+	}
+
+	template <typename T>
+	static bool Parse(std::string_view token, T& outValue) {
+		const auto result = std::from_chars(token.data(), token.data() + token.size(), outValue);
+
+		return !token.empty() && result.ec == std::errc() && result.ptr == token.data() + token.size();
+	}
+
+ private:
+	void SkipSpace() {
+		while (_position < _line.size() && IsSpace(_line[_position])) { ++_position; }
+	}
+
+	std::string_view _line;
+	size_t _position = 0;
+};
+
+using NameMap = std::map<std::string, uint32_t, std::less<>>;
+
+uint32_t AddString(SceneData& scene, std::string_view string) {
+	const uint32_t offset = static_cast<uint32_t>(scene.Strings.size());
+	scene.Strings.append(string);
+	scene.Strings.push_back('\0');
+
+	return offset;
+}
+
+bool ParseAxis(std::string_view token, uint32_t& outAxis) {
+	if (token == "xy") {
+		outAxis = 0;
+	} else if (token == "xz") {
+		outAxis = 1;
+	} else if (token == "yz") {
+		outAxis = 2;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+bool ParseScene(const std::string& filename, SceneData& outScene) {
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+	if (!file) {
+		Log::Error("SceneFile", "Failed to open scene '{}'.", filename);
+		return false;
+	}
+	std::string text(static_cast<size_t>(file.tellg()), '\0');
+	file.seekg(0);
+	if (!file.read(text.data(), text.size())) {
+		Log::Error("SceneFile", "Failed to read scene '{}'.", filename);
+		return false;
+	}
+
+	NameMap textures;
+	NameMap materials;
+	NameMap meshes;
+	// Big scenes tend to give runs of primitives the same material, so remember the last one that was looked up.
+	std::string_view lastMaterialName;
+	uint32_t lastMaterial = 0;
+
+	size_t lineNumber = 0;
+	std::string_view statement;
+	const auto Fail = [&](std::string_view reason) {
+		Log::Error("SceneFile", "{}:{}: {} in '{}'.", filename, lineNumber, reason, statement);
+		return false;
+	};
+	const auto Define = [&](NameMap& names, std::string_view name, size_t index) {
+		return !name.empty() && names.emplace(std::string(name), static_cast<uint32_t>(index)).second;
+	};
+	const auto Find = [](const NameMap& names, std::string_view name, uint32_t& outIndex) {
+		const auto it = names.find(name);
+		if (it == names.end()) { return false; }
+		outIndex = it->second;
+
+		return true;
+	};
+	const auto FindMaterial = [&](std::string_view name, uint32_t& outIndex) {
+		if (name != lastMaterialName || lastMaterialName.empty()) {
+			if (!Find(materials, name, lastMaterial)) { return false; }
+			lastMaterialName = name;
+		}
+		outIndex = lastMaterial;
+
+		return true;
+	};
+	// A color is given as three numbers, anything else names a texture.
+	const auto ParseColorOrTexture = [&](StatementParser& parser, float outColor[3], int32_t& outTexture) {
+		const auto token = parser.NextToken();
+		if (StatementParser::Parse(token, outColor[0])) {
+			outTexture = NoTexture;
+			return parser.Next(outColor + 1, 2);
+		}
+		uint32_t texture;
+		if (!Find(textures, token, texture)) { return false; }
+		outTexture = static_cast<int32_t>(texture);
+
+		return true;
+	};
+
+	size_t lineStart = 0;
+	while (lineStart < text.size()) {
+		size_t lineEnd = text.find('\n', lineStart);
+		if (lineEnd == std::string::npos) { lineEnd = text.size(); }
+		statement = std::string_view(text).substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		++lineNumber;
+
+		const auto comment = statement.find('#');
+		if (comment != std::string_view::npos) { statement = statement.substr(0, comment); }
+		StatementParser parser(statement);
+		const auto keyword = parser.NextToken();
+		if (keyword.empty()) { continue; }
+
+		bool valid = true;
+		if (keyword == "sphere") {
+			PackedSphere& sphere = outScene.Spheres.emplace_back();
+			uint32_t material    = 0;
+			valid = parser.Next(sphere.Center, 3) && parser.Next(sphere.Radius);
+			if (valid && !FindMaterial(parser.NextToken(), material)) { return Fail("Unknown material"); }
+			outScene.SphereMaterials.push_back(material);
+		} else if (keyword == "name") {
+			outScene.Name = parser.Rest();
+			valid         = !outScene.Name.empty();
+		} else if (keyword == "camera") {
+			const auto property = parser.NextToken();
+			if (property == "position") {
+				valid = parser.Next(outScene.CameraPosition, 3);
+			} else if (property == "target") {
+				valid = parser.Next(outScene.CameraTarget, 3);
+			} else if (property == "fov") {
+				valid = parser.Next(outScene.VerticalFOV);
+			} else if (property == "aperture") {
+				valid = parser.Next(outScene.CameraAperture);
+			} else if (property == "focus") {
+				valid = parser.Next(outScene.CameraFocusDistance);
+			} else {
+				return Fail("Unknown camera property");
+			}
+		} else if (keyword == "sky") {
+			const auto type = parser.NextToken();
+			SkyRecord& sky  = outScene.Sky;
+			if (type == "gradient") {
+				sky.Type = SkyType::Gradient;
+				valid    = parser.Next(sky.ColorA, 3) && parser.Next(sky.ColorB, 3) && parser.Next(sky.Gradient);
+			} else if (type == "solid") {
+				sky.Type = SkyType::Solid;
+				valid    = ParseColorOrTexture(parser, sky.ColorA, sky.Texture);
+			} else {
+				return Fail("Unknown sky type");
+			}
+		} else if (keyword == "texture") {
+			const auto name = parser.NextToken();
+			const auto type = parser.NextToken();
+			if (!Define(textures, name, outScene.Textures.size())) { return Fail("Missing or duplicate texture name"); }
+			TextureRecord& texture = outScene.Textures.emplace_back();
+			if (type == "solid") {
+				texture.Type = TextureType::Solid;
+				valid        = parser.Next(texture.ColorA, 3);
+			} else if (type == "checker") {
+				texture.Type = TextureType::Checker;
+				valid        = parser.Next(texture.ColorA, 3) && parser.Next(texture.ColorB, 3) &&
+				        parser.Next(texture.Scale, 2);
+			} else if (type == "image") {
+				texture.Type = TextureType::Image;
+				const auto path = parser.Rest();
+				valid           = !path.empty();
+				texture.Path    = AddString(outScene, path);
+			} else {
+				return Fail("Unknown texture type");
+			}
+		} else if (keyword == "material") {
+			const auto name = parser.NextToken();
+			const auto type = parser.NextToken();
+			if (!Define(materials, name, outScene.Materials.size())) {
+				return Fail("Missing or duplicate material name");
+			}
+			MaterialRecord& material = outScene.Materials.emplace_back();
+			material.Texture         = NoTexture;
+			if (type == "lambertian") {
+				material.Type = MaterialType::Lambertian;
+				valid         = ParseColorOrTexture(parser, material.Color, material.Texture);
+			} else if (type == "metal") {
+				material.Type = MaterialType::Metal;
+				valid         = parser.Next(material.Color, 3) && parser.Next(material.Parameter);
+			} else if (type == "dielectric") {
+				material.Type = MaterialType::Dielectric;
+				valid         = parser.Next(material.Parameter);
+			} else if (type == "light") {
+				material.Type = MaterialType::Light;
+				valid         = ParseColorOrTexture(parser, material.Color, material.Texture);
+			} else {
+				return Fail("Unknown material type");
+			}
+		} else if (keyword == "mesh") {
+			const auto name = parser.NextToken();
+			const auto type = parser.NextToken();
+			if (!Define(meshes, name, outScene.Meshes.size())) { return Fail("Missing or duplicate mesh name"); }
+			MeshRecord& mesh = outScene.Meshes.emplace_back();
+			if (type == "file") {
+				mesh.Type       = MeshType::File;
+				const auto path = parser.Rest();
+				valid           = !path.empty();
+				mesh.Path       = AddString(outScene, path);
+			} else if (type == "torus") {
+				mesh.Type = MeshType::Torus;
+				valid     = parser.Next(mesh.MajorRadius) && parser.Next(mesh.MinorRadius) &&
+				        parser.Next(mesh.MajorSegments) && parser.Next(mesh.MinorSegments) && mesh.MajorSegments > 2 &&
+				        mesh.MinorSegments > 2;
+			} else {
+				return Fail("Unknown mesh type");
+			}
+		} else if (keyword == "plane" || keyword == "rectangle") {
+			ObjectRecord& object = outScene.Objects.emplace_back();
+			object.Type          = keyword == "plane" ? ObjectType::Plane : ObjectType::Rectangle;
+			valid                = ParseAxis(parser.NextToken(), object.Axis);
+			if (valid && object.Type == ObjectType::Rectangle) {
+				valid = parser.Next(object.Min, 2) && parser.Next(object.Max, 2);
+			}
+			valid = valid && parser.Next(object.Offset);
+			if (valid && !FindMaterial(parser.NextToken(), object.Material)) { return Fail("Unknown material"); }
+		} else if (keyword == "object" || keyword == "instance") {
+			ObjectRecord& object = outScene.Objects.emplace_back();
+			object.Type          = keyword == "object" ? ObjectType::Mesh : ObjectType::Instance;
+			if (!Find(meshes, parser.NextToken(), object.Mesh)) { return Fail("Unknown mesh"); }
+			if (!FindMaterial(parser.NextToken(), object.Material)) { return Fail("Unknown material"); }
+
+			// Transforms apply in the order they are written, the same as building the matrix with glm.
+			Matrix4 transform(1);
+			while (valid && object.Type == ObjectType::Instance && !parser.AtEnd()) {
+				const auto operation = parser.NextToken();
+				float values[4];
+				if (operation == "translate" && parser.Next(values, 3)) {
+					transform = glm::translate(transform, Vector3(values[0], values[1], values[2]));
+				} else if (operation == "rotate" && parser.Next(values, 4)) {
+					const Real angle = glm::radians(Real(values[0]));
+					transform        = glm::rotate(transform, angle, Vector3(values[1], values[2], values[3]));
+				} else if (operation == "scale" && parser.Next(values[0])) {
+					// A single factor scales uniformly.
+					StatementParser rest = parser;
+					if (rest.Next(values[1]) && rest.Next(values[2])) {
+						parser = rest;
+					} else {
+						values[1] = values[2] = values[0];
+					}
+					transform = glm::scale(transform, Vector3(values[0], values[1], values[2]));
+				} else {
+					valid = false;
+				}
+			}
+			for (int i = 0; i < 16; ++i) { object.Transform[i] = static_cast<float>(transform[i / 4][i % 4]); }
+		} else {
+			return Fail("Unknown statement");
+		}
+
+		if (!valid || !parser.AtEnd()) { return Fail("Invalid statement"); }
+	}
+
+	if (outScene.Spheres.empty() && outScene.Objects.empty()) {
+		Log::Error("SceneFile", "Scene '{}' does not contain any objects.", filename);
+		return false;
+	}
+	if (outScene.Name.empty()) { outScene.Name = std::filesystem::path(filename).stem().string(); }
+
+	return true;
+}
+
+// Sort the spheres into the leaf order of a BVH built over them, so their leaves are contiguous ranges and the cache
+// does not need primitive indices.
+void BuildSphereBVH(SceneData& scene, ITaskPool* taskPool) {
+	if (scene.Spheres.empty()) { return; }
+
+	std::vector<AABB> bounds(scene.Spheres.size());
+	for (size_t i = 0; i < bounds.size(); ++i) {
+		const PackedSphere& sphere = scene.Spheres[i];
+		const Point3 center(sphere.Center[0], sphere.Center[1], sphere.Center[2]);
+		const Vector3 extent(std::abs(sphere.Radius));
+		bounds[i] = AABB(center - extent, center + extent);
+	}
+	LinearBVH bvh;
+	bvh.Build(bounds, taskPool);
+
+	const auto& order = bvh.GetPrimitiveIndices();
+	std::vector<PackedSphere> spheres(order.size());
+	std::vector<uint32_t> sphereMaterials(order.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		spheres[i]         = scene.Spheres[order[i]];
+		sphereMaterials[i] = scene.SphereMaterials[order[i]];
+	}
+	scene.Spheres         = std::move(spheres);
+	scene.SphereMaterials = std::move(sphereMaterials);
+	scene.SphereNodes.assign(bvh.GetNodes().begin(), bvh.GetNodes().end());
+}
+
+std::vector<uint8_t> WriteCache(const SceneData& scene, uint64_t sourceSize, int64_t sourceTime) {
+	CacheHeader header = {};
+	std::memcpy(header.Magic, Magic, sizeof(Magic));
+	header.Version             = Version;
+	header.RealSize            = sizeof(Real);
+	header.SourceSize          = sourceSize;
+	header.SourceTime          = sourceTime;
+	header.VerticalFOV         = scene.VerticalFOV;
+	header.CameraAperture      = scene.CameraAperture;
+	header.CameraFocusDistance = scene.CameraFocusDistance;
+	header.Sky                 = scene.Sky;
+	std::memcpy(header.CameraPosition, scene.CameraPosition, sizeof(header.CameraPosition));
+	std::memcpy(header.CameraTarget, scene.CameraTarget, sizeof(header.CameraTarget));
+
+	// The name goes at the end of the strings, so the offsets the records already have stay the same.
+	std::string strings = scene.Strings;
+	header.Name         = static_cast<uint32_t>(strings.size());
+	strings.append(scene.Name);
+	strings.push_back('\0');
+
+	std::vector<uint8_t> blob(AlignSection(sizeof(CacheHeader)));
+	const auto AddSection = [&blob](Section& section, const void* data, size_t count, size_t elementSize) {
+		section.Offset = blob.size();
+		section.Count  = count;
+		blob.resize(AlignSection(blob.size() + count * elementSize));
+		if (count > 0) { std::memcpy(blob.data() + section.Offset, data, count * elementSize); }
+	};
+	const auto AddVector = [&AddSection](Section& section, const auto& vector) {
+		AddSection(section, vector.data(), vector.size(), sizeof(vector[0]));
+	};
+	AddSection(header.Strings, strings.data(), strings.size(), 1);
+	AddVector(header.Textures, scene.Textures);
+	AddVector(header.Materials, scene.Materials);
+	AddVector(header.Meshes, scene.Meshes);
+	AddVector(header.Objects, scene.Objects);
+	AddVector(header.Spheres, scene.Spheres);
+	AddVector(header.SphereMaterials, scene.SphereMaterials);
+	AddVector(header.SphereNodes, scene.SphereNodes);
+	std::memcpy(blob.data(), &header, sizeof(header));
+
+	return blob;
+}
+
+// Checks that the nodes form a single tree, stored depth-first with every left child right after its parent the way
+// LinearBVH builds them, that it is no deeper than traversal can handle, and that its leaves only refer to spheres that
+// exist. Nodes are visited in the order they are stored, so each of them is read exactly once.
+bool IsSphereBVHValid(std::span<const LinearBVHNode> nodes, uint64_t sphereCount) {
+	std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 0}};  // Node index and depth.
+	uint64_t next                                    = 0;
+	while (!stack.empty()) {
+		const auto [index, depth] = stack.back();
+		stack.pop_back();
+		if (index != next++ || index >= nodes.size()) { return false; }
+
+		const auto& node = nodes[index];
+		if (node.IsLeaf()) {
+			if (uint64_t(node.Offset) + node.Count > sphereCount) { return false; }
+		} else {
+			if (depth >= LinearBVH::MaxDepth || node.Axis > 2 || node.Offset <= index + 1 || node.Offset >= nodes.size()) {
+				return false;
+			}
+			stack.push_back({node.Offset, depth + 1});
+			stack.push_back({index + 1, depth + 1});
+		}
+	}
+
+	return next == nodes.size();
+}
+
+// Checks that a cache was compiled from the scene file as it is now, by a build like this one, and that all of it is
+// there and only refers to things that exist.
+bool IsCacheValid(const void* data, size_t size, uint64_t sourceSize, int64_t sourceTime) {
+	if (size < sizeof(CacheHeader)) { return false; }
+
+	const CacheHeader& header = *static_cast<const CacheHeader*>(data);
+	if (std::memcmp(header.Magic, Magic, sizeof(Magic)) != 0 || header.Version != Version ||
+	    header.RealSize != sizeof(Real) || header.SourceSize != sourceSize || header.SourceTime != sourceTime) {
+		return false;
+	}
+
+	const auto SectionFits = [size](const Section& section, size_t elementSize) {
+		return section.Offset % SectionAlign == 0 && section.Offset <= size &&
+		       section.Count <= (size - section.Offset) / elementSize;
+	};
+
+	if (!SectionFits(header.Strings, 1) || !SectionFits(header.Textures, sizeof(TextureRecord)) ||
+	    !SectionFits(header.Materials, sizeof(MaterialRecord)) || !SectionFits(header.Meshes, sizeof(MeshRecord)) ||
+	    !SectionFits(header.Objects, sizeof(ObjectRecord)) || !SectionFits(header.Spheres, sizeof(PackedSphere)) ||
+	    !SectionFits(header.SphereMaterials, sizeof(uint32_t)) ||
+	    !SectionFits(header.SphereNodes, sizeof(LinearBVHNode)) ||
+	    header.SphereMaterials.Count != header.Spheres.Count ||
+	    (header.Spheres.Count > 0) != (header.SphereNodes.Count > 0)) {
+		return false;
+	}
+
+	const auto* bytes   = static_cast<const uint8_t*>(data);
+	const char* strings = GetSection<char>(bytes, header.Strings);
+	if (header.Strings.Count == 0 || strings[header.Strings.Count - 1] != '\0' || header.Name >= header.Strings.Count) {
+		return false;
+	}
+	const auto IsTexture = [&header](int32_t texture) {
+		return texture == NoTexture || (texture >= 0 && uint64_t(texture) < header.Textures.Count);
+	};
+	if (header.Sky.Type > SkyType::Solid || !IsTexture(header.Sky.Texture)) { return false; }
+	for (const auto& texture : GetSpan<TextureRecord>(bytes, header.Textures)) {
+		if (texture.Type > TextureType::Image || texture.Path >= header.Strings.Count) { return false; }
+	}
+	for (const auto& material : GetSpan<MaterialRecord>(bytes, header.Materials)) {
+		if (material.Type > MaterialType::Light || !IsTexture(material.Texture)) { return false; }
+	}
+	for (const auto& mesh : GetSpan<MeshRecord>(bytes, header.Meshes)) {
+		if (mesh.Type > MeshType::Torus || mesh.Path >= header.Strings.Count) { return false; }
+	}
+	for (const auto& object : GetSpan<ObjectRecord>(bytes, header.Objects)) {
+		if (object.Type > ObjectType::Instance || object.Axis > 2 || object.Material >= header.Materials.Count ||
+		    (object.Type >= ObjectType::Mesh && object.Mesh >= header.Meshes.Count)) {
+			return false;
+		}
+	}
+
+	// The sphere arrays are used right where they are, so a single bad index would have traces read past the end of the
+	// materials or the spheres. Checking them reads the whole cache once, which is still far cheaper than compiling it.
+	for (const uint32_t material : GetSpan<uint32_t>(bytes, header.SphereMaterials)) {
+		if (material >= header.Materials.Count) { return false; }
+	}
+	if (header.SphereNodes.Count > 0 &&
+	    !IsSphereBVHValid(GetSpan<LinearBVHNode>(bytes, header.SphereNodes), header.Spheres.Count)) {
+		return false;
+	}
+
+	return true;
+}
+
+// Turns a valid cache into a world. Everything but the spheres becomes an object of its own, while the spheres and
+// their BVH are used right where they are, and storage is held on to for as long as they are.
+std::shared_ptr<World> CreateWorld(const uint8_t* data,
+                                   const std::shared_ptr<const void>& storage,
+                                   const std::filesystem::path& directory,
+                                   ITaskPool* taskPool) {
+	const CacheHeader& header = *reinterpret_cast<const CacheHeader*>(data);
+	const char* strings       = GetSection<char>(data, header.Strings);
+	const auto GetPath        = [&](uint32_t path) { return (directory / (strings + path)).string(); };
+	const auto ToColor        = [](const float color[3]) { return Color(color[0], color[1], color[2]); };
+
+	auto world                 = std::make_shared<World>(strings + header.Name);
+	world->CameraPos           = Point3(header.CameraPosition[0], header.CameraPosition[1], header.CameraPosition[2]);
+	world->CameraTarget        = Point3(header.CameraTarget[0], header.CameraTarget[1], header.CameraTarget[2]);
+	world->VerticalFOV         = header.VerticalFOV;
+	world->CameraAperture      = header.CameraAperture;
+	world->CameraFocusDistance = header.CameraFocusDistance;
+
+	std::vector<std::shared_ptr<ITexture>> textures;
+	for (const auto& record : GetSpan<TextureRecord>(data, header.Textures)) {
+		if (record.Type == TextureType::Solid) {
+			textures.push_back(std::make_shared<SolidTexture>(ToColor(record.ColorA)));
+		} else if (record.Type == TextureType::Checker) {
+			textures.push_back(std::make_shared<CheckerTexture>(
+				ToColor(record.ColorA), ToColor(record.ColorB), glm::vec2(record.Scale[0], record.Scale[1])));
+		} else {
+			textures.push_back(std::make_shared<ImageTexture>(GetPath(record.Path)));
+		}
+	}
+	const auto GetTexture = [&](int32_t texture, const float color[3]) -> std::shared_ptr<ITexture> {
+		return texture == NoTexture ? std::make_shared<SolidTexture>(ToColor(color)) : textures[texture];
+	};
+
+	const SkyRecord& sky = header.Sky;
+	if (sky.Type == SkyType::Gradient) {
+		world->Sky = std::make_shared<GradientSkyMaterial>(ToColor(sky.ColorA), ToColor(sky.ColorB), sky.Gradient);
+	} else {
+		world->Sky = std::make_shared<SolidSkyMaterial>(GetTexture(sky.Texture, sky.ColorA));
+	}
+
+	std::vector<std::shared_ptr<IMaterial>> materials;
+	for (const auto& record : GetSpan<MaterialRecord>(data, header.Materials)) {
+		if (record.Type == MaterialType::Lambertian) {
+			materials.push_back(std::make_shared<LambertianMaterial>(GetTexture(record.Texture, record.Color)));
+		} else if (record.Type == MaterialType::Metal) {
+			materials.push_back(std::make_shared<MetalMaterial>(ToColor(record.Color), record.Parameter));
+		} else if (record.Type == MaterialType::Dielectric) {
+			materials.push_back(std::make_shared<DielectricMaterial>(record.Parameter));
+		} else {
+			materials.push_back(std::make_shared<DiffuseLightMaterial>(GetTexture(record.Texture, record.Color)));
+		}
+	}
+
+	// Meshes are only loaded once something uses them, and all instances of a mesh share a single BVH.
+	const auto* meshRecords = GetSection<MeshRecord>(data, header.Meshes);
+	std::vector<std::shared_ptr<const MeshData>> meshes(header.Meshes.Count);
+	std::vector<std::shared_ptr<TriangleMesh>> instancedMeshes(header.Meshes.Count);
+	const auto GetMesh = [&](uint32_t index) {
+		if (!meshes[index]) {
+			const MeshRecord& record = meshRecords[index];
+			if (record.Type == MeshType::File) {
+				meshes[index] = LoadMesh(GetPath(record.Path), taskPool);
+			} else {
+				meshes[index] =
+					CreateTorus(record.MajorRadius, record.MinorRadius, record.MajorSegments, record.MinorSegments);
+			}
+		}
+
+		return meshes[index];
+	};
+
+	for (const auto& record : GetSpan<ObjectRecord>(data, header.Objects)) {
+		const auto& material = materials[record.Material];
+		const Point2 min(record.Min[0], record.Min[1]);
+		const Point2 max(record.Max[0], record.Max[1]);
+		if (record.Type == ObjectType::Plane) {
+			world->AddPlane(RectanglePlane(record.Axis), record.Offset, material);
+		} else if (record.Type == ObjectType::Rectangle) {
+			world->AddRectangle(RectanglePlane(record.Axis), min, max, record.Offset, material);
+		} else {
+			const auto mesh = GetMesh(record.Mesh);
+			if (!mesh || mesh->GetTriangleCount() == 0) {
+				Log::Error("SceneFile", "Failed to load mesh '{}'!", GetPath(meshRecords[record.Mesh].Path));
+				return nullptr;
+			}
+
+			if (record.Type == ObjectType::Mesh) {
+				world->Objects.Add<TriangleMesh>(mesh, material, taskPool);
+			} else {
+				auto& instanced = instancedMeshes[record.Mesh];
+				if (!instanced) { instanced = std::make_shared<TriangleMesh>(mesh, nullptr, taskPool); }
+				Matrix4 transform;
+				for (int i = 0; i < 16; ++i) { transform[i / 4][i % 4] = record.Transform[i]; }
+				world->Objects.Add<Instance>(instanced, transform, material);
+			}
+		}
+	}
+
+	if (header.Spheres.Count > 0) {
+		world->Objects.Add<SphereSet>(GetSection<PackedSphere>(data, header.Spheres),
+		                              GetSection<uint32_t>(data, header.SphereMaterials),
+		                              header.Spheres.Count,
+		                              GetSection<LinearBVHNode>(data, header.SphereNodes),
+		                              header.SphereNodes.Count,
+		                              materials,
+		                              storage);
+	}
+
+	return world;
+}
+}  // namespace
+
+std::shared_ptr<World> LoadScene(const std::string& filename, ITaskPool* taskPool) {
+	Luna::Utility::ElapsedTime loadTime;
+	loadTime.Update();
+
+	std::error_code error;
+	const uint64_t sourceSize = std::filesystem::file_size(filename, error);
+	const auto sourceTime     = std::filesystem::last_write_time(filename, error);
+	if (error) {
+		Log::Error("SceneFile", "Failed to open scene '{}': {}", filename, error.message());
+		return nullptr;
+	}
+	const int64_t sourceTimeCount = sourceTime.time_since_epoch().count();
+	const auto directory          = std::filesystem::path(filename).parent_path();
+	const auto cachePath          = std::filesystem::path(filename).replace_extension(".scenecache").string();
+
+	auto cache = std::make_shared<MappedFile>();
+	if (std::filesystem::exists(cachePath, error) && cache->OpenRead(cachePath) &&
+	    IsCacheValid(cache->GetData(), cache->GetSize(), sourceSize, sourceTimeCount)) {
+		auto world = CreateWorld(static_cast<const uint8_t*>(cache->GetData()), cache, directory, taskPool);
+		loadTime.Update();
+		if (world) {
+			Log::Info("SceneFile",
+			          "Loaded scene '{}' from its cache in {}ms.",
+			          world->Name,
+			          loadTime.Get().AsMilliseconds<float>());
+		}
+
+		return world;
+	}
+	cache->Close();
+
+	SceneData scene;
+	if (!ParseScene(filename, scene)) { return nullptr; }
+	BuildSphereBVH(scene, taskPool);
+	const auto blob = WriteCache(scene, sourceSize, sourceTimeCount);
+
+	// The cache is written under another name first, so one that was cut short never looks like a valid cache.
+	const std::string tempPath = cachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+		if (!file) { error = std::make_error_code(std::errc::io_error); }
+	}
+	if (!error) { std::filesystem::rename(tempPath, cachePath, error); }
+
+	// The BVH nodes need their alignment, which the blob's own allocation does not promise.
+	std::shared_ptr<const void> storage;
+	if (!error && cache->OpenRead(cachePath)) {
+		storage = cache;
+	} else {
+		Log::Warning(
+			"SceneFile", "Failed to write scene cache '{}', the scene is compiled again every time.", cachePath);
+		std::filesystem::remove(tempPath, error);
+		std::shared_ptr<void> memory(::operator new(blob.size(), std::align_val_t(SectionAlign)),
+		                             [](void* memory) { ::operator delete(memory, std::align_val_t(SectionAlign)); });
+		std::memcpy(memory.get(), blob.data(), blob.size());
+		storage = memory;
+	}
+	const uint8_t* data = storage == cache ? static_cast<const uint8_t*>(cache->GetData())
+	                                       : static_cast<const uint8_t*>(storage.get());
+
+	auto world = CreateWorld(data, storage, directory, taskPool);
+	loadTime.Update();
+	if (world) {
+		Log::Info("SceneFile",
+		          "Compiled scene '{}' with {} spheres and {} other objects in {}ms.",
+		          world->Name,
+		          scene.Spheres.size(),
+		          scene.Objects.size(),
+		          loadTime.Get().AsMilliseconds<float>());
+	}
+
+	return world;
+}
+
+std::vector<std::string> FindScenes(const std::string& directory) {
+	std::vector<std::string> scenes;
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".scene") {
+			scenes.push_back(entry.path().string());
+		}
+	}
+	std::sort(scenes.begin(), scenes.end());
+
+	return scenes;
+}
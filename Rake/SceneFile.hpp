@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class ITaskPool;
+class World;
+
+// Scene files describe a world as text, one statement per line: the camera, the sky, named textures, materials and
+// meshes, and the primitives that use them. Assets/Scenes/Showcase.scene uses every statement there is. Paths to
+// images and meshes are relative to the scene file.
+//
+// Parsing text gets slow for big scenes, so the first load compiles the scene into a binary cache next to it, and
+// later loads map the cache into memory and use it in place. The cache is one flat blob that only refers to itself
+// through offsets. Spheres, usually the bulk of a big scene, are stored in it as flat arrays sorted into the leaf order
+// of a prebuilt BVH, which is stored along with them, and are traced straight out of the mapping. The cache is compiled
+// again whenever the scene file changes.
+
+// Where the editor and the headless renderer look for scene files.
+inline constexpr const char* SceneDirectory = "Assets/Scenes";
+
+// Loads a scene file, through its cache if that is up to date. Returns nullptr and logs the reason if the scene could
+// not be loaded. The task pool, if any, builds the BVHs of a new cache and of meshes.
+std::shared_ptr<World> LoadScene(const std::string& filename, ITaskPool* taskPool = nullptr);
+
+// The scene files in a directory, sorted by name.
+std::vector<std::string> FindScenes(const std::string& directory);
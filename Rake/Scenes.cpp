@@ -0,0 +1,205 @@
+#include "Scenes.hpp"
+
+#include <Luna/Utility/Hash.hpp>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "CheckerTexture.hpp"
+#include "ImageTexture.hpp"
+#include "Instance.hpp"
+#include "Materials/DielectricMaterial.hpp"
+#include "Materials/DiffuseLightMaterial.hpp"
+#include "Materials/GradientSkyMaterial.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "Materials/MetalMaterial.hpp"
+#include "Materials/SolidSkyMaterial.hpp"
+#include "Random.hpp"
+#include "TriangleMesh.hpp"
+#include "World.hpp"
+
+std::shared_ptr<MeshData> CreateTorus(Real majorRadius, Real minorRadius, uint32_t majorSegments, uint32_t minorSegments) {
+	auto mesh = std::make_shared<MeshData>();
+	for (uint32_t i = 0; i <= majorSegments; ++i) {
+		const Real u     = Real(i) / majorSegments;
+		const Real theta = 2 * Pi * u;
+		for (uint32_t j = 0; j <= minorSegments; ++j) {
+			const Real v   = Real(j) / minorSegments;
+			const Real phi = 2 * Pi * v;
+			const Vector3 normal(std::cos(theta) * std::cos(phi), std::sin(phi), std::sin(theta) * std::cos(phi));
+			const Point3 position = Point3(std::cos(theta), 0, std::sin(theta)) * majorRadius + normal * minorRadius;
+			for (int axis = 0; axis < 3; ++axis) {
+				mesh->Positions[axis].push_back(static_cast<float>(position[axis]));
+				mesh->Normals[axis].push_back(static_cast<float>(normal[axis]));
+			}
+			mesh->UVs[0].push_back(static_cast<float>(u));
+			mesh->UVs[1].push_back(static_cast<float>(v));
+		}
+	}
+
+	const uint32_t stride = minorSegments + 1;
+	for (uint32_t i = 0; i < majorSegments; ++i) {
+		for (uint32_t j = 0; j < minorSegments; ++j) {
+			const uint32_t a = i * stride + j;
+			const uint32_t b = a + stride;
+			for (const uint32_t index : {a, a + 1, b, b, a + 1, b + 1}) { mesh->PositionIndices.push_back(index); }
+		}
+	}
+	mesh->NormalIndices = mesh->PositionIndices;
+	mesh->UVIndices     = mesh->PositionIndices;
+
+	return mesh;
+}
+
+namespace {
+void PopulateWorld(World& world) {
+	world.Sky                 = std::make_shared<GradientSkyMaterial>(Color(1.0), Color(0.5, 0.7, 1.0), 0.5);
+	world.CameraPos           = Point3(0.0, 0.0, 0.0);
+	world.CameraTarget        = Point3(0.0, 0.0, -1.0);
+	world.CameraFocusDistance = 1.0;
+	world.VerticalFOV         = 100;
+	auto ground               = std::make_shared<LambertianMaterial>(Color(0.3, 0.3, 0.8));
+	auto center               = std::make_shared<LambertianMaterial>(Color(0.3, 0.8, 0.3));
+	auto left                 = std::make_shared<DielectricMaterial>(1.5);
+	auto right                = std::make_shared<MetalMaterial>(Color(0.8, 0.6, 0.2), 1.0);
+	world.AddSphere(Point3(0, -100.5, -1), 100, ground);
+	world.AddSphere(Point3(0, 0, -1), 0.5, center);
+	world.AddSphere(Point3(-1, 0, -1), 0.5, left);
+	world.AddSphere(Point3(-1, 0, -1), -0.45, left);
+	world.AddSphere(Point3(1, 0, -1), 0.5, right);
+}
+
+void PopulateOneWeekend(World& world) {
+	// world.Sky          = std::make_shared<GradientSkyMaterial>(Color(1.0) * 0.2f, Color(0.5, 0.7, 1.0) * 0.2f, 0.5);
+	world.Sky = std::make_shared<SolidSkyMaterial>(std::make_shared<ImageTexture>("Assets/Textures/TokyoBigSight.hdr"));
+	world.CameraPos           = Point3(13.0, 2.0, 5.0);
+	world.CameraTarget        = Point3(0.0, 0.0, 0.0);
+	world.CameraFocusDistance = 12.0;
+	world.CameraAperture      = 0.1;
+	world.VerticalFOV         = 20;
+
+	auto sun          = std::make_shared<DiffuseLightMaterial>(Color(0.5, 0.9, 0.9) * 30.0f);
+	auto checker      = std::make_shared<CheckerTexture>(Color(0.2), Color(0.36, 0.0, 0.63), glm::vec2(Pi));
+	auto earth        = std::make_shared<ImageTexture>("Assets/Textures/Earth.jpg");
+	auto ground       = std::make_shared<LambertianMaterial>(checker);
+	auto center       = std::make_shared<DielectricMaterial>(1.5);
+	auto left         = std::make_shared<LambertianMaterial>(earth);
+	auto right        = std::make_shared<MetalMaterial>(Color(0.7, 0.6, 0.5), 0.0);
+	const auto sunPos = RandomInHemisphere(Vector3(0, 1, 0)) * Real(250);
+	world.AddSphere(sunPos, 50, sun);
+	world.AddPlane(RectanglePlane::XZ, 0.0, ground);
+	world.AddSphere(Point3(0, 1, 0), 1, center);
+	world.AddSphere(Point3(-4, 1, 0), 1, left);
+	world.AddSphere(Point3(4, 1, 0), 1, right);
+
+	for (int x = -11; x < 11; x++) {
+		for (int y = -11; y < 11; y++) {
+			const auto randomMat = RandomDouble();
+			const Point3 center(x + 0.9 * RandomDouble(), 0.2, y + 0.9 * RandomDouble());
+
+			if (glm::length(center - Point3(4, 0.2, 0)) > 0.9) {
+				std::shared_ptr<IMaterial> material;
+				if (randomMat < 0.3) {
+					const auto albedo = RandomColor() * RandomColor();
+					material          = std::make_shared<LambertianMaterial>(albedo);
+				} else if (randomMat < 0.7) {
+					const auto albedoA = RandomColor() * RandomColor();
+					const auto albedoB = RandomColor() * RandomColor();
+					material           = std::make_shared<LambertianMaterial>(
+              std::make_shared<CheckerTexture>(albedoA, albedoB, glm::vec2(30.0f, 15.0f)));
+				} else if (randomMat < 0.8) {
+					const auto albedo = RandomColor() * RandomColor();
+					material          = std::make_shared<DiffuseLightMaterial>(albedo * 5.0f);
+				} else if (randomMat < 0.95) {
+					const auto albedo    = RandomColor(0.5, 1.0);
+					const auto roughness = RandomDouble(0.0, 0.5);
+					material             = std::make_shared<MetalMaterial>(albedo, roughness);
+				} else {
+					material = std::make_shared<DielectricMaterial>(1.5);
+				}
+
+				world.AddSphere(center, 0.2, material);
+			}
+		}
+	}
+}
+
+void PopulateTriangleMeshes(World& world) {
+	world.Sky                 = std::make_shared<GradientSkyMaterial>(Color(1.0), Color(0.5, 0.7, 1.0), 0.5);
+	world.CameraPos           = Point3(0.0, 3.0, 6.0);
+	world.CameraTarget        = Point3(0.0, 0.5, 0.0);
+	world.CameraFocusDistance = 6.5;
+	world.VerticalFOV         = 40;
+
+	auto checker = std::make_shared<CheckerTexture>(Color(0.2), Color(0.9), glm::vec2(Pi));
+	auto ground  = std::make_shared<LambertianMaterial>(checker);
+	auto gold    = std::make_shared<MetalMaterial>(Color(0.9, 0.7, 0.3), 0.2);
+	auto glass   = std::make_shared<DielectricMaterial>(1.5);
+	auto stripes = std::make_shared<LambertianMaterial>(
+		std::make_shared<CheckerTexture>(Color(0.8, 0.2, 0.2), Color(0.9), glm::vec2(Pi * 24, Pi * 8)));
+	const auto torus = CreateTorus(1.0, 0.35, 96, 48);
+	world.AddPlane(RectanglePlane::XZ, 0.0, ground);
+	world.Objects.Add<TriangleMesh>(torus, stripes);
+	world.AddSphere(Point3(-2.2, 0.6, 0.5), 0.6, gold);
+	world.AddSphere(Point3(2.2, 0.6, 0.5), 0.6, glass);
+}
+
+void PopulateInstances(World& world) {
+	world.Sky                 = std::make_shared<GradientSkyMaterial>(Color(1.0), Color(0.5, 0.7, 1.0), 0.5);
+	world.CameraPos           = Point3(0.0, 14.0, 30.0);
+	world.CameraTarget        = Point3(0.0, 0.0, 0.0);
+	world.CameraFocusDistance = 33.0;
+	world.VerticalFOV         = 40;
+
+	std::vector<std::shared_ptr<IMaterial>> materials;
+	for (int i = 0; i < 8; ++i) {
+		materials.push_back(std::make_shared<LambertianMaterial>(RandomColor(0.2, 0.9)));
+		materials.push_back(std::make_shared<MetalMaterial>(RandomColor(0.5, 1.0), RandomDouble(0.0, 0.3)));
+	}
+
+	// Ten thousand tori that all share the same mesh and its BVH.
+	const auto torus = std::make_shared<TriangleMesh>(CreateTorus(1.0, 0.35, 96, 48), materials.front());
+	world.AddPlane(RectanglePlane::XZ, 0.0, std::make_shared<LambertianMaterial>(Color(0.5)));
+	for (int x = -50; x < 50; ++x) {
+		for (int z = -50; z < 50; ++z) {
+			Matrix4 transform(1);
+			transform = glm::translate(transform, Vector3(x + 0.5, 0.35, z + 0.5));
+			transform = glm::rotate(transform, Real(RandomDouble(0.0, 2.0 * Pi)), RandomUnitVector());
+			transform = glm::scale(transform, Vector3(0.3));
+			world.Objects.Add<Instance>(torus, transform, materials[RandomInt(0, int(materials.size()) - 1)]);
+		}
+	}
+}
+}  // namespace
+
+const std::vector<WorldFactory>& GetWorldFactories() {
+	static const std::vector<WorldFactory> factories = {
+		{"World", PopulateWorld},
+		{"Raytracing In One Weekend", PopulateOneWeekend},
+		{"Triangle Meshes", PopulateTriangleMeshes},
+		{"Instances", PopulateInstances}};
+
+	return factories;
+}
+
+std::shared_ptr<World> WorldFactory::Create() const {
+	// Seed the random numbers from the name, so a world comes out the same whichever thread builds it and whatever
+	// was built before it.
+	Luna::Utility::Hasher hasher;
+	hasher.Data(std::strlen(Name), Name);
+	Sampler& sampler    = ThreadSampler();
+	const Sampler saved = sampler;
+	sampler             = Sampler(hasher.Get());
+
+	auto world = std::make_shared<World>(Name);
+	Populate(*world);
+	sampler = saved;
+
+	return world;
+}
+
+std::vector<std::shared_ptr<World>> CreateWorlds() {
+	std::vector<std::shared_ptr<World>> worlds;
+	for (const auto& factory : GetWorldFactories()) { worlds.push_back(factory.Create()); }
+
+	return worlds;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DataTypes.hpp"
+
+struct MeshData;
+class World;
+
+// One of the built-in demo worlds, which is only built when asked for.
+struct WorldFactory {
+	const char* Name;
+	void (*Populate)(World& world);
+
+	std::shared_ptr<World> Create() const;
+};
+
+// The built-in demo worlds by name, in the order the editor lists them, for the headless renderer to build just the
+// one it renders.
+const std::vector<WorldFactory>& GetWorldFactories();
+// Builds every built-in demo world, for the editor to switch between.
+std::vector<std::shared_ptr<World>> CreateWorlds();
+
+// Tessellates a torus around the Y axis, with smooth normals and UVs wrapping once around each circle.
+std::shared_ptr<MeshData> CreateTorus(Real majorRadius,
+                                      Real minorRadius,
+                                      uint32_t majorSegments,
+                                      uint32_t minorSegments);
@@ -0,0 +1,71 @@
+#include "SchedulerBenchmark.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <chrono>
+#include <thread>
+
+#include "Scenes.hpp"
+#include "Tracer.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+namespace {
+const glm::uvec2 ImageSize(800, 450);
+constexpr uint32_t SamplesPerPixel = 32;
+
+// Returns the render time in seconds, or a negative value if the trace could not start. A tile size of 0 lets the
+// tracer pick one.
+double Measure(Tracer& tracer, const std::shared_ptr<World>& world, TraceScheduler scheduler, uint32_t tileSize = 0) {
+	TraceSettings settings;
+	settings.Scheduler = scheduler;
+	settings.TileSize  = tileSize;
+	if (!tracer.StartTrace(ImageSize, SamplesPerPixel, world, settings)) { return -1.0; }
+
+	while (tracer.IsRunning()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		tracer.Update();
+	}
+
+	return tracer.GetElapsedTime().AsSeconds<double>();
+}
+
+void Report(const char* name, double seconds, uint64_t stolenTasks) {
+	Log::Info("Benchmark", "{:<14} {:>8.3f}s, {:>6} tasks stolen", name, seconds, stolenTasks);
+}
+}  // namespace
+
+int RunSchedulerBenchmark(uint32_t threadCount) {
+	Tracer tracer(threadCount);
+	const auto world = GetWorldFactories().front().Create();
+	Log::Info("Benchmark",
+	          "Rendering '{}' at {}x{} with {} samples per pixel on {} threads.",
+	          world->Name,
+	          ImageSize.x,
+	          ImageSize.y,
+	          SamplesPerPixel,
+	          tracer.GetThreadCount() - 1);
+
+	// The first trace builds the world BVH, so warm it up before timing anything.
+	if (Measure(tracer, world, TraceScheduler::WorkStealing) < 0.0) {
+		Log::Error("Benchmark", "Failed to start raytrace task!");
+		return 1;
+	}
+
+	const double sharedSeconds    = Measure(tracer, world, TraceScheduler::SharedQueue);
+	const uint64_t sharedStolen   = tracer.GetStolenTaskCount();
+	const double stealingSeconds  = Measure(tracer, world, TraceScheduler::WorkStealing);
+	const uint64_t stealingStolen = tracer.GetStolenTaskCount();
+
+	Report("Shared queue", sharedSeconds, sharedStolen);
+	Report("Work stealing", stealingSeconds, stealingStolen);
+	Log::Info("Benchmark", "Work stealing renders {:.2f}x as fast.", sharedSeconds / stealingSeconds);
+
+	// The tile sizes StartTrace picks from, to check its choice above against.
+	for (const uint32_t tileSize : {8u, 16u, 32u, 64u}) {
+		const double seconds = Measure(tracer, world, TraceScheduler::WorkStealing, tileSize);
+		Report(fmt::format("{0}x{0} tiles", tileSize).c_str(), seconds, tracer.GetStolenTaskCount());
+	}
+
+	return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+
+// Renders the same scene once with the shared queue of bands and once with the work-stealing tile scheduler, then with
+// work stealing and every fixed tile size the tracer picks from, and logs the render time and number of stolen tasks
+// of each. Returns the process exit code.
+int RunSchedulerBenchmark(uint32_t threadCount);
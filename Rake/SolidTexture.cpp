@@ -1,5 +1,7 @@
 #include "SolidTexture.hpp"
 
+#include <string_view>
+
 SolidTexture::SolidTexture(const Color& c) : Albedo(c) {}
 
 SolidTexture::SolidTexture(float r, float g, float b) : Albedo(Color(r, g, b)) {}
@@ -7,3 +9,8 @@ SolidTexture::SolidTexture(float r, float g, float b) : Albedo(Color(r, g, b)) {
 Color SolidTexture::Sample(const Point2& uv, const Vector3& p) const {
 	return Albedo;
 }
+
+void SolidTexture::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(std::string_view("Solid"));
+	hasher.Data(sizeof(Albedo), &Albedo);
+}
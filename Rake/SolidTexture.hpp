@@ -9,6 +9,7 @@ class SolidTexture : public ITexture {
 	SolidTexture(float r, float g, float b);
 
 	virtual Color Sample(const Point2& uv, const Vector3& p) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
 
 	Color Albedo;
 };
@@ -2,44 +2,44 @@
 
 #include "IMaterial.hpp"
 
-Sphere::Sphere(const Point3& center, double radius, const std::shared_ptr<IMaterial>& material)
+Sphere::Sphere(const Point3& center, Real radius, const std::shared_ptr<IMaterial>& material)
 		: Center(center), Radius(radius), Material(material) {}
 
 bool Sphere::Bounds(AABB& outBounds) const {
-	const double r = glm::abs(Radius);
+	const Real r = glm::abs(Radius);
 	outBounds      = AABB(Center - Vector3(r), Center + Vector3(r));
 
 	return true;
 }
 
-bool Sphere::Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const {
-	const Vector3 oc = ray.Origin - Center;
-	const auto halfB = glm::dot(oc, ray.Direction);
-	const auto c     = glm::dot(oc, oc) - Radius * Radius;
-
-	const auto discriminant = halfB * halfB - c;
-	if (discriminant < 0.0) { return false; }
-
-	const auto sqrtd = glm::sqrt(discriminant);
-	double root      = -halfB - sqrtd;
-	if (root < tMin || tMax < root) {
-		root = -halfB + sqrtd;
-		if (root < tMin || tMax < root) { return false; }
-	}
-
-	outRecord.Distance          = root;
-	outRecord.Point             = ray.At(outRecord.Distance);
-	const Vector3 outwardNormal = (outRecord.Point - Center) / Radius;
-	outRecord.SetFaceNormal(ray, outwardNormal);
+bool Sphere::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	Real t;
+	if (!IntersectSphere(ray, Center, Radius, tMin, tMax, t)) { return false; }
+	SetSphereHit(ray, Center, Radius, t, outRecord);
 	outRecord.Material = Material.get();
-	outRecord.UV       = GetUV(outwardNormal);
 
 	return true;
 }
 
-Point2 Sphere::GetUV(const Point3& p) const {
+SimdMask Sphere::IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const {
+	return IntersectSpherePacket(packet,
+	                             static_cast<float>(Center.x),
+	                             static_cast<float>(Center.y),
+	                             static_cast<float>(Center.z),
+	                             static_cast<float>(Radius * Radius),
+	                             tMin,
+	                             tMax);
+}
+
+Point2 Sphere::GetUV(const Vector3& p) {
 	const auto theta = glm::acos(-p.y);
 	const auto phi   = std::atan2(-p.z, p.x) + Pi;
 
 	return Point2(phi / (2 * Pi), theta / Pi);
 }
+
+void Sphere::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher.Data(sizeof(Center), &Center);
+	hasher(Radius);
+	HashMaterial(hasher, Material.get());
+}
@@ -7,15 +7,77 @@ class IMaterial;
 class Sphere : public IHittable {
  public:
 	Sphere() = default;
-	Sphere(const Point3& center, double radius, const std::shared_ptr<IMaterial>& material);
+	Sphere(const Point3& center, Real radius, const std::shared_ptr<IMaterial>& material);
 
 	virtual bool Bounds(AABB& outBounds) const override;
-	virtual bool Hit(const Ray& ray, double tMin, double tMax, HitRecord& outRecord) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+	virtual SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const override;
+
+	// Spherical texture coordinates of a point on the unit sphere.
+	static Point2 GetUV(const Vector3& p);
 
 	Point3 Center;
-	double Radius;
+	Real Radius;
 	std::shared_ptr<IMaterial> Material;
-
- private:
-	Point2 GetUV(const Point3& p) const;
 };
+
+// The sphere test, shared with everything that keeps its spheres in bulk instead of as Sphere objects. Leaf loops only
+// look for the distance to each sphere, and fill in the surface of the closest one once they are done.
+inline bool IntersectSphere(const Ray& ray, const Point3& center, Real radius, Real tMin, Real tMax, Real& outT) {
+	const Vector3 oc = ray.Origin - center;
+	const auto halfB = glm::dot(oc, ray.Direction);
+	const auto c     = glm::dot(oc, oc) - radius * radius;
+
+	const auto discriminant = halfB * halfB - c;
+	if (discriminant < 0.0) { return false; }
+
+	const auto sqrtd = glm::sqrt(discriminant);
+	Real root        = -halfB - sqrtd;
+	if (root < tMin || tMax < root) {
+		root = -halfB + sqrtd;
+		if (root < tMin || tMax < root) { return false; }
+	}
+	outT = root;
+
+	return true;
+}
+
+// Fills in everything about a hit at distance t except for the material.
+inline void SetSphereHit(const Ray& ray, const Point3& center, Real radius, Real t, HitRecord& outRecord) {
+	// Project the hit point back onto the sphere, which removes most of the error the quadratic picked up and keeps the
+	// offset applied to secondary rays small.
+	const Vector3 outwardNormal = glm::normalize((ray.At(t) - center) / radius);
+	outRecord.Distance          = t;
+	outRecord.Point             = center + outwardNormal * radius;
+	outRecord.SetFaceNormal(ray, outwardNormal);
+	outRecord.UV = Sphere::GetUV(outwardNormal);
+}
+
+inline SimdMask IntersectSpherePacket(const RayPacket& packet,
+                                      float centerX,
+                                      float centerY,
+                                      float centerZ,
+                                      float radiusSquared,
+                                      const SimdFloat& tMin,
+                                      SimdFloat& tMax) {
+	const SimdFloat ocX   = packet.Origin[0] - SimdFloat(centerX);
+	const SimdFloat ocY   = packet.Origin[1] - SimdFloat(centerY);
+	const SimdFloat ocZ   = packet.Origin[2] - SimdFloat(centerZ);
+	const SimdFloat halfB = ocX * packet.Direction[0] + ocY * packet.Direction[1] + ocZ * packet.Direction[2];
+	const SimdFloat c     = ocX * ocX + ocY * ocY + ocZ * ocZ - SimdFloat(radiusSquared);
+
+	const SimdFloat discriminant = halfB * halfB - c;
+	const SimdMask valid         = discriminant >= SimdFloat(0.0f);
+	if (!valid.Any()) { return valid; }
+
+	const SimdFloat sqrtd    = Sqrt(Max(discriminant, SimdFloat(0.0f)));
+	const SimdFloat nearRoot = SimdFloat(0.0f) - halfB - sqrtd;
+	const SimdFloat farRoot  = sqrtd - halfB;
+	const SimdMask nearValid = valid & (nearRoot >= tMin) & (nearRoot <= tMax);
+	const SimdMask farValid  = valid & (farRoot >= tMin) & (farRoot <= tMax);
+	const SimdMask hit       = nearValid | farValid;
+	tMax                     = Select(nearValid, nearRoot, Select(farValid, farRoot, tMax));
+
+	return hit;
+}
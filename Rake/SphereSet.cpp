@@ -0,0 +1,93 @@
+#include "SphereSet.hpp"
+
+#include <stdexcept>
+
+#include "IMaterial.hpp"
+#include "Sphere.hpp"
+
+namespace {
+Point3 GetCenter(const PackedSphere& sphere) {
+	return Point3(sphere.Center[0], sphere.Center[1], sphere.Center[2]);
+}
+}  // namespace
+
+SphereSet::SphereSet(const PackedSphere* spheres,
+                     const uint32_t* materialIndices,
+                     size_t sphereCount,
+                     const LinearBVHNode* nodes,
+                     size_t nodeCount,
+                     const std::vector<std::shared_ptr<IMaterial>>& materials,
+                     const std::shared_ptr<const void>& storage)
+		: _spheres(spheres),
+		  _materialIndices(materialIndices),
+		  _sphereCount(sphereCount),
+		  _materials(materials),
+		  _storage(storage) {
+	if (sphereCount == 0 || nodeCount == 0) {
+		throw std::runtime_error("Cannot construct a sphere set with 0 spheres!");
+	}
+	_bvh.Attach(nodes, nodeCount);
+
+	// The arrays are never written to, so they are only hashed once.
+	Luna::Utility::Hasher hasher;
+	hasher(_sphereCount);
+	hasher.Data(_sphereCount * sizeof(PackedSphere), _spheres);
+	hasher.Data(_sphereCount * sizeof(uint32_t), _materialIndices);
+	_sphereHash = hasher.Get();
+}
+
+bool SphereSet::Bounds(AABB& outBounds) const {
+	outBounds = _bvh.GetBounds();
+
+	return true;
+}
+
+bool SphereSet::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	uint32_t closestSphere = 0;
+	Real closestDistance   = tMax;
+
+	const bool hit = _bvh.Intersect(ray, tMin, tMax, [&](uint32_t first, uint32_t count, Real& closest) {
+		bool hitAnything = false;
+		for (uint32_t i = first; i < first + count; ++i) {
+			Real distance;
+			if (IntersectSphere(ray, GetCenter(_spheres[i]), _spheres[i].Radius, tMin, closest, distance)) {
+				hitAnything     = true;
+				closest         = distance;
+				closestDistance = distance;
+				closestSphere   = i;
+			}
+		}
+
+		return hitAnything;
+	});
+	if (!hit) { return false; }
+
+	// Only the closest sphere gets its surface filled in.
+	const PackedSphere& sphere = _spheres[closestSphere];
+	SetSphereHit(ray, GetCenter(sphere), sphere.Radius, closestDistance, outRecord);
+	outRecord.Material = _materials[_materialIndices[closestSphere]].get();
+	outRecord.Part     = closestSphere;
+
+	return true;
+}
+
+SimdMask SphereSet::IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const {
+	return _bvh.IntersectPacket(packet, tMin, tMax, [&](uint32_t first, uint32_t count, SimdFloat& closest) {
+		SimdMask hitAnything = SimdMask::None();
+		for (uint32_t i = first; i < first + count; ++i) {
+			const PackedSphere& sphere = _spheres[i];
+			const float radiusSquared  = sphere.Radius * sphere.Radius;
+			const SimdMask hit         = IntersectSpherePacket(
+				packet, sphere.Center[0], sphere.Center[1], sphere.Center[2], radiusSquared, tMin, closest);
+			hitAnything = hitAnything | hit;
+		}
+
+		return hitAnything;
+	});
+}
+
+void SphereSet::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(_sphereHash);
+	hasher(_materials.size());
+	for (const auto& material : _materials) { HashMaterial(hasher, material.get()); }
+}
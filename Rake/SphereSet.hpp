@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "IHittable.hpp"
+#include "LinearBVH.hpp"
+
+class IMaterial;
+
+// A sphere as stored in bulk, in single precision like the BVH nodes over it.
+struct PackedSphere {
+	float Center[3];
+	float Radius;  // A negative radius turns the normals inwards, which makes hollow glass spheres.
+};
+static_assert(sizeof(PackedSphere) == 16, "PackedSphere must stay tightly packed!");
+
+// Any number of spheres as a single hittable, kept in flat arrays with a BVH of their own. The set does not own the
+// arrays or the BVH nodes, which usually live in a memory-mapped scene cache and are used right where they are instead
+// of becoming an object per sphere. The spheres have to be stored in the leaf order of the BVH.
+class SphereSet : public IHittable {
+ public:
+	// Storage is whatever keeps the arrays alive, and is held on to for as long as the set exists.
+	SphereSet(const PackedSphere* spheres,
+	          const uint32_t* materialIndices,
+	          size_t sphereCount,
+	          const LinearBVHNode* nodes,
+	          size_t nodeCount,
+	          const std::vector<std::shared_ptr<IMaterial>>& materials,
+	          const std::shared_ptr<const void>& storage);
+
+	size_t GetSphereCount() const {
+		return _sphereCount;
+	}
+	const PackedSphere& GetSphere(size_t index) const {
+		return _spheres[index];
+	}
+	const IMaterial* GetMaterial(size_t index) const {
+		return _materials[_materialIndices[index]].get();
+	}
+
+	virtual bool Bounds(AABB& outBounds) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual SimdMask IntersectPacket(const RayPacket& packet, const SimdFloat& tMin, SimdFloat& tMax) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+
+ private:
+	const PackedSphere* _spheres;
+	const uint32_t* _materialIndices;
+	size_t _sphereCount;
+	LinearBVH _bvh;
+	std::vector<std::shared_ptr<IMaterial>> _materials;
+	std::shared_ptr<const void> _storage;
+	Luna::Utility::Hash _sphereHash = 0;  // Of the spheres and their material indices.
+};
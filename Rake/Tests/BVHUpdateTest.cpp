@@ -0,0 +1,120 @@
+#include "BVHUpdateTest.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "HittableBVH.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "TestHarness.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+namespace {
+constexpr uint32_t SphereCount = 2000;
+constexpr uint32_t RayCount    = 20000;
+constexpr Real WorldSize       = 100.0;
+
+const char* GetName(BVHUpdate update) {
+	switch (update) {
+		case BVHUpdate::None:
+			return "None";
+		case BVHUpdate::Refit:
+			return "Refit";
+		case BVHUpdate::Rebuild:
+			return "Rebuild";
+		case BVHUpdate::SwapRebuilt:
+			return "SwapRebuilt";
+	}
+
+	return "Unknown";
+}
+
+Point3 RandomPoint(std::mt19937& rng, Real size) {
+	std::uniform_real_distribution<Real> coordinate(-size, size);
+
+	return Point3(coordinate(rng), coordinate(rng), coordinate(rng));
+}
+
+// Traces the same rays through the world's BVH and through one freshly built over the world as it is now, and counts
+// the rays that hit a different primitive or at a different distance.
+uint32_t CountMismatches(const World& world, ITaskPool* taskPool) {
+	const HittableBVH fresh(world, taskPool);
+	std::mt19937 rng(7);
+	uint32_t mismatches = 0;
+	for (uint32_t i = 0; i < RayCount; ++i) {
+		const Ray ray(RandomPoint(rng, WorldSize * 2), glm::normalize(RandomPoint(rng, 1.0)));
+		HitRecord expected, actual;
+		const bool expectedHit = fresh.Hit(ray, 0.001, Infinity, expected);
+		const bool actualHit   = world.BVH->Hit(ray, 0.001, Infinity, actual);
+		if (expectedHit != actualHit ||
+		    (expectedHit && (expected.Primitive != actual.Primitive || expected.Distance != actual.Distance))) {
+			++mismatches;
+		}
+	}
+
+	return mismatches;
+}
+
+void CheckUpdate(TestContext& test, const char* step, World& world, BVHUpdate update, BVHUpdate expected) {
+	const uint32_t mismatches = CountMismatches(world, &test.GetTracer());
+	Log::Info("Test",
+	          "{:<24} {:<11} cost {:.2f}x, {} / {} rays differ from a fresh build.",
+	          step,
+	          GetName(update),
+	          world.BVH->GetCostRatio(),
+	          mismatches,
+	          RayCount);
+
+	test.Check(update == expected && mismatches == 0,
+	           "{}: Expected a {} update matching a fresh build!",
+	           step,
+	           GetName(expected));
+}
+}  // namespace
+
+void RunBVHUpdateTest(TestContext& test) {
+	Tracer& tracer = test.GetTracer();
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<Real> radius(0.2, 1.0);
+	World world("BVH Update");
+	const auto material = std::make_shared<LambertianMaterial>(Color(0.5f));
+	for (uint32_t i = 0; i < SphereCount; ++i) { world.AddSphere(RandomPoint(rng, WorldSize), radius(rng), material); }
+	world.AddRectangle(RectanglePlane::XZ, Point2(-WorldSize), Point2(WorldSize), -WorldSize, material);
+
+	CheckUpdate(test, "First update", world, world.UpdateBVH(&tracer), BVHUpdate::Rebuild);
+
+	world.CameraPos = Point3(1.0, 2.0, 3.0);
+	CheckUpdate(test, "Camera moved", world, world.UpdateBVH(&tracer), BVHUpdate::None);
+
+	// Small moves keep the tree close to what a fresh build would pick, so no rebuild is started.
+	for (uint32_t i = 0; i < SphereCount; ++i) {
+		world.Spheres.SetCenter(i, world.Spheres.GetCenter(i) + RandomPoint(rng, 0.5));
+	}
+	world.MarkMoved();
+	CheckUpdate(test, "Spheres nudged", world, world.UpdateBVH(&tracer), BVHUpdate::Refit);
+	test.Check(!world.IsRebuildPending(), "Spheres nudged: Expected no background rebuild to start!");
+
+	// Scattering the spheres all over the world leaves the refit tree far worse than a fresh one.
+	for (uint32_t i = 0; i < SphereCount; ++i) { world.Spheres.SetCenter(i, RandomPoint(rng, WorldSize)); }
+	world.MarkMoved();
+	CheckUpdate(test, "Spheres scattered", world, world.UpdateBVH(&tracer), BVHUpdate::Refit);
+	test.Check(world.IsRebuildPending(), "Spheres scattered: Expected a background rebuild to start!");
+
+	// The background build works from the bounds the spheres had when it started, so one more move while it runs
+	// checks that it gets refit once it is swapped in.
+	world.Spheres.SetCenter(0, world.Spheres.GetCenter(0) + Vector3(0.0, 1.0, 0.0));
+	world.MarkMoved();
+	BVHUpdate update = world.UpdateBVH(&tracer);
+	for (auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+	     update != BVHUpdate::SwapRebuilt && world.IsRebuildPending() && std::chrono::steady_clock::now() < timeout;
+	     update = world.UpdateBVH(&tracer)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CheckUpdate(test, "Background rebuild", world, update, BVHUpdate::SwapRebuilt);
+
+	world.AddSphere(Point3(0.0), 2.0, material);
+	CheckUpdate(test, "Sphere added", world, world.UpdateBVH(&tracer), BVHUpdate::Rebuild);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+class TestContext;
+
+// Moves, scatters and adds spheres in a world and checks that World::UpdateBVH picks the right kind of update each
+// time: nothing for an unchanged world, a refit for moved spheres, a background rebuild once refits have made the tree
+// too slow, and a full rebuild for added spheres. After every update, rays traced through the world's BVH have to hit
+// exactly what they hit in a BVH freshly built over the same spheres.
+void RunBVHUpdateTest(TestContext& test);
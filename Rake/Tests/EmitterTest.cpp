@@ -0,0 +1,120 @@
+#include "EmitterTest.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+#include "Materials/DiffuseLightMaterial.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "Materials/SolidSkyMaterial.hpp"
+#include "SphereSet.hpp"
+#include "TestHarness.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+namespace {
+constexpr uint32_t SampleCount = 4096;
+constexpr Real Tolerance       = 1e-4;
+const Color LightColor(4.0f);
+const Point3 ShadingPoint(0.0);
+
+// A light above the shading point and a plain sphere to its side, both with centers and radii that floats hold
+// exactly, so the pooled spheres and the sphere set describe the same scene.
+const PackedSphere Spheres[] = {{{0.0f, 4.0f, 0.0f}, 1.0f}, {{3.0f, 0.0f, 0.0f}, 1.0f}};
+constexpr uint32_t LightSphere = 0;
+constexpr uint32_t PlainSphere = 1;
+
+std::vector<std::shared_ptr<IMaterial>> CreateMaterials() {
+	return {std::make_shared<DiffuseLightMaterial>(LightColor), std::make_shared<LambertianMaterial>(Color(0.5f))};
+}
+
+std::shared_ptr<World> CreatePooledWorld() {
+	const auto materials = CreateMaterials();
+	auto world           = std::make_shared<World>("Pooled");
+	world->Sky           = std::make_shared<SolidSkyMaterial>(Color(0.0f));
+	for (uint32_t i = 0; i < std::size(Spheres); ++i) {
+		const PackedSphere& sphere = Spheres[i];
+		world->AddSphere(Point3(sphere.Center[0], sphere.Center[1], sphere.Center[2]), sphere.Radius, materials[i]);
+	}
+	world->ConstructBVH();
+
+	return world;
+}
+
+// The same spheres in a sphere set, with the materials in the same order.
+std::shared_ptr<World> CreateSetWorld() {
+	auto world = std::make_shared<World>("Set");
+	world->Sky = std::make_shared<SolidSkyMaterial>(Color(0.0f));
+	world->Objects.Add(
+		CreateSphereSet({std::begin(Spheres), std::end(Spheres)}, {LightSphere, PlainSphere}, CreateMaterials()));
+	world->ConstructBVH();
+
+	return world;
+}
+
+bool Near(Real value, Real expected) {
+	return std::abs(value - expected) <= std::abs(expected) * Tolerance;
+}
+
+// Draws the light samples of a world, checking each against a trace along its direction. Returns the densities.
+bool SampleLights(TestContext& test, const World& world, std::vector<Real>& outPdfs) {
+	const size_t emitters = world.Emitters.Size();
+	if (!test.Check(emitters == 1, "{}: Expected 1 emitter, found {}!", world.Name, emitters)) { return false; }
+
+	uint32_t failures = 0;
+	for (uint32_t i = 0; i < SampleCount; ++i) {
+		// A fixed lattice, so both worlds get the same samples.
+		const double u[4] = {
+			(i + 0.5) / SampleCount, std::fmod(i * 0.6180339887, 1.0), std::fmod(i * 0.7548776662, 1.0), 0.5};
+		LightSample sample;
+		if (!world.Emitters.Sample(ShadingPoint, u, sample)) {
+			++failures;
+			continue;
+		}
+
+		HitRecord hit;
+		if (!world.BVH->Hit(Ray(ShadingPoint, sample.Direction), Tolerance, Infinity, hit) ||
+		    !Near(hit.Distance, sample.Distance) || !Near(world.Emitters.Pdf(ShadingPoint, hit), sample.Pdf) ||
+		    sample.Radiance != LightColor) {
+			++failures;
+		}
+		outPdfs.push_back(sample.Pdf);
+	}
+
+	return test.Check(failures == 0, "{}: {} of {} light samples failed!", world.Name, failures, SampleCount);
+}
+}  // namespace
+
+void RunEmitterTest(TestContext& test) {
+	const auto pooled = CreatePooledWorld();
+	const auto set    = CreateSetWorld();
+
+	std::vector<Real> pooledPdfs, setPdfs;
+	const bool pooledSampled = SampleLights(test, *pooled, pooledPdfs);
+	const bool setSampled    = SampleLights(test, *set, setPdfs);
+	if (pooledSampled && setSampled) {
+		uint32_t mismatches = 0;
+		for (size_t i = 0; i < pooledPdfs.size(); ++i) {
+			if (!Near(setPdfs[i], pooledPdfs[i])) { ++mismatches; }
+		}
+		test.Check(mismatches == 0, "{} of {} light samples differ between the two worlds!", mismatches, SampleCount);
+	}
+
+	// Directly at the plain sphere of the set, which shares the object with the light but must not count as one.
+	HitRecord hit;
+	const PackedSphere& plain = Spheres[PlainSphere];
+	const Ray toPlain(ShadingPoint, Vector3(1.0, 0.0, 0.0));
+	const bool plainHit = set->BVH->Hit(toPlain, Tolerance, Infinity, hit) &&
+	                      Near(hit.Distance, plain.Center[0] - plain.Radius) &&
+	                      set->Emitters.Pdf(ShadingPoint, hit) == 0.0;
+	test.Check(plainHit, "A hit on the plain sphere of the set was taken for a light!");
+
+	const PackedSphere& light = Spheres[LightSphere];
+	Log::Info("Test",
+	          "Sampled a light of radius {} at distance {} {} times in either world.",
+	          light.Radius,
+	          light.Center[1],
+	          SampleCount);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+class TestContext;
+
+// Builds the same scene with a light twice, once from pooled spheres and once from a sphere set as scene files make
+// them, and checks that the emitter list finds the light in both: every light sample has to reach the light along its
+// direction, with the density Pdf gives for that hit, and both worlds have to agree on it. A hit on a sphere of the
+// set that is not a light must have no density.
+void RunEmitterTest(TestContext& test);
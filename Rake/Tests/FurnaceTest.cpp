@@ -0,0 +1,144 @@
+#include "FurnaceTest.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <vector>
+
+#include "Camera.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "Materials/SolidSkyMaterial.hpp"
+#include "TestHarness.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+namespace {
+const glm::uvec2 ImageSize(64, 64);
+constexpr uint32_t SamplesPerPixel = 16;
+const Color SkyColor(1.0f, 0.75f, 0.5f);
+constexpr float Albedo = 0.5f;
+const Point3 SphereCenter(0.0);
+constexpr Real SphereRadius = 1.0;
+
+// Sky pixels see nothing but the sky on every sample, so they only differ from it by rounding. Sphere pixels are
+// estimates, but cosine-weighted scattering under a uniform sky has no variance either, so they should not stray far.
+constexpr float SkyTolerance    = 1e-4f;
+constexpr float SphereTolerance = 1e-2f;
+
+enum class PixelClass { Sky, Sphere, Edge };
+
+std::shared_ptr<World> CreateFurnaceWorld() {
+	auto world                 = std::make_shared<World>("Furnace");
+	world->Sky                 = std::make_shared<SolidSkyMaterial>(SkyColor);
+	world->CameraPos           = Point3(0.0, 0.0, 5.0);
+	world->CameraTarget        = SphereCenter;
+	world->CameraAperture      = 0.0;
+	world->CameraFocusDistance = 5.0;
+	world->VerticalFOV         = 30.0;
+	world->AddSphere(SphereCenter, SphereRadius, std::make_shared<LambertianMaterial>(Color(Albedo)));
+
+	return world;
+}
+
+// Sorts pixels by what their camera rays see. Pixels whose footprint may cross the silhouette are left out, the margin
+// is several times the size of a pixel.
+std::vector<PixelClass> ClassifyPixels(const World& world) {
+	const Camera camera(world.CameraPos,
+	                    world.CameraTarget,
+	                    world.VerticalFOV,
+	                    Real(ImageSize.x) / Real(ImageSize.y),
+	                    world.CameraAperture,
+	                    world.CameraFocusDistance);
+
+	std::vector<PixelClass> classes;
+	for (uint32_t y = 0; y < ImageSize.y; ++y) {
+		for (uint32_t x = 0; x < ImageSize.x; ++x) {
+			const Ray ray = camera.GetRay((Real(x) + Real(0.5)) / (ImageSize.x - 1),
+			                              Real(1) - (Real(y) + Real(0.5)) / (ImageSize.y - 1));
+			const Real distance = glm::length(glm::cross(glm::normalize(ray.Direction), SphereCenter - ray.Origin));
+			if (distance < SphereRadius * Real(0.9)) {
+				classes.push_back(PixelClass::Sphere);
+			} else if (distance > SphereRadius * Real(1.1)) {
+				classes.push_back(PixelClass::Sky);
+			} else {
+				classes.push_back(PixelClass::Edge);
+			}
+		}
+	}
+
+	return classes;
+}
+
+bool Matches(const Color& value, const Color& expected, float tolerance) {
+	const Color error = glm::abs(value - expected);
+
+	return error.r <= expected.r * tolerance && error.g <= expected.g * tolerance && error.b <= expected.b * tolerance;
+}
+
+void Run(TestContext& test,
+         const std::shared_ptr<World>& world,
+         const std::vector<PixelClass>& classes,
+         const char* name,
+         const TraceSettings& settings) {
+	std::vector<Color> pixels;
+	if (!test.Render(ImageSize, SamplesPerPixel, world, settings, pixels)) { return; }
+
+	const Color sphereColor = SkyColor * Albedo;
+	uint32_t skyPixels      = 0;
+	uint32_t skyFailures    = 0;
+	uint32_t spherePixels   = 0;
+	uint32_t sphereFailures = 0;
+	Color sphereSum(0.0f);
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		if (classes[i] == PixelClass::Sky) {
+			++skyPixels;
+			if (!Matches(pixels[i], SkyColor, SkyTolerance)) { ++skyFailures; }
+		} else if (classes[i] == PixelClass::Sphere) {
+			++spherePixels;
+			sphereSum += pixels[i];
+			if (!Matches(pixels[i], sphereColor, SphereTolerance)) { ++sphereFailures; }
+		}
+	}
+	const Color sphereMean = spherePixels > 0 ? sphereSum / float(spherePixels) : Color(0.0f);
+
+	Log::Info("Test",
+	          "{:<10} sky {} / {} pixels off, sphere {} / {} pixels off, sphere mean ({:.4f}, {:.4f}, {:.4f}).",
+	          name,
+	          skyFailures,
+	          skyPixels,
+	          sphereFailures,
+	          spherePixels,
+	          sphereMean.r,
+	          sphereMean.g,
+	          sphereMean.b);
+
+	test.Check(skyPixels > 0 && spherePixels > 0 && skyFailures == 0 && sphereFailures == 0 &&
+	             Matches(sphereMean, sphereColor, SphereTolerance),
+	           "{}: Render does not match the analytic image!",
+	           name);
+}
+}  // namespace
+
+void RunFurnaceTest(TestContext& test) {
+	const auto world        = CreateFurnaceWorld();
+	const auto classes      = ClassifyPixels(*world);
+	const Color sphereColor = SkyColor * Albedo;
+	Log::Info("Test",
+	          "Furnace: albedo {} sphere under a ({}, {}, {}) sky, sphere pixels should be ({}, {}, {}).",
+	          Albedo,
+	          SkyColor.r,
+	          SkyColor.g,
+	          SkyColor.b,
+	          sphereColor.r,
+	          sphereColor.g,
+	          sphereColor.b);
+
+	TraceSettings recursive;
+	TraceSettings packets;
+	packets.PacketTracing = true;
+	TraceSettings wavefront;
+	wavefront.Integrator = TraceIntegrator::Wavefront;
+
+	Run(test, world, classes, "Recursive", recursive);
+	Run(test, world, classes, "Packets", packets);
+	Run(test, world, classes, "Wavefront", wavefront);
+}
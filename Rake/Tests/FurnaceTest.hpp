@@ -0,0 +1,8 @@
+#pragma once
+
+class TestContext;
+
+// Renders a Lambertian sphere under a uniform sky with each integrator, and checks the result against the analytic
+// image: rays that escape see the sky, and as a convex sphere never sees itself, every point on it reflects exactly its
+// albedo times the sky.
+void RunFurnaceTest(TestContext& test);
@@ -0,0 +1,171 @@
+#include "ImageWriterTest.hpp"
+
+#include <stb_image.h>
+
+// Decompress with stb_image's inflate, which the stb target already builds, instead of tinyexr's own copy of miniz.
+#define TINYEXR_USE_MINIZ    0
+#define TINYEXR_USE_STB_ZLIB 1
+#define TINYEXR_IMPLEMENTATION
+#include <tinyexr.h>
+
+#include <Luna/Utility/Log.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <glm/gtc/packing.hpp>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "ITaskPool.hpp"
+#include "ImageWriter.hpp"
+#include "TestHarness.hpp"
+
+using Luna::Log;
+
+namespace {
+// A single pixel, single rows and columns, and sizes that do not fit the 16-line EXR blocks evenly.
+const glm::uvec2 TestSizes[] = {{1, 1}, {1, 45}, {45, 1}, {67, 83}, {300, 517}};
+
+// The left half is a smooth gradient, which compresses well, and the right half is noise, which does not. Values go
+// below 0 and above 1, so PNGs have to clamp them and EXRs have to keep them.
+Color TestPixel(uint32_t x, uint32_t y, const glm::uvec2& size) {
+	if (x < size.x / 2) {
+		return Color(float(x) / float(size.x) * 4.0f - 1.0f, float(y) / float(size.y) * 2.0f, 0.5f);
+	}
+
+	uint32_t hash = (x * 73856093u) ^ (y * 19349663u);
+	hash          = (hash ^ (hash >> 15)) * 2654435761u;
+	hash ^= hash >> 13;
+
+	return Color(float(hash & 0xff) / 64.0f - 1.0f, float((hash >> 8) & 0xff) / 255.0f, float(hash >> 16) * 0.01f);
+}
+
+bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& outData) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) { return false; }
+	outData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+	return true;
+}
+
+bool CheckPNG(const std::filesystem::path& path, const glm::uvec2& size, const std::vector<Color>& pixels) {
+	int width = 0, height = 0, components = 0;
+	stbi_uc* decoded = stbi_load(path.string().c_str(), &width, &height, &components, 3);
+	if (!decoded) {
+		Log::Error("Test", "{}: stb_image failed to decode it: {}", path.string(), stbi_failure_reason());
+		return false;
+	}
+
+	size_t mismatches = 0;
+	if (uint32_t(width) == size.x && uint32_t(height) == size.y) {
+		for (size_t i = 0; i < pixels.size(); ++i) {
+			for (int channel = 0; channel < 3; ++channel) {
+				const auto expected = static_cast<uint8_t>(glm::clamp(pixels[i][channel], 0.0f, 1.0f) * 255.999f);
+				if (decoded[i * 3 + channel] != expected) { ++mismatches; }
+			}
+		}
+	}
+	stbi_image_free(decoded);
+
+	if (uint32_t(width) != size.x || uint32_t(height) != size.y || mismatches > 0) {
+		Log::Error("Test",
+		           "{}: Decoded as {}x{} with {} mismatched values.",
+		           path.string(),
+		           width,
+		           height,
+		           mismatches);
+		return false;
+	}
+
+	return true;
+}
+
+bool CheckEXR(const std::filesystem::path& path, const glm::uvec2& size, const std::vector<Color>& pixels) {
+	std::vector<uint8_t> file;
+	if (!ReadFile(path, file)) {
+		Log::Error("Test", "{}: Failed to read it back.", path.string());
+		return false;
+	}
+
+	// The header is read on its own first, as tinyexr would just as happily decode a file that is not compressed.
+	EXRVersion version;
+	EXRHeader header;
+	InitEXRHeader(&header);
+	const char* error = nullptr;
+	if (ParseEXRVersionFromMemory(&version, file.data(), file.size()) != TINYEXR_SUCCESS ||
+	    ParseEXRHeaderFromMemory(&header, &version, file.data(), file.size(), &error) != TINYEXR_SUCCESS) {
+		Log::Error("Test", "{}: tinyexr failed to read the header: {}", path.string(), error ? error : "not an EXR");
+		if (error) { FreeEXRErrorMessage(error); }
+		return false;
+	}
+	const int compression = header.compression_type;
+	FreeEXRHeader(&header);
+	if (compression != TINYEXR_COMPRESSIONTYPE_ZIP) {
+		Log::Error("Test", "{}: Not ZIP compressed.", path.string());
+		return false;
+	}
+
+	float* rgba = nullptr;
+	int width = 0, height = 0;
+	if (LoadEXRFromMemory(&rgba, &width, &height, file.data(), file.size(), &error) != TINYEXR_SUCCESS) {
+		Log::Error("Test", "{}: tinyexr failed to decode it: {}", path.string(), error ? error : "unknown error");
+		if (error) { FreeEXRErrorMessage(error); }
+		return false;
+	}
+
+	// Every value has to come back exactly as the half it was rounded to.
+	size_t mismatches = 0;
+	if (uint32_t(width) == size.x && uint32_t(height) == size.y) {
+		for (size_t i = 0; i < pixels.size(); ++i) {
+			for (int channel = 0; channel < 3; ++channel) {
+				const float expected = glm::unpackHalf1x16(glm::packHalf1x16(pixels[i][channel]));
+				if (rgba[i * 4 + channel] != expected) { ++mismatches; }
+			}
+		}
+	}
+	std::free(rgba);
+
+	if (uint32_t(width) != size.x || uint32_t(height) != size.y || mismatches > 0) {
+		Log::Error("Test",
+		           "{}: Decoded as {}x{} with {} mismatched values.",
+		           path.string(),
+		           width,
+		           height,
+		           mismatches);
+		return false;
+	}
+
+	return true;
+}
+}  // namespace
+
+void RunImageWriterTest(TestContext& test) {
+	const auto directory = std::filesystem::temp_directory_path();
+	const auto pngPath   = directory / "RakeImageWriterTest.png";
+	const auto exrPath   = directory / "RakeImageWriterTest.exr";
+
+	for (const auto& size : TestSizes) {
+		std::vector<Color> pixels;
+		for (uint32_t y = 0; y < size.y; ++y) {
+			for (uint32_t x = 0; x < size.x; ++x) { pixels.push_back(TestPixel(x, y, size)); }
+		}
+
+		for (ITaskPool* taskPool : {static_cast<ITaskPool*>(nullptr), static_cast<ITaskPool*>(&test.GetTracer())}) {
+			const bool png = WritePNG(pngPath.string(), size, pixels, taskPool) && CheckPNG(pngPath, size, pixels);
+			const bool exr = WriteEXR(exrPath.string(), size, pixels, taskPool) && CheckEXR(exrPath, size, pixels);
+			Log::Info("Test",
+			          "{:>3}x{:<3} on {:>2} threads: PNG {}, EXR {}.",
+			          size.x,
+			          size.y,
+			          taskPool ? taskPool->GetThreadCount() : 1,
+			          png ? "ok" : "failed",
+			          exr ? "ok" : "failed");
+			test.Check(png && exr, "{}x{}: Images written do not read back as they were!", size.x, size.y);
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::remove(pngPath, error);
+	std::filesystem::remove(exrPath, error);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+class TestContext;
+
+// Writes test images of awkward sizes with WritePNG and WriteEXR, both on one thread and spread over the render
+// threads, then reads every file back and compares it to the source pixels. PNGs are decoded with stb_image and EXRs
+// with tinyexr, so the EXR writer is checked against a reader that does not share its assumptions.
+void RunImageWriterTest(TestContext& test);
@@ -0,0 +1,120 @@
+#include "MeshLoaderTest.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ITaskPool.hpp"
+#include "MeshLoader.hpp"
+#include "TestHarness.hpp"
+
+using Luna::Log;
+
+namespace {
+constexpr uint32_t GridSize   = 32;
+constexpr uint32_t ChunkCount = 4;
+
+// Splits files into as many chunks as a pool of ChunkCount threads would, but runs them all on the calling thread, so
+// the chunks are the same on every machine.
+class SerialTaskPool : public ITaskPool {
+ public:
+	uint32_t GetThreadCount() const override {
+		return ChunkCount;
+	}
+	void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) override {
+		for (uint32_t i = 0; i < count; ++i) { func(i); }
+	}
+};
+
+// Writes the grid and returns the mesh the loader should make of it.
+MeshData WriteGrid(const std::filesystem::path& path, bool attributes) {
+	MeshData expected;
+	std::ofstream file(path, std::ios::binary);
+	for (uint32_t z = 0; z < GridSize; ++z) {
+		for (uint32_t x = 0; x < GridSize; ++x) {
+			file << "v " << x << " 0 " << z << "\n";
+			expected.Positions[0].push_back(float(x));
+			expected.Positions[1].push_back(0.0f);
+			expected.Positions[2].push_back(float(z));
+			if (attributes) {
+				file << "vn 0 1 0\nvt " << x << " " << z << "\n";
+				expected.Normals[0].push_back(0.0f);
+				expected.Normals[1].push_back(1.0f);
+				expected.Normals[2].push_back(0.0f);
+				expected.UVs[0].push_back(float(x));
+				expected.UVs[1].push_back(float(z));
+			}
+		}
+	}
+
+	for (uint32_t z = 0; z + 1 < GridSize; ++z) {
+		for (uint32_t x = 0; x + 1 < GridSize; ++x) {
+			const uint32_t corner    = z * GridSize + x;
+			const uint32_t indices[] = {
+				corner, corner + GridSize, corner + 1, corner + 1, corner + GridSize, corner + GridSize + 1};
+			for (const uint32_t index : indices) {
+				expected.PositionIndices.push_back(index);
+				if (attributes) {
+					expected.NormalIndices.push_back(index);
+					expected.UVIndices.push_back(index);
+				}
+			}
+		}
+	}
+	for (size_t i = 0; i < expected.PositionIndices.size(); i += 3) {
+		file << "f";
+		for (size_t j = i; j < i + 3; ++j) {
+			const uint32_t index = expected.PositionIndices[j] + 1;
+			file << " " << index;
+			if (attributes) { file << "/" << index << "/" << index; }
+		}
+		file << "\n";
+	}
+
+	// The vertices take up well under a quarter of the file and the comments a third, so with four chunks the second
+	// holds only faces and the last one only comments.
+	const auto body = file.tellp();
+	while (file.tellp() < body + body / 2) { file << "# Nothing but comments down here.\n"; }
+
+	return expected;
+}
+
+void CheckMesh(TestContext& test, const char* name, const MeshData* mesh, const MeshData& expected) {
+	if (!test.Check(mesh != nullptr, "{}: Failed to load the mesh!", name)) { return; }
+
+	Log::Info("Test",
+	          "{:<36} {} triangles and {} vertices, {} normals, {} UVs.",
+	          name,
+	          mesh->GetTriangleCount(),
+	          mesh->GetVertexCount(),
+	          mesh->HasNormals() ? "with" : "no",
+	          mesh->HasUVs() ? "with" : "no");
+	test.Check(mesh->Positions == expected.Positions && mesh->Normals == expected.Normals &&
+	             mesh->UVs == expected.UVs,
+	           "{}: Vertices do not match the ones written!",
+	           name);
+	test.Check(mesh->PositionIndices == expected.PositionIndices && mesh->NormalIndices == expected.NormalIndices &&
+	             mesh->UVIndices == expected.UVIndices,
+	           "{}: Indices do not match the ones written!",
+	           name);
+}
+}  // namespace
+
+void RunMeshLoaderTest(TestContext& test) {
+	const auto path = std::filesystem::temp_directory_path() / "RakeMeshLoaderTest.obj";
+
+	SerialTaskPool chunked;
+	for (const bool attributes : {false, true}) {
+		const MeshData expected = WriteGrid(path, attributes);
+		const std::string name  = attributes ? "Normals and UVs" : "Positions only";
+		CheckMesh(test, (name + ", one chunk").c_str(), LoadOBJ(path.string()).get(), expected);
+		CheckMesh(test, (name + ", four chunks").c_str(), LoadOBJ(path.string(), &chunked).get(), expected);
+		CheckMesh(
+			test, (name + ", render threads").c_str(), LoadOBJ(path.string(), &test.GetTracer()).get(), expected);
+	}
+
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+class TestContext;
+
+// Writes OBJ files of a triangulated grid, with and without normals and UVs, and loads them back split into several
+// chunks. The vertices come first and the file ends in a run of comments, so later chunks hold only faces or nothing at
+// all, and every vertex and index has to come back where it was written.
+void RunMeshLoaderTest(TestContext& test);
@@ -0,0 +1,59 @@
+#include "SlabTest.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <iterator>
+
+#include "LinearBVH.hpp"
+#include "TestHarness.hpp"
+#include "WideBVH.hpp"
+
+using Luna::Log;
+
+namespace {
+struct SlabCase {
+	const char* Name;
+	Point3 Origin;
+	Vector3 Direction;
+	bool Enters;
+};
+
+// All around the unit box. A direction of -0 turns the infinite inverse negative, which swaps the planes of that slab.
+const SlabCase Cases[] = {{"+X in plane y = 0", Point3(-1.0, 0.0, 0.5), Vector3(1.0, 0.0, 0.0), true},
+                          {"-X in plane y = 1", Point3(2.0, 1.0, 0.5), Vector3(-1.0, 0.0, 0.0), true},
+                          {"-X in plane y = 1, -0", Point3(2.0, 1.0, 0.5), Vector3(-1.0, -0.0, 0.0), true},
+                          {"+Y in plane x = 0", Point3(0.0, -1.0, 0.5), Vector3(0.0, 1.0, 0.0), true},
+                          {"-Z in plane x = 1", Point3(1.0, 0.5, 2.0), Vector3(0.0, 0.0, -1.0), true},
+                          {"+Z in plane y = 0, -0", Point3(0.5, 0.0, -1.0), Vector3(-0.0, -0.0, 1.0), true},
+                          {"+X below the box", Point3(-1.0, -0.5, 0.5), Vector3(1.0, 0.0, 0.0), false},
+                          {"-Y beside the box", Point3(1.5, 2.0, 0.5), Vector3(0.0, -1.0, 0.0), false}};
+}  // namespace
+
+void RunSlabTest(TestContext& test) {
+	LinearBVH bvh;
+	bvh.Build({AABB(Point3(0.0), Point3(1.0))});
+
+	Log::Info("Test", "Tracing {} rays through {}-wide nodes.", std::size(Cases), WideBVHWidth);
+	for (const bool quantize : {false, true}) {
+		WideBVH wideBVH;
+		wideBVH.Build(bvh.GetNodes(), quantize);
+
+		for (const auto& slab : Cases) {
+			const Ray ray(slab.Origin, slab.Direction);
+			bool entered         = false;
+			const auto EnterLeaf = [&](uint32_t, uint32_t, Real&) {
+				entered = true;
+				return false;
+			};
+			wideBVH.Intersect(ray, 0.0, Infinity, EnterLeaf);
+			const bool occluded = wideBVH.Occluded(ray, 0.0, Infinity, [](uint32_t, uint32_t) { return true; });
+
+			test.Check(entered == slab.Enters && occluded == slab.Enters,
+			           "{} ({} nodes): Expected the ray to {} the box, traversal {} it and any-hit {} it.",
+			           slab.Name,
+			           quantize ? "quantized" : "float",
+			           slab.Enters ? "enter" : "miss",
+			           entered ? "entered" : "missed",
+			           occluded ? "entered" : "missed");
+		}
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+class TestContext;
+
+// Traces rays parallel to the faces of a box through a wide BVH over it, both with and without quantized nodes. Rays
+// that lie in the plane of a face make the slab test of that axis compute 0 times infinity, and have to count as
+// entering the box the same way in the SSE, AVX2 and plain C++ builds (see RAKE_NO_SIMD); rays beside the box have to
+// miss it.
+void RunSlabTest(TestContext& test);
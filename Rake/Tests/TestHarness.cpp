@@ -0,0 +1,75 @@
+#include "TestHarness.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "LinearBVH.hpp"
+#include "SphereSet.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+TestContext::TestContext(std::string_view name, uint32_t threadCount) : _name(name), _threadCount(threadCount) {}
+
+Tracer& TestContext::GetTracer() {
+	if (!_tracer) { _tracer = std::make_unique<Tracer>(_threadCount); }
+
+	return *_tracer;
+}
+
+bool TestContext::Render(const glm::uvec2& size,
+                         uint32_t samplesPerPixel,
+                         const std::shared_ptr<World>& world,
+                         const TraceSettings& settings,
+                         std::vector<Color>& outPixels) {
+	Tracer& tracer     = GetTracer();
+	const bool started = tracer.StartTrace(size, samplesPerPixel, world, settings);
+	if (!Check(started, "{}: Failed to start raytrace task!", world->Name)) { return false; }
+	while (tracer.IsRunning()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		tracer.Update();
+	}
+	tracer.CopyPixels(outPixels);
+
+	return true;
+}
+
+int TestContext::Finish() const {
+	Log::Info("Test", "{} test {}.", _name, _passed ? "passed" : "failed");
+
+	return _passed ? 0 : 1;
+}
+
+std::shared_ptr<SphereSet> CreateSphereSet(const std::vector<PackedSphere>& spheres,
+                                           const std::vector<uint32_t>& materialIndices,
+                                           const std::vector<std::shared_ptr<IMaterial>>& materials) {
+	struct Storage {
+		std::vector<PackedSphere> Spheres;
+		std::vector<uint32_t> Materials;
+		std::vector<LinearBVHNode> Nodes;
+	};
+
+	std::vector<AABB> bounds;
+	for (const PackedSphere& sphere : spheres) {
+		const Point3 center(sphere.Center[0], sphere.Center[1], sphere.Center[2]);
+		const Vector3 extent(std::abs(sphere.Radius));
+		bounds.push_back(AABB(center - extent, center + extent));
+	}
+	LinearBVH bvh;
+	bvh.Build(bounds);
+	auto storage = std::make_shared<Storage>();
+	for (const uint32_t index : bvh.GetPrimitiveIndices()) {
+		storage->Spheres.push_back(spheres[index]);
+		storage->Materials.push_back(materialIndices[index]);
+	}
+	storage->Nodes.assign(bvh.GetNodes().begin(), bvh.GetNodes().end());
+
+	return std::make_shared<SphereSet>(storage->Spheres.data(),
+	                                   storage->Materials.data(),
+	                                   storage->Spheres.size(),
+	                                   storage->Nodes.data(),
+	                                   storage->Nodes.size(),
+	                                   materials,
+	                                   storage);
+}
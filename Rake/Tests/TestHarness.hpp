@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Luna/Utility/Log.hpp>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "DataTypes.hpp"
+#include "Tracer.hpp"
+
+class IMaterial;
+class SphereSet;
+class World;
+struct PackedSphere;
+
+// Everything a test runs with, and where it reports the checks it makes. Tests log what they look at on their own, the
+// context logs every check that fails and whether the whole test passed.
+class TestContext {
+ public:
+	TestContext(std::string_view name, uint32_t threadCount);
+
+	// The render threads, started the first time a test asks for them.
+	Tracer& GetTracer();
+	bool Passed() const {
+		return _passed;
+	}
+
+	// Records a check, logging the message as an error if it failed. Returns whether it passed.
+	template <typename... Args>
+	bool Check(bool passed, const fmt::format_string<Args...>& format, Args&&... args) {
+		if (!passed) {
+			Luna::Log::Error("Test", format, std::forward<Args>(args)...);
+			_passed = false;
+		}
+
+		return passed;
+	}
+
+	// Traces the world on the render threads, waits for the trace to finish and copies out the average of every pixel.
+	bool Render(const glm::uvec2& size,
+	            uint32_t samplesPerPixel,
+	            const std::shared_ptr<World>& world,
+	            const TraceSettings& settings,
+	            std::vector<Color>& outPixels);
+
+	// Logs whether the test passed and returns the process exit code.
+	int Finish() const;
+
+ private:
+	std::string_view _name;
+	uint32_t _threadCount;
+	std::unique_ptr<Tracer> _tracer;
+	bool _passed = true;
+};
+
+// A sphere set as a scene file makes one, with the spheres sorted into the leaf order of their BVH. Each sphere's
+// material is an index into the materials.
+std::shared_ptr<SphereSet> CreateSphereSet(const std::vector<PackedSphere>& spheres,
+                                           const std::vector<uint32_t>& materialIndices,
+                                           const std::vector<std::shared_ptr<IMaterial>>& materials);
@@ -0,0 +1,76 @@
+#include <Luna/Utility/Log.hpp>
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+#include "BVHUpdateTest.hpp"
+#include "EmitterTest.hpp"
+#include "FurnaceTest.hpp"
+#include "ImageWriterTest.hpp"
+#include "MeshLoaderTest.hpp"
+#include "SlabTest.hpp"
+#include "TestHarness.hpp"
+#include "WorldHashTest.hpp"
+
+using Luna::Log;
+
+namespace {
+struct TestCase {
+	std::string_view Name;
+	std::string_view Title;
+	void (*Run)(TestContext& test);
+};
+
+const TestCase Tests[] = {{"furnace", "Furnace", RunFurnaceTest},
+                          {"image", "Image writer", RunImageWriterTest},
+                          {"bvh", "BVH update", RunBVHUpdateTest},
+                          {"hash", "World hash", RunWorldHashTest},
+                          {"emitters", "Emitter", RunEmitterTest},
+                          {"slab", "Slab", RunSlabTest},
+                          {"mesh", "Mesh loader", RunMeshLoaderTest}};
+}  // namespace
+
+// Runs one of Rake's tests, which CTest registers one by one. Every test reports its checks to a TestContext, which
+// logs the ones that fail, and the exit code is non-zero if any of them did. Only tests that trace or build BVHs start
+// the render threads.
+//
+// Usage: RakeTests <furnace|image|bvh|hash|emitters|slab|mesh> [--threads <count>]
+int main(int argc, const char** argv) {
+	Log::Initialize();
+
+	std::string_view name;
+	uint32_t threadCount = 0;
+	bool valid           = argc > 1;
+	for (int i = 1; i < argc && valid; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc) {
+			const std::string_view value = argv[++i];
+			const auto result            = std::from_chars(value.data(), value.data() + value.size(), threadCount);
+			valid = result.ec == std::errc() && result.ptr == value.data() + value.size();
+		} else if (name.empty()) {
+			name = arg;
+		} else {
+			valid = false;
+		}
+	}
+
+	int result = 1;
+	if (valid) {
+		valid = false;
+		for (const auto& test : Tests) {
+			if (test.Name == name) {
+				TestContext context(test.Title, threadCount);
+				test.Run(context);
+				result = context.Finish();
+				valid  = true;
+			}
+		}
+	}
+	if (!valid) {
+		Log::Error("Test", "Usage: RakeTests <furnace|image|bvh|hash|emitters|slab|mesh> [--threads <count>]");
+	}
+
+	Log::Shutdown();
+
+	return result;
+}
@@ -0,0 +1,162 @@
+#include "WorldHashTest.hpp"
+
+#include <Luna/Utility/Log.hpp>
+#include <filesystem>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iterator>
+#include <vector>
+
+#include "Checkpoint.hpp"
+#include "Instance.hpp"
+#include "Materials/GradientSkyMaterial.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "Materials/MetalMaterial.hpp"
+#include "SphereSet.hpp"
+#include "TestHarness.hpp"
+#include "TriangleMesh.hpp"
+#include "World.hpp"
+
+using Luna::Log;
+
+namespace {
+// Everything about the world that one of the tests changes. None of the changes move the outside of any object.
+enum class Change {
+	None,
+	PooledSphereHollow,  // Turns a pooled sphere inside out, which keeps its bounds.
+	SetSphereMoved,      // Moves a sphere in the middle of the sphere set.
+	SetSphereMaterial,   // Gives a sphere in the middle of the sphere set another material.
+	MeshVertexMoved,     // Moves a vertex in the middle of the mesh, within its plane.
+	MeshIndicesChanged,  // Splits a quad in the middle of the mesh along its other diagonal.
+	InstanceMoved,       // Turns the instance of the mesh around its center.
+	MaterialChanged,     // Makes the metal rougher.
+	SkyChanged,
+	Count
+};
+
+const char* ChangeNames[] = {"None",
+                             "Pooled sphere hollow",
+                             "Set sphere moved",
+                             "Set sphere material",
+                             "Mesh vertex moved",
+                             "Mesh indices changed",
+                             "Instance moved",
+                             "Material changed",
+                             "Sky changed"};
+static_assert(std::size(ChangeNames) == size_t(Change::Count), "Every change needs a name!");
+
+constexpr uint32_t SetSize  = 5;  // Spheres along each side of the sphere set.
+constexpr uint32_t GridSize = 4;  // Vertices along each side of the mesh.
+
+// The sphere set, a grid of spheres with the changes to it made.
+std::shared_ptr<SphereSet> CreateSphereGrid(const std::vector<std::shared_ptr<IMaterial>>& materials, Change change) {
+	std::vector<PackedSphere> spheres;
+	std::vector<uint32_t> sphereMaterials;
+	for (uint32_t z = 0; z < SetSize; ++z) {
+		for (uint32_t x = 0; x < SetSize; ++x) {
+			const bool middle = x == SetSize / 2 && z == SetSize / 2;
+			PackedSphere sphere{{float(x) * 3.0f, 0.0f, float(z) * 3.0f - 20.0f}, 1.0f};
+			if (middle && change == Change::SetSphereMoved) { sphere.Center[1] += 0.25f; }
+			spheres.push_back(sphere);
+			sphereMaterials.push_back(middle && change == Change::SetSphereMaterial ? 1 : 0);
+		}
+	}
+
+	return CreateSphereSet(spheres, sphereMaterials, materials);
+}
+
+// A flat grid of quads in the XZ plane, each split into two triangles.
+std::shared_ptr<MeshData> CreateGrid(Change change) {
+	auto mesh = std::make_shared<MeshData>();
+	for (uint32_t z = 0; z < GridSize; ++z) {
+		for (uint32_t x = 0; x < GridSize; ++x) {
+			const bool middle = x == GridSize / 2 && z == GridSize / 2;
+			mesh->Positions[0].push_back(float(x) + (middle && change == Change::MeshVertexMoved ? 0.25f : 0.0f));
+			mesh->Positions[1].push_back(0.0f);
+			mesh->Positions[2].push_back(float(z));
+		}
+	}
+	for (uint32_t z = 0; z + 1 < GridSize; ++z) {
+		for (uint32_t x = 0; x + 1 < GridSize; ++x) {
+			const uint32_t a = z * GridSize + x;
+			const uint32_t b = a + 1;
+			const uint32_t c = a + GridSize;
+			const uint32_t d = c + 1;
+			if (x == GridSize / 2 - 1 && z == GridSize / 2 - 1 && change == Change::MeshIndicesChanged) {
+				mesh->PositionIndices.insert(mesh->PositionIndices.end(), {a, b, c, b, d, c});
+			} else {
+				mesh->PositionIndices.insert(mesh->PositionIndices.end(), {a, b, d, a, d, c});
+			}
+		}
+	}
+
+	return mesh;
+}
+
+std::shared_ptr<World> CreateTestWorld(Change change) {
+	auto world = std::make_shared<World>("Hash");
+	world->Sky = change == Change::SkyChanged
+	                 ? std::make_shared<GradientSkyMaterial>(Color(1.0f), Color(0.5f, 0.7f, 1.0f), 0.6f)
+	                 : std::make_shared<GradientSkyMaterial>(Color(1.0f), Color(0.5f, 0.7f, 1.0f), 0.5f);
+
+	const std::vector<std::shared_ptr<IMaterial>> materials = {
+		std::make_shared<LambertianMaterial>(Color(0.5f)),
+		std::make_shared<MetalMaterial>(Color(0.8f), change == Change::MaterialChanged ? 0.3 : 0.2)};
+	world->AddSphere(Point3(0.0, 1.0, 0.0), 1.0, materials[0]);
+	world->AddSphere(Point3(3.0, 1.0, 0.0), change == Change::PooledSphereHollow ? -1.0 : 1.0, materials[1]);
+	world->AddRectangle(RectanglePlane::XZ, Point2(-10.0), Point2(10.0), 0.0, materials[0]);
+
+	world->Objects.Add(CreateSphereGrid(materials, change));
+	const auto grid = std::make_shared<TriangleMesh>(CreateGrid(change), materials[0]);
+	world->Objects.Add(grid);
+	Matrix4 transform = glm::translate(Matrix4(1), Vector3(10.0, 0.0, 0.0));
+	if (change == Change::InstanceMoved) {
+		// Half a turn around the center of the grid covers the same ground.
+		const Real center = Real(GridSize - 1) / 2;
+		transform         = glm::translate(transform, Vector3(center, 0.0, center));
+		transform         = glm::rotate(transform, Pi, Vector3(0.0, 1.0, 0.0));
+		transform         = glm::translate(transform, Vector3(-center, 0.0, -center));
+	}
+	world->Objects.Add<Instance>(grid, transform);
+
+	return world;
+}
+}  // namespace
+
+void RunWorldHashTest(TestContext& test) {
+	const auto path = (std::filesystem::temp_directory_path() / "RakeWorldHashTest.checkpoint").string();
+
+	Checkpoint::Key key;
+	key.ImageSize       = glm::uvec2(16);
+	key.TileSize        = 16;
+	key.TileCount       = 1;
+	key.SamplesPerPixel = 1;
+	key.SceneHash       = CreateTestWorld(Change::None)->GetHash();
+
+	for (uint32_t i = 0; i < uint32_t(Change::Count); ++i) {
+		const auto change = Change(i);
+
+		// Start each change from a checkpoint of the original world, which has to resume as long as nothing changed.
+		Checkpoint checkpoint;
+		bool resumed = false;
+		bool opened  = checkpoint.Open(path, key, resumed) && checkpoint.Open(path, key, resumed) && resumed;
+
+		Checkpoint::Key changedKey = key;
+		changedKey.SceneHash       = CreateTestWorld(change)->GetHash();
+		opened &= checkpoint.Open(path, changedKey, resumed);
+		checkpoint.Close();
+
+		const bool expectResumed = change == Change::None;
+		Log::Info("Test",
+		          "{:<22} hash {:016x}, checkpoint {}.",
+		          ChangeNames[i],
+		          changedKey.SceneHash,
+		          !opened ? "failed to open" : (resumed ? "resumed" : "started over"));
+		test.Check(opened && resumed == expectResumed,
+		           "{}: Expected the checkpoint to {}!",
+		           ChangeNames[i],
+		           expectResumed ? "resume" : "start over");
+	}
+
+	std::error_code error;
+	std::filesystem::remove(path, error);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+class TestContext;
+
+// Builds a world out of every kind of primitive and makes changes to it that leave the bounds of every object alone,
+// such as moving a sphere inside a sphere set or a vertex inside a mesh. Each change has to change World::GetHash, and
+// with it keep a checkpoint of the original world from being resumed, while building the same world twice has to give
+// the same hash.
+void RunWorldHashTest(TestContext& test);
@@ -3,32 +3,47 @@
 #include <Luna/Utility/Log.hpp>
 #include <Luna/Utility/Time.hpp>
 #include <Tracy.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #include "IMaterial.hpp"
 #include "ISkyMaterial.hpp"
+#include "Materials/DielectricMaterial.hpp"
+#include "Materials/DiffuseLightMaterial.hpp"
+#include "Materials/LambertianMaterial.hpp"
+#include "Materials/MetalMaterial.hpp"
 #include "Random.hpp"
 #include "Ray.hpp"
 #include "World.hpp"
 
 using Luna::Log;
 
-static inline uint64_t ConstructTask(uint16_t yMin, uint16_t yMax, uint32_t sample) {
-	return static_cast<uint64_t>(static_cast<uint64_t>(sample) | (static_cast<uint64_t>(yMax) << 32) |
-	                             (static_cast<uint64_t>(yMin) << 48));
+// A task renders one pass over one tile. Every tile starts out with exactly one task, and each task queues the next pass
+// of its tile when it finishes, so a tile never has more than one task queued or running. That task owns the tile's
+// pixels for as long as it runs.
+static inline uint64_t ConstructTask(uint32_t tile, uint32_t sample) {
+	return (static_cast<uint64_t>(tile) << 32) | static_cast<uint64_t>(sample);
 }
 
-static inline void DeconstructTask(uint64_t task, uint16_t& yMin, uint16_t& yMax, uint32_t& sample) {
-	yMin   = static_cast<uint16_t>((task >> 48) & 0xffff);
-	yMax   = static_cast<uint16_t>((task >> 32) & 0xffff);
+static inline void DeconstructTask(uint64_t task, uint32_t& tile, uint32_t& sample) {
+	tile   = static_cast<uint32_t>(task >> 32);
 	sample = static_cast<uint32_t>(task & 0xffffffff);
 }
 
-Tracer::Tracer() {
-	const auto threadCount = std::max(std::thread::hardware_concurrency() - 2u, 1u);
+// Multiple importance sampling weight of a sample taken with density pdf, against another technique that could have
+// taken the same sample with density otherPdf.
+static inline Real PowerHeuristic(Real pdf, Real otherPdf) {
+	return pdf * pdf / (pdf * pdf + otherPdf * otherPdf);
+}
+
+Tracer::Tracer(uint32_t threadCount) {
+	if (threadCount == 0) { threadCount = std::max(std::thread::hardware_concurrency(), 3u) - 2u; }
 	Log::Info("Tracer", "Starting {} render threads.", threadCount);
 	_running = true;
-	for (int i = 0; i < threadCount; ++i) {
-		_renderThreads.emplace_back([this, i]() { RenderThread(i + 1); });
+	for (uint32_t i = 0; i < threadCount; ++i) { _workQueues.push_back(std::make_unique<WorkQueue>()); }
+	for (uint32_t i = 0; i < threadCount; ++i) {
+		_renderThreads.emplace_back([this, i]() { RenderThread(i); });
 	}
 }
 
@@ -41,16 +56,59 @@ Tracer::~Tracer() noexcept {
 	for (auto& thread : _renderThreads) { thread.join(); }
 }
 
-bool Tracer::StartTrace(const glm::uvec2& imageSize, uint32_t samplesPerPixel, const std::shared_ptr<World>& world) {
+bool Tracer::StartTrace(const glm::uvec2& imageSize,
+                        uint32_t samplesPerPixel,
+                        const std::shared_ptr<World>& world,
+                        const TraceSettings& settings) {
 	if (_rendering) { return false; }
 
 	constexpr uint32_t linesPerTask = 10;
 
+	// Choose our tile size. Unless told otherwise, aim for enough tiles that every thread has several to work on, so
+	// stealing can even out the difference between cheap and expensive regions of the image. The constants are reasoned
+	// rather than measured:
+	// - Sizes stay powers of two from 8 to 64, so tiles line up with the framebuffer's aligned squares and never share
+	//   a cache line with their neighbours (see Framebuffer).
+	// - 16 tiles per thread leaves the last tiles of a trace small next to the whole, so threads run out of work at
+	//   about the same time.
+	// - Below 8x8, the fixed cost of a tile, such as scheduling it, publishing it and its preview passes, starts to
+	//   count against 64 pixels of work.
+	// --benchmark scheduler times this choice against every fixed size on the machine it runs on, and should be rerun
+	// before any of these change.
+	uint32_t tileSize = settings.TileSize;
+	if (tileSize == 0 && !settings.CheckpointFile.empty()) {
+		tileSize = Checkpoint::ReadTileSize(settings.CheckpointFile);
+	}
+	if (tileSize == 0) {
+		const uint64_t targetTiles = _renderThreads.size() * 16;
+		tileSize                   = 64;
+		while (tileSize > 8) {
+			const uint64_t tilesX = (imageSize.x + tileSize - 1) / tileSize;
+			const uint64_t tilesY = (imageSize.y + tileSize - 1) / tileSize;
+			if (tilesX * tilesY >= targetTiles) { break; }
+			tileSize /= 2;
+		}
+	}
+
 	Log::Info("Tracer", "Starting raytrace task.");
 	Log::Info("Tracer", "- Image Size: {} x {}", imageSize.x, imageSize.y);
 	Log::Info("Tracer", "- Samples Per Pixel: {}", samplesPerPixel);
 	Log::Info("Tracer", "- World: {}", world->Name);
-	Log::Info("Tracer", "- Lines Per Task: {}", linesPerTask);
+	if (settings.Scheduler == TraceScheduler::SharedQueue) {
+		Log::Info("Tracer", "- Scheduler: Shared Queue");
+		Log::Info("Tracer", "- Lines Per Task: {}", linesPerTask);
+	} else {
+		Log::Info("Tracer", "- Scheduler: Work Stealing");
+		Log::Info("Tracer", "- Tile Size: {} x {}", tileSize, tileSize);
+	}
+	Log::Info("Tracer",
+	          "- Integrator: {}",
+	          settings.Integrator == TraceIntegrator::Wavefront ? "Wavefront" : "Recursive");
+	Log::Info("Tracer", "- Max Depth: {}", std::max(settings.MaxDepth, 1u));
+	if (settings.PacketTracing) { Log::Info("Tracer", "- Packet Width: {}", PacketWidth); }
+	if (settings.ErrorThreshold > 0.0f) { Log::Info("Tracer", "- Adaptive Error Threshold: {}", settings.ErrorThreshold); }
+	if (settings.PreviewLevels > 0) { Log::Info("Tracer", "- Preview Levels: {}", settings.PreviewLevels); }
+	if (!settings.CheckpointFile.empty()) { Log::Info("Tracer", "- Checkpoint: {}", settings.CheckpointFile); }
 
 	// Set our initial parameters.
 	const double aspectRatio = static_cast<double>(imageSize.x) / static_cast<double>(imageSize.y);
@@ -61,45 +119,140 @@ bool Tracer::StartTrace(const glm::uvec2& imageSize, uint32_t samplesPerPixel, c
                    world->CameraAperture,
                    world->CameraFocusDistance);
 	_totalRaycasts           = 0;
+	for (auto& count : _bounceRaycasts) { count = 0; }
 	_imageSize               = imageSize;
 	_rendering               = true;
 	_samplesPerPixel         = samplesPerPixel;
 	_world                   = world;
 
-	// Initialize our canvas.
-	_pixels.resize(_imageSize.x * _imageSize.y);
-	std::fill(_pixels.begin(), _pixels.end(), Color(0));
-	_avgPixels.resize(_imageSize.x * _imageSize.y);
-	std::fill(_avgPixels.begin(), _avgPixels.end(), Color(0));
-
-	// Construct our world BVH.
+	// Bring our world BVH up to date. Camera changes leave it alone entirely, and rebuilds are spread across the render
+	// threads, which have nothing else to do yet.
 	{
 		Luna::Utility::ElapsedTime bvhTime;
 		bvhTime.Update();
-		_world->ConstructBVH();
+		const BVHUpdate update = _world->UpdateBVH(this);
 		bvhTime.Update();
-		Log::Info("Tracer", "Constructed world BVH in {}ms.", bvhTime.Get().AsMilliseconds<float>());
+		const float bvhMs = bvhTime.Get().AsMilliseconds<float>();
+		switch (update) {
+			case BVHUpdate::None:
+				Log::Info("Tracer", "World BVH is up to date.");
+				break;
+			case BVHUpdate::Refit:
+				Log::Info("Tracer",
+				          "Refit world BVH in {}ms, cost is {:.2f}x that of a fresh build.",
+				          bvhMs,
+				          _world->BVH->GetCostRatio());
+				break;
+			case BVHUpdate::Rebuild:
+				Log::Info(
+					"Tracer", "Constructed world BVH with {} nodes in {}ms.", _world->BVH->GetNodeCount(), bvhMs);
+				break;
+			case BVHUpdate::SwapRebuilt:
+				Log::Info("Tracer", "Swapped in world BVH rebuilt in the background, refit in {}ms.", bvhMs);
+				break;
+		}
+	}
+
+	// Split the image into tiles. The shared queue keeps the original full-width bands.
+	_scheduler      = settings.Scheduler;
+	_integrator     = settings.Integrator;
+	_maxDepth       = std::max(settings.MaxDepth, 1u);
+	_packetTracing  = settings.PacketTracing;
+	_errorThreshold = settings.ErrorThreshold;
+	_previewLevels  = std::min(settings.PreviewLevels, MaxPreviewLevels);
+	_displayEnabled = settings.Display;
+	_tiles.clear();
+	if (_scheduler == TraceScheduler::SharedQueue) {
+		for (uint32_t y = 0; y < _imageSize.y; y += linesPerTask) {
+			_tiles.push_back({glm::uvec2(0, y), glm::uvec2(_imageSize.x, std::min(y + linesPerTask, _imageSize.y))});
+		}
+	} else {
+		for (uint32_t y = 0; y < _imageSize.y; y += tileSize) {
+			for (uint32_t x = 0; x < _imageSize.x; x += tileSize) {
+				_tiles.push_back({glm::uvec2(x, y), glm::min(glm::uvec2(x, y) + tileSize, _imageSize)});
+			}
+		}
+	}
+
+	// Initialize our canvas, right in the checkpoint file if we have one. The framebuffers are still attached to the
+	// previous trace's checkpoint until they are reset, but nothing looks at them in between.
+	bool resumed = false;
+	_checkpoint.Close();
+	if (!settings.CheckpointFile.empty()) {
+		Checkpoint::Key key;
+		key.SceneHash       = _world->GetHash();
+		key.ImageSize       = _imageSize;
+		key.Scheduler       = static_cast<uint32_t>(_scheduler);
+		key.Integrator      = static_cast<uint32_t>(_integrator);
+		key.MaxDepth        = _maxDepth;
+		key.TileSize        = _scheduler == TraceScheduler::SharedQueue ? linesPerTask : tileSize;
+		key.TileCount       = static_cast<uint32_t>(_tiles.size());
+		key.SamplesPerPixel = _samplesPerPixel;
+		key.ErrorThreshold  = _errorThreshold;
+		if (_checkpoint.Open(settings.CheckpointFile, key, resumed)) {
+			_pixels.Attach(_imageSize, _checkpoint.GetSum());
+			_avgPixels.Attach(_imageSize, _checkpoint.GetAverage());
+			_nextCheckpointFlush = std::chrono::steady_clock::now() + CheckpointInterval;
+		} else {
+			Log::Error("Tracer", "Failed to open checkpoint '{}', tracing without one.", settings.CheckpointFile);
+		}
+	}
+	if (!_checkpoint.IsOpen()) {
+		_pixels.Reset(_imageSize);
+		_avgPixels.Reset(_imageSize);
+	}
+
+	if (_displayEnabled) {
+		_display.Reset(_imageSize, _tiles);
+	} else {
+		_display.Reset(glm::uvec2(0), {});
 	}
 
 	// Dispatch our first round of render tasks.
-	_taskGroupCount    = 0;
-	_lastUpdatedSample = 0;
-	_completedSamples  = 0;
-	uint32_t remaining = _imageSize.y;
+	_taskGroupCount     = static_cast<uint32_t>(_tiles.size());
+	_tileErrors         = std::vector<std::atomic<float>>(_taskGroupCount);
+	_lastUpdatedSample  = 0;
+	_lastUpdatedPreview = 0;
+	_completedSamples   = 0;
+	_completedPreviews  = 0;
+	_pixelSamples       = 0;
+	_stolenTasks        = 0;
+	_activeTiles        = _taskGroupCount;
+	_sampleBudget       = _checkpoint.IsOpen() ? &_checkpoint.GetSampleBudget() : &_localSampleBudget;
+	if (!resumed) { *_sampleBudget = 0; }
+	for (auto& error : _tileErrors) { error = std::numeric_limits<float>::infinity(); }
+	_renderTime.Start();
 	{
 		std::lock_guard<std::mutex> lock(_tasksMutex);
-		while (remaining > 0) {
-			const uint32_t yMin = _imageSize.y - remaining;
-			const uint32_t yMax = std::min(yMin + linesPerTask, _imageSize.y);
-			remaining           = _imageSize.y - yMax;
-
-			const auto task = ConstructTask(yMin, yMax, 0);
-			_tasks.push(task);
-			++_taskGroupCount;
+		uint32_t resumedTiles = 0;
+		for (uint32_t tile = 0; tile < _taskGroupCount; ++tile) {
+			uint32_t pass = 0;
+			if (resumed && !ResumeTile(tile, pass)) {
+				--_activeTiles;
+				continue;
+			}
+			if (pass > 0) { ++resumedTiles; }
+
+			const auto task = ConstructTask(tile, pass);
+			if (_scheduler == TraceScheduler::SharedQueue) {
+				_tasks.push(task);
+			} else {
+				// Deal the tiles out round-robin, so every thread starts with tiles spread across the whole image.
+				auto& queue = *_workQueues[tile % _workQueues.size()];
+				std::lock_guard<std::mutex> queueLock(queue.Mutex);
+				queue.Tasks.push_back(task);
+				++_pendingTasks;
+			}
 		}
-		_neededSamples = _taskGroupCount * _samplesPerPixel;
-		_renderTime.Start();
 		_tasksCondition.notify_all();
+
+		if (resumed) {
+			Log::Info("Tracer",
+			          "Resumed checkpoint with {} samples taken, {} tiles done and {} in progress.",
+			          _completedSamples.load(),
+			          _taskGroupCount - _activeTiles,
+			          resumedTiles);
+		}
 	}
 
 	return true;
@@ -109,110 +262,749 @@ bool Tracer::CancelTrace() {
 	if (!_rendering) { return true; }
 
 	Log::Info("Tracer", "Cancelling raytrace task.");
+	// PushTask drops anything pushed under a queue's lock once rendering has stopped, so after this clear the queues stay
+	// empty, and no task can be taken from them that is not already counted as running.
 	{
 		std::lock_guard<std::mutex> lock(_tasksMutex);
-		while (!_tasks.empty()) { _tasks.pop(); }
 		_rendering = false;
+		ClearTasks();
 	}
 
+	// Wait for the tasks that were already running to finish. Nothing touches the canvas after that, and the next trace
+	// can safely reset it.
+	for (uint32_t running = _runningTasks; running > 0; running = _runningTasks) { _runningTasks.wait(running); }
+	_checkpoint.Flush();
+
 	return true;
 }
 
 void Tracer::Update() {
 	if (_rendering) {
 		_renderTime.Update();
-		if (_completedSamples == _neededSamples) {
+		const auto now = std::chrono::steady_clock::now();
+		if (_checkpoint.IsOpen() && (_activeTiles == 0 || now >= _nextCheckpointFlush)) {
+			_checkpoint.Flush();
+			_nextCheckpointFlush = now + CheckpointInterval;
+		}
+		if (_activeTiles == 0) {
 			_renderTime.Stop();
 			_rendering = false;
 			_world.reset();
 			Log::Info("Tracer", "Raytrace task completed in {}ms.", _renderTime.Get().AsMilliseconds<float>());
+			Log::Info("Tracer", "- Average Samples Per Pixel: {:.2f}", GetAverageSamples());
+			Log::Info("Tracer", "- Estimated Error: {:.5f}", GetError());
 		}
 	}
 }
 
 bool Tracer::UpdatePixels(std::vector<Color>& pixels) {
 	bool update = (_lastUpdatedSample + 100) < _completedSamples;
-	update |= _completedSamples == _neededSamples && _lastUpdatedSample != _completedSamples;
+	update |= _activeTiles == 0 && _lastUpdatedSample != _completedSamples;
+	// Preview passes are quick and meant to be seen as soon as possible, so show every bit of progress on them.
+	update |= _lastUpdatedPreview != _completedPreviews;
 
 	if (update) {
-		_lastUpdatedSample = _completedSamples;
-		pixels             = _avgPixels;
+		_lastUpdatedSample  = _completedSamples;
+		_lastUpdatedPreview = _completedPreviews;
+		_avgPixels.CopyTo(pixels);
 	}
 
 	return update;
 }
 
-void Tracer::RenderThread(int threadID) {
-	while (_running) {
-		uint64_t task = 0;
-		{
-			std::unique_lock<std::mutex> lock(_tasksMutex);
-			_tasksCondition.wait(lock, [this]() { return !_running || !_tasks.empty(); });
+void Tracer::CopyPixels(std::vector<Color>& pixels) const {
+	// The average, not the sum, whose alpha holds M2 rather than opacity.
+	_avgPixels.CopyTo(pixels);
+}
 
-			if (!_running && _tasks.empty()) { break; }
+float Tracer::GetError() const {
+	double errorSum    = 0.0;
+	uint32_t tileCount = 0;
+	for (const auto& tileError : _tileErrors) {
+		const float error = tileError.load(std::memory_order_relaxed);
+		if (std::isinf(error)) { continue; }
+		errorSum += error;
+		++tileCount;
+	}
 
-			task = _tasks.front();
-			_tasks.pop();
-		}
+	return tileCount > 0 ? static_cast<float>(errorSum / tileCount) : std::numeric_limits<float>::infinity();
+}
 
-		uint16_t yMin;
-		uint16_t yMax;
-		uint32_t sample;
-		DeconstructTask(task, yMin, yMax, sample);
-		const float avgFactor = 1.0f / (static_cast<float>(sample) + 1.0f);
-		uint64_t raycasts     = 0;
+double Tracer::GetAveragePathLength() const {
+	const uint64_t paths = _bounceRaycasts[0];
+	if (paths == 0) { return 0.0; }
 
-		{
-			const uint32_t width  = _imageSize.x;
-			const uint32_t height = _imageSize.y;
-			for (uint32_t y = yMin; y < yMax; ++y) {
-				for (uint32_t x = 0; x < width; ++x) {
-					const Color rayColor = Sample(glm::uvec2(x, y), _imageSize, _camera, *_world, raycasts);
-
-					const auto offset = (y * width) + x;
-					_pixels[offset] += rayColor;
-					_avgPixels[offset] = _pixels[offset] * avgFactor;
+	uint64_t pathRays = 0;
+	for (const auto& count : _bounceRaycasts) { pathRays += count; }
+
+	return double(pathRays) / double(paths);
+}
+
+void Tracer::RenderThread(uint32_t threadIndex) {
+	ThreadSampler() = Sampler(threadIndex + 1);
+	WavefrontQueue wavefront;
+	std::vector<Color> tileRadiance;
+	uint64_t task = 0;
+	while (AcquireTask(threadIndex, task)) {
+		uint32_t tileIndex;
+		uint32_t pass;
+		DeconstructTask(task, tileIndex, pass);
+		const RenderTile tile = _tiles[tileIndex];
+		RayCounts rays;
+
+		// Every tile starts with its preview passes, coarsest first, and only then takes its actual samples.
+		if (pass < _previewLevels) {
+			RenderTilePreview(tile, 1u << (_previewLevels - pass), rays);
+			PublishTile(tile, tileIndex);
+			_completedPreviews.fetch_add(1, std::memory_order_relaxed);
+			AddRayCounts(rays);
+			if (_rendering) {
+				PushTask(threadIndex, ConstructTask(tileIndex, pass + 1));
+			} else {
+				--_activeTiles;
+			}
+			FinishTask();
+			continue;
+		}
+
+		// Trace the whole sample into a buffer of our own first, and only then fold it into the image.
+		uint32_t sample           = pass - _previewLevels;
+		const uint32_t tileWidth  = tile.Max.x - tile.Min.x;
+		const uint32_t tilePixels = tileWidth * (tile.Max.y - tile.Min.y);
+		const Color* radiance     = nullptr;
+		if (_integrator == TraceIntegrator::Wavefront) {
+			RenderTileWavefront(wavefront, tile, sample, rays);
+			radiance = wavefront.Radiance.data();
+		} else {
+			if (tileRadiance.size() < tilePixels) { tileRadiance.resize(tilePixels); }
+			Color* pixel = tileRadiance.data();
+			for (uint32_t y = tile.Min.y; y < tile.Max.y; ++y) {
+				if (_packetTracing) {
+					std::array<Color, PacketWidth> colors;
+					for (uint32_t x = tile.Min.x; x < tile.Max.x; x += PacketWidth) {
+						const uint32_t laneCount = std::min(PacketWidth, tile.Max.x - x);
+						SamplePacket(
+							glm::uvec2(x, y), laneCount, sample, _imageSize, _camera, *_world, _maxDepth, rays, colors);
+						pixel = std::copy(colors.begin(), colors.begin() + laneCount, pixel);
+					}
+				} else {
+					for (uint32_t x = tile.Min.x; x < tile.Max.x; ++x) {
+						*pixel++ = Sample(glm::uvec2(x, y), sample, _imageSize, _camera, *_world, _maxDepth, rays);
+					}
 				}
 			}
+			radiance = tileRadiance.data();
 		}
+		if (_checkpoint.IsOpen()) { _checkpoint.BeginTileWrite(tileIndex); }
+		AccumulateTile(tile, sample, radiance);
+		if (_checkpoint.IsOpen()) { _checkpoint.EndTileWrite(tileIndex, sample + 1); }
+		PublishTile(tile, tileIndex);
 
+		_pixelSamples.fetch_add(tilePixels, std::memory_order_relaxed);
 		_completedSamples.fetch_add(1, std::memory_order_relaxed);
-		_totalRaycasts.fetch_add(raycasts, std::memory_order_acq_rel);
-		if (_rendering && ++sample < _samplesPerPixel) {
-			std::unique_lock<std::mutex> lock(_tasksMutex);
-			const auto task = ConstructTask(yMin, yMax, sample);
-			_tasks.push(task);
-			_tasksCondition.notify_one();
+		AddRayCounts(rays);
+		const bool rendering = _rendering;
+		if (rendering && ContinueTile(tile, tileIndex, ++sample)) {
+			PushTask(threadIndex, ConstructTask(tileIndex, sample + _previewLevels));
+		} else {
+			// Tiles stopped by a cancel are not done, a resumed trace carries on with them.
+			if (rendering && _checkpoint.IsOpen()) { _checkpoint.FinishTile(tileIndex); }
+			--_activeTiles;
+		}
+		FinishTask();
+	}
+}
+
+// Picks a tile up from the checkpoint where the last trace left it. Returns false if the tile needs no more samples,
+// and otherwise the pass to carry on from.
+bool Tracer::ResumeTile(uint32_t tileIndex, uint32_t& outPass) {
+	const RenderTile& tile  = _tiles[tileIndex];
+	Checkpoint::Tile& state = _checkpoint.GetTiles()[tileIndex];
+
+	// A tile that died halfway through adding a sample has some of its pixels updated and some not, so it starts over.
+	if (state.Flags & Checkpoint::TileWriting) {
+		for (uint32_t y = tile.Min.y; y < tile.Max.y; ++y) {
+			for (uint32_t x = tile.Min.x; x < tile.Max.x; ++x) {
+				_pixels(x, y)    = glm::vec4(0.0f);
+				_avgPixels(x, y) = glm::vec4(0.0f);
+			}
+		}
+		state = {};
+	}
+
+	outPass = 0;
+	if (state.Samples == 0) { return true; }
+
+	const uint32_t tilePixels = (tile.Max.x - tile.Min.x) * (tile.Max.y - tile.Min.y);
+	_completedSamples += state.Samples;
+	_pixelSamples     += uint64_t(state.Samples) * tilePixels;
+	UpdateTileError(tile, tileIndex, state.Samples);
+	PublishTile(tile, tileIndex);
+	outPass = _previewLevels + state.Samples;
+
+	// Adaptive traces have to remember which tiles were done, anything else just tops every tile up to the requested
+	// number of samples.
+	if (_errorThreshold > 0.0f) { return (state.Flags & Checkpoint::TileFinished) == 0; }
+
+	return state.Samples < _samplesPerPixel;
+}
+
+void Tracer::AccumulateTile(const RenderTile& tile, uint32_t sample, const Color* radiance) {
+	// Only the thread running the tile's task ever touches its pixels, and a tile only has one task at a time, so this
+	// needs no synchronization. Each pixel also keeps a running variance of its luminance (Welford's method).
+	const float avgFactor = 1.0f / (static_cast<float>(sample) + 1.0f);
+	for (uint32_t y = tile.Min.y; y < tile.Max.y; ++y) {
+		for (uint32_t x = tile.Min.x; x < tile.Max.x; ++x) {
+			const Color& color = *radiance++;
+			glm::vec4& sum     = _pixels(x, y);
+			glm::vec4& average = _avgPixels(x, y);
+			const float before = Luminance(Color(average));
+			sum               += glm::vec4(color, 0.0f);
+			average            = glm::vec4(Color(sum) * avgFactor, 0.0f);
+
+			const float luminance = Luminance(color);
+			sum.a += (luminance - before) * (luminance - Luminance(Color(average)));
 		}
 	}
 }
 
-Color Tracer::Sample(
-	const glm::uvec2& coords, const glm::uvec2& imageSize, const Camera& camera, const World& world, uint64_t& raycasts) {
-	const auto s  = (double(coords.x) + RandomDouble()) / (imageSize.x - 1);
-	const auto t  = 1.0 - ((double(coords.y) + RandomDouble()) / (imageSize.y - 1));
-	const Ray ray = camera.GetRay(s, t);
+void Tracer::PublishTile(const RenderTile& tile, uint32_t tileIndex) {
+	// Only the linear pixels are published, the UI applies gamma to the tiles it actually picks up. Nothing is published
+	// at all without a UI to pick them up.
+	if (!_displayEnabled) { return; }
 
-	return CastRay(ray, world, raycasts, 0);
+	Color* slot = _display.BeginPublish(tileIndex);
+	for (uint32_t y = tile.Min.y; y < tile.Max.y; ++y) {
+		for (uint32_t x = tile.Min.x; x < tile.Max.x; ++x) { *slot++ = Color(_avgPixels(x, y)); }
+	}
+	_display.EndPublish(tileIndex);
 }
 
-Color Tracer::CastRay(const Ray& ray, const World& world, uint64_t& raycasts, uint32_t depth) {
-	constexpr static uint32_t MaxDepth = 50;
+void Tracer::AddRayCounts(const RayCounts& rays) {
+	uint64_t total = rays.Shadow;
+	for (uint32_t bounce = 0; bounce < BounceStatCount; ++bounce) {
+		_bounceRaycasts[bounce].fetch_add(rays.Bounces[bounce], std::memory_order_relaxed);
+		total += rays.Bounces[bounce];
+	}
+	_totalRaycasts.fetch_add(total, std::memory_order_acq_rel);
+}
 
-	if (depth >= MaxDepth) { return Color(0.0); }
-	++raycasts;
+void Tracer::RenderTilePreview(const RenderTile& tile, uint32_t scale, RayCounts& rays) {
+	// Trace one pixel out of every scale x scale block and stretch it over the whole block. Only the displayed image
+	// is written, so the first real sample still starts from a clean slate. The pixel is traced with the first sample's
+	// random numbers, so it looks exactly like it will once the full resolution pass gets to it.
+	for (uint32_t blockY = tile.Min.y; blockY < tile.Max.y; blockY += scale) {
+		for (uint32_t blockX = tile.Min.x; blockX < tile.Max.x; blockX += scale) {
+			const glm::uvec2 blockMax = glm::min(glm::uvec2(blockX, blockY) + scale, tile.Max);
+			const glm::uvec2 center   = (glm::uvec2(blockX, blockY) + blockMax) / 2u;
+			const Color color         = Sample(center, 0, _imageSize, _camera, *_world, _maxDepth, rays);
+			for (uint32_t y = blockY; y < blockMax.y; ++y) {
+				for (uint32_t x = blockX; x < blockMax.x; ++x) { _avgPixels(x, y) = glm::vec4(color, 0.0f); }
+			}
+		}
+	}
+}
+
+bool Tracer::AcquireTask(uint32_t threadIndex, uint64_t& outTask) {
+	while (_running) {
+		// Someone is waiting on a ParallelFor, which comes before any rendering.
+		if (_pendingJobs > 0 && RunJob()) { continue; }
+
+		if (_scheduler == TraceScheduler::WorkStealing) {
+			if (PopTask(threadIndex, outTask) || StealTask(threadIndex, outTask)) { return true; }
+		}
+
+		std::unique_lock<std::mutex> lock(_tasksMutex);
+		if (!_tasks.empty()) {
+			outTask = _tasks.front();
+			_tasks.pop();
+			++_runningTasks;
+
+			return true;
+		}
+
+		// Nothing left anywhere, so go to sleep until someone pushes more work. The sleeping counter lets PushTask skip
+		// the global mutex entirely while every thread is busy.
+		++_sleepingThreads;
+		_tasksCondition.wait(
+			lock, [this]() { return !_running || !_tasks.empty() || _pendingTasks > 0 || _pendingJobs > 0; });
+		--_sleepingThreads;
+	}
+
+	return false;
+}
 
+float Tracer::UpdateTileError(const RenderTile& tile, uint32_t tileIndex, uint32_t sampleCount) {
+	if (sampleCount < 2) { return std::numeric_limits<float>::infinity(); }
+
+	// Estimate the standard error of each pixel's mean from its running variance, then scale it by the derivative of
+	// the display gamma so dark and bright regions are judged by how visible their noise actually is.
+	const float varianceScale = 1.0f / (float(sampleCount - 1) * float(sampleCount));
+	double errorSum           = 0.0;
+	for (uint32_t y = tile.Min.y; y < tile.Max.y; ++y) {
+		for (uint32_t x = tile.Min.x; x < tile.Max.x; ++x) {
+			const float mean = Luminance(Color(_avgPixels(x, y)));
+			const float m2   = _pixels(x, y).a;  // The only place the sum's alpha is read.
+			errorSum += std::sqrt(m2 * varianceScale) / (2.0f * std::sqrt(std::max(mean, 1e-4f)));
+		}
+	}
+	const float error = static_cast<float>(errorSum / ((tile.Max.x - tile.Min.x) * (tile.Max.y - tile.Min.y)));
+	_tileErrors[tileIndex].store(error, std::memory_order_relaxed);
+
+	return error;
+}
+
+bool Tracer::ContinueTile(const RenderTile& tile, uint32_t tileIndex, uint32_t sampleCount) {
+	const float error = UpdateTileError(tile, tileIndex, sampleCount);
+	if (_errorThreshold <= 0.0f) { return sampleCount < _samplesPerPixel; }
+
+	// Budgets are counted in pixel samples, since tiles along the image edges may be smaller than the rest.
+	const int64_t tilePixels = int64_t(tile.Max.x - tile.Min.x) * int64_t(tile.Max.y - tile.Min.y);
+	if (sampleCount >= std::min(AdaptiveMinSamples, _samplesPerPixel) && error <= _errorThreshold) {
+		if (sampleCount < _samplesPerPixel) { SampleBudget() += int64_t(_samplesPerPixel - sampleCount) * tilePixels; }
+		return false;
+	}
+	if (sampleCount < _samplesPerPixel) { return true; }
+	if (sampleCount >= _samplesPerPixel * AdaptiveMaxSampleFactor) { return false; }
+
+	// This tile has used up its own samples but is still noisy, so borrow from the tiles that converged early.
+	int64_t budget = SampleBudget().load(std::memory_order_relaxed);
+	while (budget >= tilePixels) {
+		if (SampleBudget().compare_exchange_weak(budget, budget - tilePixels, std::memory_order_relaxed)) { return true; }
+	}
+
+	return false;
+}
+
+void Tracer::PushTask(uint32_t threadIndex, uint64_t task) {
+	// A task may have seen the trace still rendering just before a cancel, so check again under the queue's lock, which
+	// the cancel also takes to clear it. A dropped task is the same as one that was cleared.
+	if (_scheduler == TraceScheduler::SharedQueue) {
+		std::lock_guard<std::mutex> lock(_tasksMutex);
+		if (!_rendering) { return; }
+		_tasks.push(task);
+		_tasksCondition.notify_one();
+
+		return;
+	}
+
+	{
+		auto& queue = *_workQueues[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (!_rendering) { return; }
+		queue.Tasks.push_back(task);
+		++_pendingTasks;
+	}
+	if (_sleepingThreads > 0) {
+		std::lock_guard<std::mutex> lock(_tasksMutex);
+		_tasksCondition.notify_one();
+	}
+}
+
+bool Tracer::PopTask(uint32_t threadIndex, uint64_t& outTask) {
+	// Threads take their own work from the front, so each tile's samples are spread out over time and the image
+	// refines evenly instead of finishing one tile at a time.
+	auto& queue = *_workQueues[threadIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty()) { return false; }
+
+	outTask = queue.Tasks.front();
+	queue.Tasks.pop_front();
+	--_pendingTasks;
+	++_runningTasks;
+
+	return true;
+}
+
+bool Tracer::StealTask(uint32_t threadIndex, uint64_t& outTask) {
+	// Thieves take from the back of the victim's queue, away from where the owner is working.
+	const uint32_t queueCount = static_cast<uint32_t>(_workQueues.size());
+	for (uint32_t i = 1; i < queueCount; ++i) {
+		auto& queue = *_workQueues[(threadIndex + i) % queueCount];
+		std::unique_lock<std::mutex> lock(queue.Mutex, std::try_to_lock);
+		if (!lock.owns_lock() || queue.Tasks.empty()) { continue; }
+
+		outTask = queue.Tasks.back();
+		queue.Tasks.pop_back();
+		--_pendingTasks;
+		++_runningTasks;
+		_stolenTasks.fetch_add(1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	return false;
+}
+
+void Tracer::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) {
+	if (count == 0) { return; }
+	if (count == 1 || _renderThreads.empty()) {
+		for (uint32_t i = 0; i < count; ++i) { func(i); }
+		return;
+	}
+
+	JobBatch batch;
+	batch.Func  = &func;
+	batch.Count = count;
+	{
+		std::lock_guard<std::mutex> lock(_tasksMutex);
+		_jobBatches.push_back(&batch);
+		_pendingJobs += count;
+	}
+	_tasksCondition.notify_all();
+
+	while (RunJob(&batch)) {}
+
+	{
+		std::unique_lock<std::mutex> lock(_tasksMutex);
+		_jobsCondition.wait(lock, [&batch]() { return batch.Done == batch.Count; });
+		_jobBatches.erase(std::find(_jobBatches.begin(), _jobBatches.end(), &batch));
+	}
+
+	if (batch.Exception) { std::rethrow_exception(batch.Exception); }
+}
+
+bool Tracer::RunJob(JobBatch* onlyBatch) {
+	JobBatch* batch = nullptr;
+	uint32_t item   = 0;
+	{
+		std::lock_guard<std::mutex> lock(_tasksMutex);
+		for (auto* candidate : _jobBatches) {
+			if ((onlyBatch && candidate != onlyBatch) || candidate->Next == candidate->Count) { continue; }
+			batch = candidate;
+			item  = batch->Next++;
+			--_pendingJobs;
+			break;
+		}
+	}
+	if (!batch) { return false; }
+
+	// Exceptions must not escape a render thread, and the thread that owns the batch must not unwind while other
+	// threads are still using it, so they are handed over once every item is done.
+	try {
+		(*batch->Func)(item);
+	} catch (...) {
+		std::lock_guard<std::mutex> lock(batch->ExceptionMutex);
+		if (!batch->Exception) { batch->Exception = std::current_exception(); }
+	}
+
+	// The batch may be gone as soon as the last item is marked done, so only the condition is touched after that. That
+	// includes the count, which is read before marking our item done.
+	const uint32_t count = batch->Count;
+	if (batch->Done.fetch_add(1) + 1 == count) {
+		std::lock_guard<std::mutex> lock(_tasksMutex);
+		_jobsCondition.notify_all();
+	}
+
+	return true;
+}
+
+void Tracer::FinishTask() {
+	// CancelTrace sleeps until the last running task is done.
+	if (--_runningTasks == 0) { _runningTasks.notify_all(); }
+}
+
+void Tracer::ClearTasks() {
+	while (!_tasks.empty()) { _tasks.pop(); }
+	for (auto& queue : _workQueues) {
+		std::lock_guard<std::mutex> lock(queue->Mutex);
+		_pendingTasks -= queue->Tasks.size();
+		queue->Tasks.clear();
+	}
+}
+
+Ray Tracer::CameraRay(const glm::uvec2& coords, uint32_t sample, const glm::uvec2& imageSize, const Camera& camera) {
+	// Every pixel sample gets its own random stream, so the image does not depend on which thread traced which tile.
+	ThreadSampler().Start(coords.y * imageSize.x + coords.x, sample);
+
+	double jitter[2];
+	ThreadSampler().NextDoubles(jitter, 2);
+	const auto s = (double(coords.x) + jitter[0]) / (imageSize.x - 1);
+	const auto t = 1.0 - ((double(coords.y) + jitter[1]) / (imageSize.y - 1));
+
+	return camera.GetRay(s, t);
+}
+
+Color Tracer::Sample(const glm::uvec2& coords,
+                     uint32_t sample,
+                     const glm::uvec2& imageSize,
+                     const Camera& camera,
+                     const World& world,
+                     uint32_t maxDepth,
+                     RayCounts& rays) {
+	return TracePath(CameraRay(coords, sample, imageSize, camera), world, maxDepth, rays);
+}
+
+void Tracer::SamplePacket(const glm::uvec2& coords,
+                          uint32_t laneCount,
+                          uint32_t sample,
+                          const glm::uvec2& imageSize,
+                          const Camera& camera,
+                          const World& world,
+                          uint32_t maxDepth,
+                          RayCounts& rays,
+                          std::array<Color, PacketWidth>& outColors) {
+	// Partial packets at the edge of a tile repeat their last pixel, and the extra lanes are ignored.
+	std::array<Ray, PacketWidth> cameraRays;
+	for (uint32_t lane = 0; lane < PacketWidth; ++lane) {
+		cameraRays[lane] =
+			CameraRay(glm::uvec2(coords.x + std::min(lane, laneCount - 1), coords.y), sample, imageSize, camera);
+	}
+
+	std::array<HitRecord, PacketWidth> hits;
+	const uint32_t hitMask = world.BVH->HitPacket(cameraRays, MinHitDistance, hits);
+	rays.AddBounce(0, laneCount);
+
+	for (uint32_t lane = 0; lane < laneCount; ++lane) {
+		if (hitMask & (1u << lane)) {
+			ThreadSampler().Start(coords.y * imageSize.x + coords.x + lane, sample);
+			outColors[lane] = TracePath(cameraRays[lane], world, maxDepth, rays, &hits[lane]);
+		} else {
+			outColors[lane] = world.Sky->Sample(cameraRays[lane]);
+		}
+	}
+}
+
+Color Tracer::TracePath(Ray ray, const World& world, uint32_t maxDepth, RayCounts& rays, const HitRecord* firstHit) {
+	Color radiance(0.0f);
+	Color throughput(1.0f);
+	Real scatterPdf = 0.0;
 	HitRecord hit;
-	if (world.BVH->Hit(ray, 0.001, Infinity, hit)) {
-		Color attenuation;
-		Ray scattered;
-		const Color emission = hit.Material->Emit(hit.UV, hit.Point);
-		if (hit.Material->Scatter(ray, hit, attenuation, scattered)) {
-			return emission + attenuation * CastRay(scattered, world, raycasts, depth + 1);
+	for (uint32_t depth = 0; depth < maxDepth; ++depth) {
+		if (depth == 0 && firstHit) {
+			hit = *firstHit;
 		} else {
-			return emission;
+			rays.AddBounce(depth);
+			if (!world.BVH->Hit(ray, MinHitDistance, Infinity, hit)) {
+				radiance += throughput * world.Sky->Sample(ray) * SkyWeight(ray, world, scatterPdf);
+				break;
+			}
 		}
-	} else {
-		return world.Sky->Sample(ray);
+
+		ThreadSampler().SetDimension(CameraDimensions + depth * BounceDimensions);
+		const IMaterial& material = *hit.Material;
+		const Color emission      = material.Emit(hit.UV, hit.Point);
+		if (Luminance(emission) > 0.0f) {
+			radiance += throughput * emission * EmissionWeight(ray, hit, world, scatterPdf);
+		}
+
+		// Light is sampled even if scattering fails, as glossy materials can pick directions below the surface, and the
+		// paths that end that way still see the light.
+		ScatterRecord scatter;
+		const bool scattered = material.Scatter(ray, hit, scatter);
+		const bool specular  = material.IsSpecular();
+		if (!specular) { radiance += throughput * SampleLights(material, ray, hit, world, depth, rays); }
+		if (!scattered) { break; }
+		scatterPdf  = specular ? 0.0 : scatter.Pdf;
+		throughput *= scatter.Attenuation;
+		if (!ContinuePath(throughput, depth)) { break; }
+		ray = scatter.Scattered;
+	}
+
+	return radiance;
+}
+
+float Tracer::EmissionWeight(const Ray& ray, const HitRecord& hit, const World& world, Real scatterPdf) {
+	if (scatterPdf <= 0.0) { return 1.0f; }
+	const Real lightPdf = world.Emitters.Pdf(ray.Origin, hit);
+
+	return float(PowerHeuristic(scatterPdf, lightPdf));
+}
+
+float Tracer::SkyWeight(const Ray& ray, const World& world, Real scatterPdf) {
+	if (scatterPdf <= 0.0) { return 1.0f; }
+
+	return float(PowerHeuristic(scatterPdf, world.Emitters.GetSkyPdf(ray.Direction)));
+}
+
+template <typename T>
+Color Tracer::SampleLights(
+	const T& material, const Ray& ray, const HitRecord& hit, const World& world, uint32_t depth, RayCounts& rays) {
+	if (world.Emitters.Empty()) { return Color(0.0f); }
+
+	double u[4];
+	ThreadSampler().SetDimension(CameraDimensions + depth * BounceDimensions + LightDimension);
+	ThreadSampler().NextDoubles(u, 4);
+	LightSample light;
+	if (!world.Emitters.Sample(hit.Point, u, light)) { return Color(0.0f); }
+
+	const Color f = material.Eval(ray, hit, light.Direction);
+	if (Luminance(f) <= 0.0f || Luminance(light.Radiance) <= 0.0f) { return Color(0.0f); }
+
+	++rays.Shadow;
+	const Ray shadow = hit.SpawnRay(light.Direction);
+	if (world.BVH->Occluded(shadow, MinHitDistance, light.Distance * (1 - ShadowEpsilon))) { return Color(0.0f); }
+
+	const Real weight = PowerHeuristic(light.Pdf, material.Pdf(ray, hit, light.Direction));
+
+	return f * light.Radiance * float(weight / light.Pdf);
+}
+
+bool Tracer::ContinuePath(Color& throughput, uint32_t depth) {
+	if (depth + 1 < RouletteDepth) { return true; }
+
+	const float survival = std::min(std::max(throughput.r, std::max(throughput.g, throughput.b)), 1.0f);
+	if (survival >= 1.0f) { return true; }
+
+	ThreadSampler().SetDimension(CameraDimensions + depth * BounceDimensions + RouletteDimension);
+	if (!(ThreadSampler().NextFloat() < survival)) { return false; }
+	throughput /= survival;
+
+	return true;
+}
+
+void Tracer::WavefrontQueue::Resize(size_t pathCount) {
+	if (Origins.size() >= pathCount) { return; }
+
+	Origins.resize(pathCount);
+	Directions.resize(pathCount);
+	Throughputs.resize(pathCount);
+	ScatterPdfs.resize(pathCount);
+	Pixels.resize(pathCount);
+	ImagePixels.resize(pathCount);
+	Hits.resize(pathCount);
+	Alive.resize(pathCount);
+	ShadeOrder.resize(pathCount);
+	Radiance.resize(pathCount);
+}
+
+template <typename T>
+void Tracer::ShadeWavefront(WavefrontQueue& queue,
+                            const World& world,
+                            uint32_t sample,
+                            uint32_t depth,
+                            uint32_t first,
+                            uint32_t count,
+                            RayCounts& rays) {
+	// The built-in materials are final, so calling through the concrete type lets the compiler skip the vtable and
+	// every path in the batch runs through the same code.
+	for (uint32_t i = first; i < first + count; ++i) {
+		const uint32_t path  = queue.ShadeOrder[i];
+		const HitRecord& hit = queue.Hits[path];
+		const T& material    = static_cast<const T&>(*hit.Material);
+		const Ray ray(queue.Origins[path], queue.Directions[path]);
+		Color& throughput = queue.Throughputs[path];
+		Color& radiance   = queue.Radiance[queue.Pixels[path]];
+		ThreadSampler().Start(queue.ImagePixels[path], sample, CameraDimensions + depth * BounceDimensions);
+
+		const Color emission = material.Emit(hit.UV, hit.Point);
+		if (Luminance(emission) > 0.0f) {
+			radiance += throughput * emission * EmissionWeight(ray, hit, world, queue.ScatterPdfs[path]);
+		}
+
+		ScatterRecord scatter;
+		const bool scattered = material.Scatter(ray, hit, scatter);
+		const bool specular  = material.IsSpecular();
+		if (!specular) { radiance += throughput * SampleLights(material, ray, hit, world, depth, rays); }
+		if (scattered) {
+			queue.ScatterPdfs[path]  = specular ? 0.0 : scatter.Pdf;
+			throughput              *= scatter.Attenuation;
+			queue.Alive[path]        = ContinuePath(throughput, depth);
+			queue.Origins[path]      = scatter.Scattered.Origin;
+			queue.Directions[path]   = scatter.Scattered.Direction;
+		} else {
+			queue.Alive[path] = 0;
+		}
+	}
+}
+
+void Tracer::RenderTileWavefront(WavefrontQueue& queue,
+                                 const RenderTile& tile,
+                                 uint32_t sample,
+                                 RayCounts& rays) const {
+	const World& world       = *_world;
+	const uint32_t tileWidth = tile.Max.x - tile.Min.x;
+	const uint32_t pathCount = tileWidth * (tile.Max.y - tile.Min.y);
+	queue.Resize(pathCount);
+
+	// Generate one camera ray for every pixel in the tile.
+	for (uint32_t y = tile.Min.y; y < tile.Max.y; ++y) {
+		for (uint32_t x = tile.Min.x; x < tile.Max.x; ++x) {
+			const uint32_t path     = (y - tile.Min.y) * tileWidth + (x - tile.Min.x);
+			const Ray ray           = CameraRay(glm::uvec2(x, y), sample, _imageSize, _camera);
+			queue.Origins[path]     = ray.Origin;
+			queue.Directions[path]  = ray.Direction;
+			queue.Throughputs[path] = Color(1.0);
+			queue.ScatterPdfs[path] = 0.0;
+			queue.Pixels[path]      = path;
+			queue.ImagePixels[path] = y * _imageSize.x + x;
+			queue.Radiance[path]    = Color(0.0);
+		}
+	}
+
+	uint32_t activePaths = pathCount;
+	for (uint32_t depth = 0; depth < _maxDepth && activePaths > 0; ++depth) {
+		// Intersect every active path with the world. Rays that escape pick up the sky and are retired here.
+		if (depth == 0 && _packetTracing) {
+			std::array<Ray, PacketWidth> rays;
+			std::array<HitRecord, PacketWidth> hits;
+			for (uint32_t first = 0; first < activePaths; first += PacketWidth) {
+				const uint32_t laneCount = std::min(PacketWidth, activePaths - first);
+				for (uint32_t lane = 0; lane < PacketWidth; ++lane) {
+					const uint32_t path = first + std::min(lane, laneCount - 1);
+					rays[lane]          = Ray(queue.Origins[path], queue.Directions[path]);
+				}
+				const uint32_t hitMask = world.BVH->HitPacket(rays, MinHitDistance, hits);
+				for (uint32_t lane = 0; lane < laneCount; ++lane) {
+					queue.Alive[first + lane] = (hitMask >> lane) & 1;
+					queue.Hits[first + lane]  = hits[lane];
+				}
+			}
+		} else {
+			for (uint32_t path = 0; path < activePaths; ++path) {
+				const Ray ray     = Ray(queue.Origins[path], queue.Directions[path]);
+				queue.Alive[path] = world.BVH->Hit(ray, MinHitDistance, Infinity, queue.Hits[path]);
+			}
+		}
+		rays.AddBounce(depth, activePaths);
+
+		// Counting sort the paths that hit something by material type, retiring the misses along the way.
+		std::array<uint32_t, size_t(MaterialType::Count) + 1> batchOffsets = {};
+		for (uint32_t path = 0; path < activePaths; ++path) {
+			if (queue.Alive[path]) {
+				++batchOffsets[size_t(queue.Hits[path].Material->GetType()) + 1];
+			} else {
+				const Ray ray = Ray(queue.Origins[path], queue.Directions[path]);
+				queue.Radiance[queue.Pixels[path]] += queue.Throughputs[path] * world.Sky->Sample(ray) *
+				                                      SkyWeight(ray, world, queue.ScatterPdfs[path]);
+			}
+		}
+		for (size_t i = 1; i < batchOffsets.size(); ++i) { batchOffsets[i] += batchOffsets[i - 1]; }
+		{
+			auto cursors = batchOffsets;
+			for (uint32_t path = 0; path < activePaths; ++path) {
+				if (queue.Alive[path]) {
+					queue.ShadeOrder[cursors[size_t(queue.Hits[path].Material->GetType())]++] = path;
+				}
+			}
+		}
+
+		// Shade each material's batch in one go.
+		const auto Batch = [&](MaterialType type, auto kernel) {
+			const uint32_t first = batchOffsets[size_t(type)];
+			const uint32_t count = batchOffsets[size_t(type) + 1] - first;
+			if (count > 0) { kernel(queue, world, sample, depth, first, count, rays); }
+		};
+		Batch(MaterialType::Lambertian, ShadeWavefront<LambertianMaterial>);
+		Batch(MaterialType::Metal, ShadeWavefront<MetalMaterial>);
+		Batch(MaterialType::Dielectric, ShadeWavefront<DielectricMaterial>);
+		Batch(MaterialType::DiffuseLight, ShadeWavefront<DiffuseLightMaterial>);
+		Batch(MaterialType::Generic, ShadeWavefront<IMaterial>);
+
+		// Compact the surviving paths to the front of the queue, keeping them in pixel order.
+		uint32_t survivors = 0;
+		for (uint32_t path = 0; path < activePaths; ++path) {
+			if (!queue.Alive[path]) { continue; }
+			if (path != survivors) {
+				queue.Origins[survivors]     = queue.Origins[path];
+				queue.Directions[survivors]  = queue.Directions[path];
+				queue.Throughputs[survivors] = queue.Throughputs[path];
+				queue.ScatterPdfs[survivors] = queue.ScatterPdfs[path];
+				queue.Pixels[survivors]      = queue.Pixels[path];
+				queue.ImagePixels[survivors] = queue.ImagePixels[path];
+			}
+			++survivors;
+		}
+		activePaths = survivors;
 	}
 }
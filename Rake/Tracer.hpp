@@ -1,25 +1,70 @@
 #pragma once
 
 #include <Luna/Utility/Time.hpp>
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <exception>
 #include <glm/glm.hpp>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
 #include <vector>
 
 #include "Camera.hpp"
+#include "Checkpoint.hpp"
 #include "DataTypes.hpp"
+#include "DisplayBuffer.hpp"
+#include "Framebuffer.hpp"
+#include "IHittable.hpp"
+#include "ITaskPool.hpp"
+#include "SIMD.hpp"
 
 class World;
 
-class Tracer {
+enum class TraceScheduler {
+	WorkStealing,  // Per-thread deques of 2D tiles, idle threads steal from busy ones.
+	SharedQueue    // Single locked queue of 10-line bands, kept for comparison.
+};
+
+enum class TraceIntegrator {
+	Recursive,  // Depth-first, following one path at a time to the end.
+	Wavefront   // Breadth-first over a whole tile, shading hits in batches sorted by material.
+};
+
+struct TraceSettings {
+	TraceScheduler Scheduler   = TraceScheduler::WorkStealing;
+	TraceIntegrator Integrator = TraceIntegrator::Recursive;
+	uint32_t MaxDepth          = 50;     // Most rays a path may take, counting the one from the camera.
+	uint32_t TileSize          = 0;      // Tile edge length in pixels, or 0 to pick one based on the image size.
+	bool PacketTracing         = false;  // Trace primary rays in SIMD packets of PacketWidth pixels.
+	float ErrorThreshold       = 0.0f;   // Stop sampling tiles once their estimated error drops below this, 0 to disable.
+	uint32_t PreviewLevels     = 0;      // Coarse passes at 1/2, 1/4, ... resolution to trace before the first sample.
+	bool Display               = false;  // Publish tiles as they change, for UpdateDisplay to show the trace live.
+	std::string CheckpointFile;          // Accumulate in this file, and resume the trace in it if there is one.
+};
+
+// The render threads double as a task pool for other parallel work, such as building BVHs. Those tasks take priority
+// over render tasks, so they are best kept short.
+class Tracer : public ITaskPool {
  public:
-	Tracer();
+	// Rays are counted per bounce up to this many bounces, and the ones past it are counted with the last.
+	static constexpr uint32_t BounceStatCount = 16;
+
+	// threadCount of 0 picks one based on the hardware, leaving a couple of cores free for the UI.
+	explicit Tracer(uint32_t threadCount = 0);
 	~Tracer() noexcept;
 
+	virtual uint32_t GetThreadCount() const override {
+		return static_cast<uint32_t>(_renderThreads.size()) + 1;
+	}
+	virtual void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) override;
+
 	uint32_t GetCompletedSamples() const {
 		if (_taskGroupCount == 0) { return 0; }
 
@@ -28,31 +73,198 @@ class Tracer {
 	Luna::Utility::Time GetElapsedTime() const {
 		return _renderTime.Get();
 	}
+	// Average number of samples actually taken per pixel, which differs from the requested count with adaptive sampling.
+	double GetAverageSamples() const {
+		if (_imageSize.x == 0 || _imageSize.y == 0) { return 0.0; }
+
+		return double(_pixelSamples) / (double(_imageSize.x) * double(_imageSize.y));
+	}
+	float GetError() const;
 	uint64_t GetRaycastCount() const {
 		return _totalRaycasts;
 	}
+	// Rays that paths took at a bounce, where bounce 0 is the camera ray. Shadow rays are not counted here.
+	uint64_t GetBounceRaycastCount(uint32_t bounce) const {
+		return _bounceRaycasts[std::min(bounce, BounceStatCount - 1)];
+	}
+	// Average number of rays each path took, counting the one from the camera.
+	double GetAveragePathLength() const;
+	// Render tasks that idle threads took from another thread's queue. Always 0 with the shared queue.
+	uint64_t GetStolenTaskCount() const {
+		return _stolenTasks;
+	}
 	bool IsRunning() const {
 		return _rendering;
 	}
 
-	bool StartTrace(const glm::uvec2& imageSize, uint32_t samplesPerPixel, const std::shared_ptr<World>& world);
+	bool StartTrace(const glm::uvec2& imageSize,
+	                uint32_t samplesPerPixel,
+	                const std::shared_ptr<World>& world,
+	                const TraceSettings& settings = {});
+	// Stops handing out render tasks and waits for the ones already running, so a new trace can start right away.
 	bool CancelTrace();
 	void Update();
+	// Copies the linear, accumulated image. Tiles may be mid-update while a trace is running, so this is mainly meant
+	// for finished traces.
 	bool UpdatePixels(std::vector<Color>& pixels);
+	// Copies the linear, accumulated image regardless of whether anything changed since the last call. This reads the
+	// image the render threads write to, so it must not be called while a trace is running.
+	void CopyPixels(std::vector<Color>& pixels) const;
+	// Copies the tiles that changed since the last call into a display image of the trace's size, gamma corrected, and
+	// their linear pixels into linearPixels if given, and returns the range of rows that were touched. Only traces started
+	// with Display set publish any tiles. Safe to call at any time from the thread that starts traces.
+	bool UpdateDisplay(Color* pixels, Color* linearPixels, uint32_t& outFirstRow, uint32_t& outLastRow) {
+		return _display.Consume(pixels, linearPixels, outFirstRow, outLastRow);
+	}
 
  private:
-	void RenderThread(int threadID);
+	using RenderTile = DisplayBuffer::Tile;
+
+	struct alignas(64) WorkQueue {
+		std::mutex Mutex;
+		std::deque<uint64_t> Tasks;
+	};
+
+	// A ParallelFor in progress. Items are handed out under _tasksMutex, but finish without it.
+	struct JobBatch {
+		const std::function<void(uint32_t)>* Func = nullptr;
+		uint32_t Count                            = 0;
+		uint32_t Next                             = 0;
+		std::atomic_uint32_t Done                 = 0;
+		std::exception_ptr Exception;
+		std::mutex ExceptionMutex;
+	};
 
+	// Rays traced by a render task, added to the totals once the task is done.
+	struct RayCounts {
+		std::array<uint64_t, BounceStatCount> Bounces = {};
+		uint64_t Shadow                               = 0;
+
+		void AddBounce(uint32_t bounce, uint64_t count = 1) {
+			Bounces[std::min(bounce, BounceStatCount - 1)] += count;
+		}
+	};
+
+	// Path state for the wavefront integrator, one array per field. Each render thread owns one for its whole lifetime,
+	// and it only ever grows, so rendering a tile does not allocate.
+	struct WavefrontQueue {
+		std::vector<Point3> Origins;
+		std::vector<Vector3> Directions;
+		std::vector<Color> Throughputs;
+		std::vector<Real> ScatterPdfs;  // Density each ray was scattered with, see TracePath.
+		std::vector<uint32_t> Pixels;       // Index into Radiance of the tile pixel each path contributes to.
+		std::vector<uint32_t> ImagePixels;  // Index of that pixel within the whole image, used to seed the sampler.
+		std::vector<HitRecord> Hits;
+		std::vector<uint8_t> Alive;
+		std::vector<uint32_t> ShadeOrder;  // Indices of the paths that hit something, grouped by material type.
+		std::vector<Color> Radiance;
+
+		void Resize(size_t pathCount);
+	};
+
+	void RenderThread(uint32_t threadIndex);
+	bool AcquireTask(uint32_t threadIndex, uint64_t& outTask);
+	void PushTask(uint32_t threadIndex, uint64_t task);
+	bool PopTask(uint32_t threadIndex, uint64_t& outTask);
+	bool StealTask(uint32_t threadIndex, uint64_t& outTask);
+	void FinishTask();
+	void ClearTasks();
+	bool RunJob(JobBatch* onlyBatch = nullptr);
+	float UpdateTileError(const RenderTile& tile, uint32_t tileIndex, uint32_t sampleCount);
+	bool ContinueTile(const RenderTile& tile, uint32_t tileIndex, uint32_t sampleCount);
+	void RenderTileWavefront(WavefrontQueue& queue, const RenderTile& tile, uint32_t sample, RayCounts& rays) const;
+	void RenderTilePreview(const RenderTile& tile, uint32_t scale, RayCounts& rays);
+	bool ResumeTile(uint32_t tileIndex, uint32_t& outPass);
+	void AccumulateTile(const RenderTile& tile, uint32_t sample, const Color* radiance);
+	void PublishTile(const RenderTile& tile, uint32_t tileIndex);
+	void AddRayCounts(const RayCounts& rays);
+
+	std::atomic_ref<int64_t> SampleBudget() const {
+		return std::atomic_ref<int64_t>(*_sampleBudget);
+	}
+
+	static Ray CameraRay(const glm::uvec2& coords, uint32_t sample, const glm::uvec2& imageSize, const Camera& camera);
 	static Color Sample(const glm::uvec2& coords,
+	                    uint32_t sample,
 	                    const glm::uvec2& imageSize,
 	                    const Camera& camera,
 	                    const World& world,
-	                    uint64_t& raycasts);
-	static Color CastRay(const Ray& ray, const World& world, uint64_t& raycasts, uint32_t depth);
+	                    uint32_t maxDepth,
+	                    RayCounts& rays);
+	static void SamplePacket(const glm::uvec2& coords,
+	                         uint32_t laneCount,
+	                         uint32_t sample,
+	                         const glm::uvec2& imageSize,
+	                         const Camera& camera,
+	                         const World& world,
+	                         uint32_t maxDepth,
+	                         RayCounts& rays,
+	                         std::array<Color, PacketWidth>& outColors);
+	// Follows a path from the camera ray until it escapes, is absorbed, runs out of depth or loses at Russian roulette.
+	// If firstHit is given, the camera ray was already traced, in a packet, and is known to hit it.
+	static Color TracePath(
+		Ray ray, const World& world, uint32_t maxDepth, RayCounts& rays, const HitRecord* firstHit = nullptr);
+	// scatterPdf is the density with which a ray was scattered, or 0 if it came from the camera or a specular bounce,
+	// and weighs the light the ray finds against next-event estimation.
+	static float EmissionWeight(const Ray& ray, const HitRecord& hit, const World& world, Real scatterPdf);
+	static float SkyWeight(const Ray& ray, const World& world, Real scatterPdf);
+	// Next-event estimation: the light reaching a hit straight from one of the world's emitters or the sky, weighed
+	// against finding the same light by scattering with multiple importance sampling.
+	template <typename T>
+	static Color SampleLights(
+		const T& material, const Ray& ray, const HitRecord& hit, const World& world, uint32_t depth, RayCounts& rays);
+	// Russian roulette, once a path is RouletteDepth rays long: the path carries on with odds of its throughput, and
+	// makes up for the ones that stopped by carrying that much more light. Returns false if the path stops.
+	static bool ContinuePath(Color& throughput, uint32_t depth);
+	template <typename T>
+	static void ShadeWavefront(WavefrontQueue& queue,
+	                           const World& world,
+	                           uint32_t sample,
+	                           uint32_t depth,
+	                           uint32_t first,
+	                           uint32_t count,
+	                           RayCounts& rays);
+
+	// Paths shorter than this are never stopped by Russian roulette, as the first few bounces carry most of the light.
+	static constexpr uint32_t RouletteDepth = 3;
+
+	// Secondary rays are offset off the surface they leave (see OffsetRayOrigin), so hits only need to be in front of
+	// the ray origin rather than some arbitrary distance away from it.
+	static constexpr Real MinHitDistance = 0;
+
+	// Sampler dimensions used by the camera ray, and reserved for each bounce after it. Every bounce starts at a fixed
+	// dimension, so both integrators consume exactly the same random numbers for a given path.
+	// Within a bounce, scattering takes dimensions from the start, Russian roulette takes RouletteDimension and light
+	// sampling takes LightDimension on. That leaves IMaterial::Scatter only 3 dimensions; more would take roulette's.
+	static constexpr uint32_t CameraDimensions  = 4;
+	static constexpr uint32_t BounceDimensions  = 8;
+	static constexpr uint32_t RouletteDimension = 3;
+	static constexpr uint32_t LightDimension    = 4;
+
+	// Shadow rays stop this fraction of the distance short of the light, so they do not find the light itself.
+	static constexpr Real ShadowEpsilon = 1e-3;
+
+	// Tiles take at least this many samples before adaptive sampling trusts their error estimate.
+	static constexpr uint32_t AdaptiveMinSamples = 16;
+
+	// Noisy tiles may take up to this many times the requested samples, using the budget freed up by converged tiles.
+	static constexpr uint32_t AdaptiveMaxSampleFactor = 4;
+
+	// Coarsest preview pass traces one pixel out of every 2^MaxPreviewLevels squared.
+	static constexpr uint32_t MaxPreviewLevels = 4;
+
+	// How often a checkpoint is written out to disk. The process dying loses nothing either way, as the file is mapped,
+	// so this only bounds how much a crash of the whole machine costs.
+	static constexpr std::chrono::seconds CheckpointInterval = std::chrono::seconds(60);
 
 	glm::uvec2 _imageSize = glm::uvec2(0);
-	std::vector<Color> _pixels;
-	std::vector<Color> _avgPixels;
+	// Sum of every sample taken for each pixel. Alpha holds the running sum of squared luminance deviations instead
+	// (Welford's M2), which adaptive sampling estimates the error from. It is not opacity, and is never displayed or
+	// exported; those read _avgPixels, whose alpha is always 0.
+	Framebuffer _pixels;
+	Framebuffer _avgPixels;
+	Checkpoint _checkpoint;  // Holds both framebuffers' pixels while open.
+	std::chrono::steady_clock::time_point _nextCheckpointFlush;
 	std::atomic_bool _rendering = false;
 	std::atomic_bool _running   = false;
 	std::vector<std::thread> _renderThreads;
@@ -61,13 +273,39 @@ class Tracer {
 	std::shared_ptr<World> _world;
 
 	std::atomic_uint64_t _completedSamples;
+	std::atomic_uint64_t _completedPreviews;
 	std::atomic_uint64_t _totalRaycasts;
-	uint32_t _taskGroupCount    = 0;
-	uint64_t _neededSamples     = 0;
-	uint64_t _lastUpdatedSample = 0;
+	std::array<std::atomic_uint64_t, BounceStatCount> _bounceRaycasts;
+	std::atomic_uint64_t _pixelSamples;
+	std::atomic_uint32_t _activeTiles;
+	// Pixel samples given up by tiles that converged early, for noisy tiles to take. Kept in the checkpoint while there
+	// is one, so a resumed trace picks up the budget along with the tiles.
+	int64_t* _sampleBudget = &_localSampleBudget;
+	alignas(std::atomic_ref<int64_t>::required_alignment) int64_t _localSampleBudget = 0;
+	uint32_t _taskGroupCount     = 0;
+	uint64_t _lastUpdatedSample  = 0;
+	uint64_t _lastUpdatedPreview = 0;
+	float _errorThreshold        = 0.0f;
+	TraceScheduler _scheduler    = TraceScheduler::WorkStealing;
+	TraceIntegrator _integrator  = TraceIntegrator::Recursive;
+	uint32_t _maxDepth           = 50;
+	bool _packetTracing          = false;
+	uint32_t _previewLevels      = 0;
+	bool _displayEnabled         = false;
+	std::vector<RenderTile> _tiles;
+	DisplayBuffer _display;
+	std::vector<std::atomic<float>> _tileErrors;
+	std::vector<std::unique_ptr<WorkQueue>> _workQueues;
+	std::atomic_uint64_t _pendingTasks    = 0;
+	std::atomic_uint32_t _runningTasks    = 0;  // Taken from a queue but not finished yet.
+	std::atomic_uint64_t _stolenTasks     = 0;
+	std::atomic_uint32_t _sleepingThreads = 0;
 	std::queue<uint64_t> _tasks;
 	std::mutex _tasksMutex;
 	std::condition_variable _tasksCondition;
+	std::vector<JobBatch*> _jobBatches;  // Guarded by _tasksMutex.
+	std::atomic_uint32_t _pendingJobs = 0;
+	std::condition_variable _jobsCondition;
 
 	Luna::Utility::Stopwatch _renderTime;
 };
@@ -0,0 +1,171 @@
+#include "TriangleMesh.hpp"
+
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "IMaterial.hpp"
+
+TriangleMesh::RayTransform::RayTransform(const Ray& ray) : Origin(ray.Origin) {
+	// Make the largest component of the direction our z axis, and swap x and y if that would flip the winding.
+	const Vector3 absDirection = glm::abs(ray.Direction);
+	Kz = absDirection.x > absDirection.y ? (absDirection.x > absDirection.z ? 0 : 2)
+	                                     : (absDirection.y > absDirection.z ? 1 : 2);
+	Kx = (Kz + 1) % 3;
+	Ky = (Kx + 1) % 3;
+	if (ray.Direction[Kz] < 0) { std::swap(Kx, Ky); }
+
+	Sx = ray.Direction[Kx] / ray.Direction[Kz];
+	Sy = ray.Direction[Ky] / ray.Direction[Kz];
+	Sz = Real(1) / ray.Direction[Kz];
+}
+
+TriangleMesh::TriangleMesh(const std::shared_ptr<const MeshData>& mesh,
+                           const std::shared_ptr<IMaterial>& material,
+                           ITaskPool* taskPool)
+		: Mesh(mesh), Material(material) {
+	if (!Mesh || Mesh->GetTriangleCount() == 0) {
+		throw std::runtime_error("Cannot construct a triangle mesh with 0 triangles!");
+	}
+
+	const size_t triangleCount = Mesh->GetTriangleCount();
+	std::vector<AABB> bounds(triangleCount);
+	for (size_t i = 0; i < triangleCount; ++i) {
+		const uint32_t* indices = &Mesh->PositionIndices[i * 3];
+		bounds[i]               = AABB()
+		              .Contain(Mesh->GetPosition(indices[0]))
+		              .Contain(Mesh->GetPosition(indices[1]))
+		              .Contain(Mesh->GetPosition(indices[2]));
+	}
+	// Meshes never move, so only the quantized wide tree is kept once it is collapsed.
+	LinearBVH bvh;
+	bvh.Build(bounds, taskPool);
+	_triangles = bvh.GetPrimitiveIndices();
+	_bvh.Build(bvh.GetNodes(), true);
+
+	// The mesh data never changes, and is often shared by thousands of instances, so it is only hashed once.
+	Luna::Utility::Hasher hasher;
+	const auto HashArray = [&hasher](const auto& values) {
+		hasher(values.size());
+		hasher.Data(values.size() * sizeof(values[0]), values.data());
+	};
+	for (const auto& values : Mesh->Positions) { HashArray(values); }
+	for (const auto& values : Mesh->Normals) { HashArray(values); }
+	for (const auto& values : Mesh->UVs) { HashArray(values); }
+	HashArray(Mesh->PositionIndices);
+	HashArray(Mesh->NormalIndices);
+	HashArray(Mesh->UVIndices);
+	_meshHash = hasher.Get();
+}
+
+bool TriangleMesh::Bounds(AABB& outBounds) const {
+	outBounds = _bvh.GetBounds();
+
+	return true;
+}
+
+bool TriangleMesh::Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const {
+	const RayTransform transform(ray);
+	uint32_t closestTriangle = 0;
+	Real closestDistance     = tMax;
+	Vector3 barycentrics;
+
+	const bool hit = _bvh.Intersect(ray, tMin, tMax, [&](uint32_t first, uint32_t count, Real& closest) {
+		bool hitAnything = false;
+		for (uint32_t i = first; i < first + count; ++i) {
+			Real distance;
+			if (IntersectTriangle(transform, _triangles[i], tMin, closest, distance, barycentrics)) {
+				hitAnything     = true;
+				closest         = distance;
+				closestDistance = distance;
+				closestTriangle = _triangles[i];
+			}
+		}
+
+		return hitAnything;
+	});
+	if (!hit) { return false; }
+
+	// Only the closest triangle gets its surface attributes interpolated.
+	const uint32_t* positions = &Mesh->PositionIndices[closestTriangle * 3];
+	const Point3 p0           = Mesh->GetPosition(positions[0]);
+	const Point3 p1           = Mesh->GetPosition(positions[1]);
+	const Point3 p2           = Mesh->GetPosition(positions[2]);
+	outRecord.Distance        = closestDistance;
+	outRecord.Point           = barycentrics.x * p0 + barycentrics.y * p1 + barycentrics.z * p2;
+	outRecord.SetFaceNormal(ray, glm::normalize(glm::cross(p1 - p0, p2 - p0)));
+
+	if (Mesh->HasNormals()) {
+		// Shading normals only bend the normal, the geometry still decides which side of the surface we are on.
+		const uint32_t* normals = &Mesh->NormalIndices[closestTriangle * 3];
+		const Vector3 normal    = glm::normalize(barycentrics.x * Mesh->GetNormal(normals[0]) +
+                                          barycentrics.y * Mesh->GetNormal(normals[1]) +
+                                          barycentrics.z * Mesh->GetNormal(normals[2]));
+		outRecord.Normal        = glm::dot(normal, outRecord.Normal) < 0 ? -normal : normal;
+	}
+
+	if (Mesh->HasUVs()) {
+		const uint32_t* uvs = &Mesh->UVIndices[closestTriangle * 3];
+		outRecord.UV = barycentrics.x * Mesh->GetUV(uvs[0]) + barycentrics.y * Mesh->GetUV(uvs[1]) +
+		               barycentrics.z * Mesh->GetUV(uvs[2]);
+	} else {
+		outRecord.UV = Point2(barycentrics.y, barycentrics.z);
+	}
+
+	outRecord.Material = Material.get();
+
+	return true;
+}
+
+// Watertight ray/triangle intersection (Woop, Benthin and Wald, "Watertight Ray/Triangle Intersection", JCGT 2013).
+// The triangle is transformed into a space where the ray starts at the origin and points down +z, which turns the
+// inside test into three 2D edge functions. Triangles sharing an edge evaluate that edge identically, so a ray can
+// never slip through the crack between them.
+bool TriangleMesh::IntersectTriangle(
+	const RayTransform& ray, uint32_t triangle, Real tMin, Real tMax, Real& outT, Vector3& outBarycentrics) const {
+	const uint32_t* indices = &Mesh->PositionIndices[triangle * 3];
+	const Vector3 a         = Mesh->GetPosition(indices[0]) - ray.Origin;
+	const Vector3 b         = Mesh->GetPosition(indices[1]) - ray.Origin;
+	const Vector3 c         = Mesh->GetPosition(indices[2]) - ray.Origin;
+
+	const Real ax = a[ray.Kx] - ray.Sx * a[ray.Kz];
+	const Real ay = a[ray.Ky] - ray.Sy * a[ray.Kz];
+	const Real bx = b[ray.Kx] - ray.Sx * b[ray.Kz];
+	const Real by = b[ray.Ky] - ray.Sy * b[ray.Kz];
+	const Real cx = c[ray.Kx] - ray.Sx * c[ray.Kz];
+	const Real cy = c[ray.Ky] - ray.Sy * c[ray.Kz];
+
+	Real u = cx * by - cy * bx;
+	Real v = ax * cy - ay * cx;
+	Real w = bx * ay - by * ax;
+
+	// An edge function of exactly zero may just be rounding, so recompute those rays in double precision.
+	if constexpr (std::is_same_v<Real, float>) {
+		if (u == 0 || v == 0 || w == 0) {
+			u = static_cast<Real>(double(cx) * double(by) - double(cy) * double(bx));
+			v = static_cast<Real>(double(ax) * double(cy) - double(ay) * double(cx));
+			w = static_cast<Real>(double(bx) * double(ay) - double(by) * double(ax));
+		}
+	}
+
+	if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0)) { return false; }
+
+	const Real det = u + v + w;
+	if (det == 0) { return false; }
+
+	const Real az = ray.Sz * a[ray.Kz];
+	const Real bz = ray.Sz * b[ray.Kz];
+	const Real cz = ray.Sz * c[ray.Kz];
+	const Real t  = (u * az + v * bz + w * cz) / det;
+	if (t <= tMin || t >= tMax) { return false; }
+
+	outT            = t;
+	outBarycentrics = Vector3(u, v, w) / det;
+
+	return true;
+}
+
+void TriangleMesh::Hash(Luna::Utility::Hasher& hasher) const {
+	hasher(_meshHash);
+	HashMaterial(hasher, Material.get());
+}
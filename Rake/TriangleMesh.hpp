@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "IHittable.hpp"
+#include "WideBVH.hpp"
+
+class IMaterial;
+class ITaskPool;
+
+// Vertex data of a triangle mesh, stored as structure-of-arrays in single precision. Positions, normals and UVs are
+// indexed separately, so a mesh can be loaded straight from formats like OBJ without welding vertices. Every triangle
+// has three consecutive entries in each index array; the normal and UV index arrays are empty if the mesh does not
+// have that attribute.
+struct MeshData {
+	size_t GetTriangleCount() const {
+		return PositionIndices.size() / 3;
+	}
+	size_t GetVertexCount() const {
+		return Positions[0].size();
+	}
+	bool HasNormals() const {
+		return !NormalIndices.empty();
+	}
+	bool HasUVs() const {
+		return !UVIndices.empty();
+	}
+
+	Point3 GetPosition(uint32_t index) const {
+		return Point3(Positions[0][index], Positions[1][index], Positions[2][index]);
+	}
+	Vector3 GetNormal(uint32_t index) const {
+		return Vector3(Normals[0][index], Normals[1][index], Normals[2][index]);
+	}
+	Point2 GetUV(uint32_t index) const {
+		return Point2(UVs[0][index], UVs[1][index]);
+	}
+
+	std::array<std::vector<float>, 3> Positions;
+	std::array<std::vector<float>, 3> Normals;
+	std::array<std::vector<float>, 2> UVs;
+	std::vector<uint32_t> PositionIndices;
+	std::vector<uint32_t> NormalIndices;
+	std::vector<uint32_t> UVIndices;
+};
+
+// A whole triangle mesh as a single hittable. The mesh keeps its own BVH over its triangles, so the world BVH only
+// ever sees one object no matter how many triangles there are.
+class TriangleMesh : public IHittable {
+ public:
+	// Large meshes build their BVH much faster given a task pool to build it on.
+	TriangleMesh(const std::shared_ptr<const MeshData>& mesh,
+	             const std::shared_ptr<IMaterial>& material,
+	             ITaskPool* taskPool = nullptr);
+
+	size_t GetTriangleCount() const {
+		return _triangles.size();
+	}
+
+	virtual bool Bounds(AABB& outBounds) const override;
+	virtual bool Hit(const Ray& ray, Real tMin, Real tMax, HitRecord& outRecord) const override;
+	virtual void Hash(Luna::Utility::Hasher& hasher) const override;
+
+	std::shared_ptr<const MeshData> Mesh;
+	std::shared_ptr<IMaterial> Material;
+
+ private:
+	// Ray constants for the watertight intersection test, computed once per ray rather than once per triangle.
+	struct RayTransform {
+		RayTransform(const Ray& ray);
+
+		Point3 Origin;
+		int Kx, Ky, Kz;
+		Real Sx, Sy, Sz;
+	};
+
+	bool IntersectTriangle(
+		const RayTransform& ray, uint32_t triangle, Real tMin, Real tMax, Real& outT, Vector3& outBarycentrics) const;
+
+	WideBVH _bvh;
+	std::vector<uint32_t> _triangles;  // Triangle indices in BVH leaf order.
+	Luna::Utility::Hash _meshHash = 0;
+};
@@ -0,0 +1,144 @@
+#include "WideBVH.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace {
+constexpr int MinExponent = -126;
+constexpr int MaxExponent = 127;
+constexpr float MaxSteps  = 255.0f;
+
+double GetSurfaceArea(const LinearBVHNode& node) {
+	const double x = double(node.Max[0]) - node.Min[0];
+	const double y = double(node.Max[1]) - node.Min[1];
+	const double z = double(node.Max[2]) - node.Min[2];
+
+	return 2.0 * (x * y + y * z + z * x);
+}
+
+// Where a step lands, computed exactly like the traversal does, so rounding cannot make a child any smaller.
+float Dequantize(float origin, float step, uint32_t steps) {
+	return origin + float(steps) * step;
+}
+
+QuantizedWideBVHNode Quantize(const WideBVHNode& node) {
+	QuantizedWideBVHNode quantized = {};
+	quantized.ChildCount           = node.ChildCount;
+	for (uint32_t child = 0; child < node.ChildCount; ++child) {
+		quantized.Offset[child] = node.Offset[child];
+		quantized.Count[child]  = node.Count[child];
+	}
+
+	for (int axis = 0; axis < 3; ++axis) {
+		const float* mins = node.Min[axis];
+		const float* maxs = node.Max[axis];
+		const float lower = *std::min_element(mins, mins + node.ChildCount);
+		const float upper = *std::max_element(maxs, maxs + node.ChildCount);
+
+		// The smallest power of two that spans the node in 255 steps, give or take the rounding of the last one.
+		int exponent        = MinExponent;
+		const double extent = double(upper) - lower;
+		if (extent > 0.0) {
+			std::frexp(extent / MaxSteps, &exponent);
+			exponent = std::max(exponent, MinExponent);
+		}
+		while (exponent < MaxExponent && Dequantize(lower, std::ldexp(1.0f, exponent), 255) < upper) { ++exponent; }
+		const float step = std::ldexp(1.0f, exponent);
+
+		quantized.Origin[axis]   = lower;
+		quantized.Exponent[axis] = int8_t(exponent);
+		for (uint32_t child = 0; child < node.ChildCount; ++child) {
+			uint32_t minSteps = uint32_t(std::clamp(std::floor((mins[child] - lower) / step), 0.0f, MaxSteps));
+			uint32_t maxSteps = uint32_t(std::clamp(std::ceil((maxs[child] - lower) / step), 0.0f, MaxSteps));
+			while (minSteps > 0 && Dequantize(lower, step, minSteps) > mins[child]) { --minSteps; }
+			while (maxSteps < 255 && Dequantize(lower, step, maxSteps) < maxs[child]) { ++maxSteps; }
+			quantized.Min[axis][child] = uint8_t(minSteps);
+			quantized.Max[axis][child] = uint8_t(maxSteps);
+		}
+	}
+
+	return quantized;
+}
+}  // namespace
+
+void WideBVH::Build(std::span<const LinearBVHNode> nodes, bool quantize) {
+	Clear();
+	if (nodes.empty()) { return; }
+
+	const auto& root = nodes[0];
+	_bounds = AABB(Point3(root.Min[0], root.Min[1], root.Min[2]), Point3(root.Max[0], root.Max[1], root.Max[2]));
+
+	// Every wide node replaces at least one binary interior node, apart from the root of a tree that is a single leaf.
+	_nodes.reserve(nodes.size() / 2 + 1);
+	Collapse(nodes, 0);
+
+	if (quantize) {
+		_quantizedNodes.reserve(_nodes.size());
+		for (const auto& node : _nodes) { _quantizedNodes.push_back(Quantize(node)); }
+		_nodes     = {};
+		_quantized = true;
+	} else {
+		_nodes.shrink_to_fit();
+	}
+}
+
+void WideBVH::Clear() {
+	_nodes.clear();
+	_quantizedNodes.clear();
+	_bounds    = AABB();
+	_quantized = false;
+}
+
+uint32_t WideBVH::Collapse(std::span<const LinearBVHNode> nodes, uint32_t nodeIndex) {
+	// Pull the binary subtree up into a single node, opening up the interior child with the largest surface area
+	// until the node is full or only leaves are left. Those are the children most rays would have to visit anyway.
+	std::array<uint32_t, WideBVHWidth> children;
+	uint32_t childCount = 0;
+	if (nodes[nodeIndex].IsLeaf()) {
+		children[childCount++] = nodeIndex;
+	} else {
+		children[childCount++] = nodeIndex + 1;
+		children[childCount++] = nodes[nodeIndex].Offset;
+	}
+
+	while (childCount < WideBVHWidth) {
+		uint32_t largest   = WideBVHWidth;
+		double largestArea = -1.0;
+		for (uint32_t i = 0; i < childCount; ++i) {
+			const auto& child = nodes[children[i]];
+			if (child.IsLeaf()) { continue; }
+
+			const double area = GetSurfaceArea(child);
+			if (area > largestArea) {
+				largest     = i;
+				largestArea = area;
+			}
+		}
+		if (largest == WideBVHWidth) { break; }
+
+		const uint32_t opened  = children[largest];
+		children[largest]      = opened + 1;
+		children[childCount++] = nodes[opened].Offset;
+	}
+
+	const uint32_t wideIndex = static_cast<uint32_t>(_nodes.size());
+	_nodes.emplace_back();
+	_nodes[wideIndex].ChildCount = static_cast<uint8_t>(childCount);
+
+	for (uint32_t i = 0; i < childCount; ++i) {
+		const auto& child = nodes[children[i]];
+		// Collapsing may grow the node array, so the node has to be looked up again afterwards.
+		const uint32_t offset = child.IsLeaf() ? child.Offset : Collapse(nodes, children[i]);
+
+		auto& node     = _nodes[wideIndex];
+		node.Offset[i] = offset;
+		node.Count[i]  = child.Count;
+		for (int axis = 0; axis < 3; ++axis) {
+			node.Min[axis][i] = child.Min[axis];
+			node.Max[axis][i] = child.Max[axis];
+		}
+	}
+
+	return wideIndex;
+}
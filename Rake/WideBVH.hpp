@@ -0,0 +1,214 @@
+#pragma once
+
+#include <Luna/Utility/BitOps.hpp>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "AABB.hpp"
+#include "DataTypes.hpp"
+#include "LinearBVH.hpp"
+#include "Ray.hpp"
+#include "SIMD.hpp"
+
+// Wide nodes hold as many children as there are lanes in a SimdFloat, so a single slab test covers all of them.
+constexpr uint32_t WideBVHWidth = PacketWidth;
+
+// A node of a wide BVH, with the bounds of its children stored lane by lane. Only the first ChildCount lanes are used.
+struct alignas(64) WideBVHNode {
+	float Min[3][WideBVHWidth];
+	float Max[3][WideBVHWidth];
+	uint32_t Offset[WideBVHWidth];  // Leaf: index of the first primitive. Interior: index of the child node.
+	uint16_t Count[WideBVHWidth];   // Number of primitives in a leaf, 0 for interior nodes.
+	uint8_t ChildCount;
+};
+static_assert(sizeof(WideBVHNode) == 32 * WideBVHWidth, "WideBVHNode must take half a cache line per child!");
+
+// The same node with the bounds of its children stored as 8-bit steps across the bounds of the node itself, which makes
+// it a quarter the size. The steps are powers of two, and child bounds are rounded outwards, so they only ever grow.
+struct alignas(64) QuantizedWideBVHNode {
+	float Origin[3];
+	int8_t Exponent[3];  // Each axis is split into steps of 2^Exponent.
+	uint8_t ChildCount;
+	uint8_t Min[3][WideBVHWidth];
+	uint8_t Max[3][WideBVHWidth];
+	uint32_t Offset[WideBVHWidth];
+	uint16_t Count[WideBVHWidth];
+};
+static_assert(sizeof(QuantizedWideBVHNode) == 16 * WideBVHWidth, "QuantizedWideBVHNode must stay tightly packed!");
+
+// A BVH collapsed from a binary LinearBVH into WideBVHWidth-wide nodes, for single rays going every which way. Each
+// step down the tree tests all children of a node at once and visits those the ray enters nearest first, instead of
+// testing one box at a time and guessing the order from the split axis. The primitives keep their leaf order, so the
+// same leaf callbacks work with either tree.
+class WideBVH {
+ public:
+	WideBVH()               = default;
+	WideBVH(const WideBVH&) = delete;
+	WideBVH(WideBVH&&)      = default;
+
+	WideBVH& operator=(const WideBVH&) = delete;
+	WideBVH& operator=(WideBVH&&)      = default;
+
+	// Collapse a binary tree, which is not needed afterwards. A tree that gets refit has to be collapsed again.
+	void Build(std::span<const LinearBVHNode> nodes, bool quantize = false);
+	void Clear();
+
+	AABB GetBounds() const {
+		return _bounds;
+	}
+	size_t GetNodeCount() const {
+		return _quantized ? _quantizedNodes.size() : _nodes.size();
+	}
+	bool IsQuantized() const {
+		return _quantized;
+	}
+
+	// Walk the hierarchy nearest child first. leafFunc(first, count, tMax) is called for every leaf whose bounds the
+	// ray enters, must return true if it recorded a closer hit, and must shrink tMax to the distance of that hit.
+	template <typename LeafFunc>
+	bool Intersect(const Ray& ray, Real tMin, Real tMax, LeafFunc&& leafFunc) const {
+		if (_quantized) { return Traverse<true>(_quantizedNodes, ray, tMin, tMax, leafFunc); }
+
+		return Traverse<true>(_nodes, ray, tMin, tMax, leafFunc);
+	}
+
+	// Walk the hierarchy until leafFunc(first, count) reports any hit at all, in no particular order. Meant for shadow
+	// rays, which only need to know whether something is in the way.
+	template <typename LeafFunc>
+	bool Occluded(const Ray& ray, Real tMin, Real tMax, LeafFunc&& leafFunc) const {
+		const auto AnyHit = [&](uint32_t first, uint32_t count, Real&) { return leafFunc(first, count); };
+		if (_quantized) { return Traverse<false>(_quantizedNodes, ray, tMin, tMax, AnyHit); }
+
+		return Traverse<false>(_nodes, ray, tMin, tMax, AnyHit);
+	}
+
+	// Every level of the binary tree can leave up to WideBVHWidth - 1 children on the stack.
+	static constexpr uint32_t StackSize = LinearBVH::MaxDepth * (WideBVHWidth - 1) + 1;
+
+ private:
+	// The ray broadcast to every lane, along with which side of each slab it enters through.
+	struct TraversalRay {
+		TraversalRay(const Ray& ray) {
+			for (int axis = 0; axis < 3; ++axis) {
+				Origin[axis]       = SimdFloat(float(ray.Origin[axis]));
+				InvDirection[axis] = SimdFloat(float(ray.InvDirection[axis]));
+				Negative[axis]     = ray.InvDirection[axis] < 0;
+			}
+		}
+
+		SimdFloat Origin[3];
+		SimdFloat InvDirection[3];
+		bool Negative[3];
+	};
+
+	struct StackEntry {
+		uint32_t Offset;
+		uint32_t Count;  // 0 for interior nodes, like in the nodes themselves.
+		float Near;      // Where the ray enters the bounds of the entry.
+	};
+
+	uint32_t Collapse(std::span<const LinearBVHNode> nodes, uint32_t nodeIndex);
+
+	// Closest-hit traversal keeps the stack sorted so the nearest child is popped first, and skips anything beyond the
+	// closest hit so far. Any-hit traversal takes the children as they come.
+	template <bool Ordered, typename Node, typename LeafFunc>
+	static bool Traverse(const std::vector<Node>& nodes, const Ray& ray, Real tMin, Real tMax, LeafFunc& leafFunc) {
+		if (nodes.empty()) { return false; }
+
+		const TraversalRay traversalRay(ray);
+		const SimdFloat nearLimit(static_cast<float>(tMin));
+
+		StackEntry stack[StackSize];
+		uint32_t stackSize = 1;
+		stack[0]           = {0, 0, float(tMin)};
+		bool hitAnything   = false;
+
+		while (stackSize > 0) {
+			const StackEntry entry = stack[--stackSize];
+			if (Ordered && entry.Near > float(tMax)) { continue; }
+			if (entry.Count > 0) {
+				if (leafFunc(entry.Offset, entry.Count, tMax)) {
+					if (!Ordered) { return true; }
+					hitAnything = true;
+				}
+				continue;
+			}
+
+			const Node& node = nodes[entry.Offset];
+			float nearDistances[WideBVHWidth];
+			const uint32_t hitMask = IntersectChildren(node, traversalRay, nearLimit, float(tMax), nearDistances);
+
+			const uint32_t first = stackSize;
+			Luna::Utility::ForEachBit(hitMask, [&](uint32_t child) {
+				const StackEntry childEntry = {node.Offset[child], node.Count[child], nearDistances[child]};
+				uint32_t i                  = stackSize++;
+				if (Ordered) {
+					for (; i > first && stack[i - 1].Near < childEntry.Near; --i) { stack[i] = stack[i - 1]; }
+				}
+				stack[i] = childEntry;
+			});
+		}
+
+		return hitAnything;
+	}
+
+	// Slab test against every child at once. Returns the mask of children the ray enters between tMin and tMax, and
+	// where it enters each of them. A ray parallel to a slab and starting right on its plane gives NaN, which Min and
+	// Max pass over by returning their second argument, so the slab is ignored and the ray counts as entering the
+	// child. The SSE, AVX2 and plain C++ versions all do this (see RakeTests slab).
+	static uint32_t IntersectChildren(const WideBVHNode& node,
+	                                  const TraversalRay& ray,
+	                                  const SimdFloat& tMin,
+	                                  float tMax,
+	                                  float outNear[WideBVHWidth]) {
+		SimdFloat tNear = tMin;
+		SimdFloat tFar(tMax);
+		for (int axis = 0; axis < 3; ++axis) {
+			const float* nearPlanes = ray.Negative[axis] ? node.Max[axis] : node.Min[axis];
+			const float* farPlanes  = ray.Negative[axis] ? node.Min[axis] : node.Max[axis];
+			const SimdFloat t0      = (SimdFloat::Load(nearPlanes) - ray.Origin[axis]) * ray.InvDirection[axis];
+			const SimdFloat t1      = (SimdFloat::Load(farPlanes) - ray.Origin[axis]) * ray.InvDirection[axis];
+			tNear                   = Max(t0, tNear);
+			tFar                    = Min(t1, tFar);
+		}
+		tNear.Store(outNear);
+
+		return (tNear <= tFar).Bits() & ((1u << node.ChildCount) - 1);
+	}
+
+	static uint32_t IntersectChildren(const QuantizedWideBVHNode& node,
+	                                  const TraversalRay& ray,
+	                                  const SimdFloat& tMin,
+	                                  float tMax,
+	                                  float outNear[WideBVHWidth]) {
+		SimdFloat tNear = tMin;
+		SimdFloat tFar(tMax);
+		for (int axis = 0; axis < 3; ++axis) {
+			const uint8_t* nearSteps = ray.Negative[axis] ? node.Max[axis] : node.Min[axis];
+			const uint8_t* farSteps  = ray.Negative[axis] ? node.Min[axis] : node.Max[axis];
+			const SimdFloat origin(node.Origin[axis]);
+			const SimdFloat step(GetStep(node.Exponent[axis]));
+			const SimdFloat nearPlanes = origin + SimdFloat::LoadBytes(nearSteps) * step;
+			const SimdFloat farPlanes  = origin + SimdFloat::LoadBytes(farSteps) * step;
+			const SimdFloat t0         = (nearPlanes - ray.Origin[axis]) * ray.InvDirection[axis];
+			const SimdFloat t1         = (farPlanes - ray.Origin[axis]) * ray.InvDirection[axis];
+			tNear                      = Max(t0, tNear);
+			tFar                       = Min(t1, tFar);
+		}
+		tNear.Store(outNear);
+
+		return (tNear <= tFar).Bits() & ((1u << node.ChildCount) - 1);
+	}
+
+	// 2^exponent, put together straight from its bits. Exponents are kept within the range of normal floats.
+	static float GetStep(int8_t exponent) {
+		return std::bit_cast<float>(uint32_t(exponent + 127) << 23);
+	}
+
+	std::vector<WideBVHNode> _nodes;
+	std::vector<QuantizedWideBVHNode> _quantizedNodes;
+	AABB _bounds;
+	bool _quantized = false;
+};
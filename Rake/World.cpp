@@ -0,0 +1,87 @@
+#include "World.hpp"
+
+#include <Luna/Utility/Hash.hpp>
+#include <chrono>
+
+#include "IMaterial.hpp"
+#include "ISkyMaterial.hpp"
+
+void World::ConstructBVH(ITaskPool* taskPool) {
+	BVH                = std::make_shared<HittableBVH>(*this, taskPool);
+	Emitters.Build(*this);
+	_bvhPrimitiveCount = GetPrimitiveCount();
+	_change            = GeometryChange::None;
+	++_generation;
+}
+
+BVHUpdate World::UpdateBVH(ITaskPool* taskPool) {
+	// Primitives added without telling us still change their count.
+	if (!BVH || GetPrimitiveCount() != _bvhPrimitiveCount) { _change = GeometryChange::Changed; }
+	if (_change == GeometryChange::Changed) {
+		ConstructBVH(taskPool);
+		return BVHUpdate::Rebuild;
+	}
+
+	BVHUpdate result = BVHUpdate::None;
+
+	// A finished background build started from the bounds primitives had back then, so it needs a refit of its own.
+	if (_pendingBVH.valid() && _pendingBVH.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		auto rebuilt = _pendingBVH.get();
+		if (_pendingGeneration == _generation) {
+			BVH     = std::move(rebuilt);
+			_change = GeometryChange::Moved;
+			result  = BVHUpdate::SwapRebuilt;
+		}
+	}
+
+	if (_change == GeometryChange::Moved) {
+		BVH->Refit();
+		if (result == BVHUpdate::None) { result = BVHUpdate::Refit; }
+	}
+	_change = GeometryChange::None;
+
+	if (RebuildThreshold > 0.0 && !_pendingBVH.valid() && BVH->GetCostRatio() > RebuildThreshold) {
+		std::vector<PrimitiveID> primitives;
+		std::vector<AABB> bounds;
+		HittableBVH::GatherPrimitives(*this, primitives, bounds);
+		_pendingGeneration = _generation;
+		_pendingBVH        = std::async(std::launch::async,
+		                                [this, primitives = std::move(primitives), bounds = std::move(bounds)]() {
+			                                return std::make_shared<HittableBVH>(*this, primitives, bounds);
+		                                });
+	}
+
+	return result;
+}
+
+uint64_t World::GetHash() const {
+	Luna::Utility::Hasher hasher;
+	hasher.Data(Name.size(), Name.data());
+	hasher.Data(sizeof(CameraPos), &CameraPos);
+	hasher.Data(sizeof(CameraTarget), &CameraTarget);
+	for (const Real value : {VerticalFOV, CameraAperture, CameraFocusDistance}) { hasher.Data(sizeof(value), &value); }
+
+	// Every array of the pools goes in as it is. Materials are hashed in table order and primitives refer to them by
+	// index, so swapping the materials of two primitives changes the hash as well as changing a material.
+	const auto HashArray = [&hasher](const auto& values) {
+		hasher(values.size());
+		hasher.Data(values.size() * sizeof(values[0]), values.data());
+	};
+	HashArray(Spheres.CenterX);
+	HashArray(Spheres.CenterY);
+	HashArray(Spheres.CenterZ);
+	HashArray(Spheres.Radius);
+	HashArray(Spheres.Material);
+	HashArray(Rectangles.Plane);
+	HashArray(Rectangles.Min);
+	HashArray(Rectangles.Max);
+	HashArray(Rectangles.Offset);
+	HashArray(Rectangles.Material);
+	hasher(Materials.Size());
+	for (uint32_t i = 0; i < Materials.Size(); ++i) { HashMaterial(hasher, Materials.Get(i)); }
+	Objects.Hash(hasher);
+	hasher(Sky != nullptr);
+	if (Sky) { Sky->Hash(hasher); }
+
+	return hasher.Get();
+}
@@ -1,27 +1,97 @@
 #pragma once
 
+#include <cstdint>
+#include <future>
 #include <memory>
 #include <string>
 
-#include "BVHNode.hpp"
+#include "EmitterList.hpp"
+#include "HittableBVH.hpp"
 #include "HittableList.hpp"
+#include "PrimitivePool.hpp"
 
+class IMaterial;
 class ISkyMaterial;
+class ITaskPool;
+
+// How the geometry of a world changed since its BVH was last brought up to date.
+enum class GeometryChange : uint8_t { None, Moved, Changed };
+
+// What World::UpdateBVH had to do to bring the BVH up to date.
+enum class BVHUpdate { None, Refit, Rebuild, SwapRebuilt };
 
 struct World {
 	World(const std::string& name) : Name(name) {}
+	// The BVH refers to the primitives of the world it was built for, so worlds stay where they are.
+	World(const World&)            = delete;
+	World& operator=(const World&) = delete;
 
-	void ConstructBVH() {
-		BVH = std::make_shared<BVHNode>(Objects);
+	// Spheres and rectangles go into pools rather than becoming objects of their own. Their materials are kept in
+	// Materials, once each no matter how many primitives use them.
+	uint32_t AddSphere(const Point3& center, Real radius, const std::shared_ptr<IMaterial>& material) {
+		return Spheres.Add(center, radius, Materials.Add(material));
+	}
+	uint32_t AddRectangle(RectanglePlane plane,
+	                      const Point2& min,
+	                      const Point2& max,
+	                      Real offset,
+	                      const std::shared_ptr<IMaterial>& material) {
+		return Rectangles.Add(plane, min, max, offset, Materials.Add(material));
+	}
+	uint32_t AddPlane(RectanglePlane plane, Real offset, const std::shared_ptr<IMaterial>& material) {
+		return Rectangles.AddPlane(plane, offset, Materials.Add(material));
+	}
+	size_t GetPrimitiveCount() const {
+		return Spheres.Size() + Rectangles.Size() + Objects.Objects.size();
 	}
 
+	// Primitives moved, but none were added, removed or replaced. The BVH keeps its structure and only gets refit.
+	void MarkMoved() {
+		if (_change == GeometryChange::None) { _change = GeometryChange::Moved; }
+	}
+	// Primitives were added, removed or replaced, so the BVH has to be rebuilt.
+	void MarkChanged() {
+		_change = GeometryChange::Changed;
+	}
+
+	// Rebuild the top-level BVH over the pooled primitives and Objects, along with the list of emitters. Objects with a
+	// BVH of their own, such as meshes and the objects behind instances, keep theirs, so this only costs as much as the
+	// number of primitives.
+	void ConstructBVH(ITaskPool* taskPool = nullptr);
+
+	// Do the least amount of work that brings the BVH up to date with the primitives: nothing if only the camera
+	// changed, a refit if primitives moved, and a rebuild if primitives were added or removed. Once refits have made
+	// the tree worse than RebuildThreshold times its original cost, a fresh tree is built in the background from the
+	// bounds the primitives had at the time, and swapped in by a later update. The task pool, if any, is only used for
+	// rebuilds that have to finish before this returns.
+	BVHUpdate UpdateBVH(ITaskPool* taskPool = nullptr);
+	bool IsRebuildPending() const {
+		return _pendingBVH.valid();
+	}
+
+	// Hash of the world's name, camera, the geometry and material of every primitive and the sky, enough to tell whether
+	// a checkpoint was traced from this world.
+	uint64_t GetHash() const;
+
 	std::string Name;
-	HittableList Objects;
-	std::shared_ptr<IHittable> BVH;
-	double VerticalFOV         = 90.0f;
-	Point3 CameraPos           = Point3(0.0);
-	Point3 CameraTarget        = Point3(0.0, 0.0, -1.0);
-	double CameraAperture      = 0.01;
-	double CameraFocusDistance = 100.0;
+	SpherePool Spheres;
+	RectanglePool Rectangles;
+	HittableList Objects;  // Everything that is not pooled, such as meshes and instances.
+	MaterialTable Materials;
+	std::shared_ptr<HittableBVH> BVH;
+	EmitterList Emitters;
+	Real VerticalFOV         = 90.0f;
+	Point3 CameraPos         = Point3(0.0);
+	Point3 CameraTarget      = Point3(0.0, 0.0, -1.0);
+	Real CameraAperture      = 0.01;
+	Real CameraFocusDistance = 100.0;
 	std::shared_ptr<ISkyMaterial> Sky;
+	double RebuildThreshold  = 1.5;  // 0 disables background rebuilds.
+
+ private:
+	GeometryChange _change      = GeometryChange::Changed;
+	size_t _bvhPrimitiveCount   = 0;
+	uint64_t _generation        = 0;  // Bumped by every rebuild, so stale background builds can be recognized.
+	uint64_t _pendingGeneration = 0;
+	std::future<std::shared_ptr<HittableBVH>> _pendingBVH;
 };